@@ -22,11 +22,9 @@ extern "C" void* algInit2 (void*, const std::string&                 );
 extern "C" bool  algStart (void*                                     );
 extern "C" std::shared_ptr<TsJsonObject> 
                  algProc  (void*, const std::shared_ptr<TsGstSample>&);
-/*
 extern "C" std::shared_ptr<std::vector<std::shared_ptr<TsJsonObject>>> 
                  algProc2 (void*, const std::shared_ptr<std::vector<
                            std::shared_ptr<TsGstSample>>>&           );
-			   */
 extern "C" bool  algCtrl  (void*, const std::string&                 );
 extern "C" void  algStop  (void*                                     );
 extern "C" void  algFina  (void*                                     );
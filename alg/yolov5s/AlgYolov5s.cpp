@@ -19,6 +19,8 @@
 #include <algorithm>
 #include <fstream>
 
+#include <gst/video/video.h>
+
 #include "YOLOv5s.h"
 #include "AlgInterface.h"
 
@@ -106,6 +108,89 @@ static bool parse_args(AlgConfig& config, const std::string& data)
                     config.modelConfig.runtime = device2runtime(r);
                 }
 
+                if (json_object_has_member(m, "runtimes")) {
+                    JsonArray* a = json_object_get_array_member(m, "runtimes");
+                    for (guint i = 0; i < json_array_get_length(a); i++) {
+                        std::string r((const char*)json_array_get_string_element(a, i));
+                        TS_INFO_MSG_V("\truntimes[%u]:%s", i, r.c_str());
+                        config.modelConfig.runtimes.push_back(device2runtime(r));
+                    }
+                }
+
+                if (json_object_has_member(m, "init-cache-dir")) {
+                    std::string d((const char*)json_object_get_string_member(m, "init-cache-dir"));
+                    TS_INFO_MSG_V("\tinit-cache-dir:%s", d.c_str());
+                    config.modelConfig.initCacheDir = d;
+                }
+
+                if (json_object_has_member(m, "balance-runtimes")) {
+                    gboolean b = json_object_get_boolean_member(m, "balance-runtimes");
+                    TS_INFO_MSG_V("\tbalance-runtimes:%d", b);
+                    config.modelConfig.balanceRuntimes = b;
+                }
+
+                if (json_object_has_member(m, "balance-floor-share")) {
+                    gdouble f = json_object_get_double_member(m, "balance-floor-share");
+                    TS_INFO_MSG_V("\tbalance-floor-share:%f", f);
+                    config.modelConfig.balanceFloorShare = (float)f;
+                }
+
+                if (json_object_has_member(m, "performance-profile")) {
+                    std::string r((const char*)json_object_get_string_member(m, "performance-profile"));
+                    TS_INFO_MSG_V("\tperformance-profile:%s", r.c_str());
+                    if (!ParsePerformanceProfile(r, config.modelConfig.performanceProfile)) {
+                        TS_WARN_MSG_V("Unknown performance-profile %s, keep burst", r.c_str());
+                    }
+                }
+
+                if (json_object_has_member(m, "execution-priority")) {
+                    std::string r((const char*)json_object_get_string_member(m, "execution-priority"));
+                    TS_INFO_MSG_V("\texecution-priority:%s", r.c_str());
+                    config.modelConfig.executionPriority = ParseExecutionPriority(r);
+                }
+
+                if (json_object_has_member(m, "cpu-fixed-point")) {
+                    gboolean b = json_object_get_boolean_member(m, "cpu-fixed-point");
+                    TS_INFO_MSG_V("\tcpu-fixed-point:%d", b);
+                    config.modelConfig.cpuFixedPoint = b;
+                }
+
+                if (json_object_has_member(m, "stage-profiling")) {
+                    gboolean b = json_object_get_boolean_member(m, "stage-profiling");
+                    TS_INFO_MSG_V("\tstage-profiling:%d", b);
+                    config.modelConfig.stageProfiling = b;
+                }
+
+                if (json_object_has_member(m, "profile-dump-interval-ms")) {
+                    int x = json_object_get_int_member(m, "profile-dump-interval-ms");
+                    TS_INFO_MSG_V("\tprofile-dump-interval-ms:%d", x);
+                    config.modelConfig.profileDumpInterval_ms = x;
+                }
+
+                if (json_object_has_member(m, "profile-csv")) {
+                    std::string r((const char*)json_object_get_string_member(m, "profile-csv"));
+                    TS_INFO_MSG_V("\tprofile-csv:%s", r.c_str());
+                    config.modelConfig.profileCsv = r;
+                }
+
+                if (json_object_has_member(m, "profiling-level")) {
+                    std::string r((const char*)json_object_get_string_member(m, "profiling-level"));
+                    TS_INFO_MSG_V("\tprofiling-level:%s", r.c_str());
+                    config.modelConfig.profilingLevel = ParseProfilingLevel(r);
+                }
+
+                if (json_object_has_member(m, "diag-log-dir")) {
+                    std::string r((const char*)json_object_get_string_member(m, "diag-log-dir"));
+                    TS_INFO_MSG_V("\tdiag-log-dir:%s", r.c_str());
+                    config.modelConfig.diagLogDir = r;
+                }
+
+                if (json_object_has_member(m, "buffer-encoding")) {
+                    std::string e((const char*)json_object_get_string_member(m, "buffer-encoding"));
+                    TS_INFO_MSG_V("\tbuffer-encoding:%s", e.c_str());
+                    config.modelConfig.bufferEncoding = (0 == e.compare("tf8")) ? USERBUFFER_TF8 : USERBUFFER_FLOAT;
+                }
+
                 if (json_object_has_member(m, "labels")) {
                     int x = json_object_get_int_member(m, "labels");
                     TS_INFO_MSG_V("\tlabels:%d", x);
@@ -118,6 +203,12 @@ static bool parse_args(AlgConfig& config, const std::string& data)
                     config.modelConfig.grids = x;
                 }
 
+                if (json_object_has_member(m, "batch-size")) {
+                    int x = json_object_get_int_member(m, "batch-size");
+                    TS_INFO_MSG_V("\tbatch-size:%d", x);
+                    config.modelConfig.batchSize = x;
+                }
+
                 if (json_object_has_member(m, "label-path")) {
                     std::string r((const char*)json_object_get_string_member(m, "label-path"));
                     TS_INFO_MSG_V("\tlabel-path:%s", r.c_str());
@@ -155,6 +246,30 @@ static bool parse_args(AlgConfig& config, const std::string& data)
                 config.nmsThresh = (float)n;
             }
 
+            if (json_object_has_member(object, "nms-method")) {
+                std::string n((const char*)json_object_get_string_member(object, "nms-method"));
+                TS_INFO_MSG_V("\tnms-method:%s", n.c_str());
+                config.modelConfig.nms.method = yolov5::ParseNMSMethod(n);
+            }
+
+            if (json_object_has_member(object, "nms-class-aware")) {
+                gboolean c = json_object_get_boolean_member(object, "nms-class-aware");
+                TS_INFO_MSG_V("\tnms-class-aware:%d", c);
+                config.modelConfig.nms.classAware = c;
+            }
+
+            if (json_object_has_member(object, "nms-max-candidates")) {
+                int x = json_object_get_int_member(object, "nms-max-candidates");
+                TS_INFO_MSG_V("\tnms-max-candidates:%d", x);
+                config.modelConfig.nms.maxCandidates = x;
+            }
+
+            if (json_object_has_member(object, "nms-sigma")) {
+                gdouble s = json_object_get_double_member(object, "nms-sigma");
+                TS_INFO_MSG_V("\tnms-sigma:%f", s);
+                config.modelConfig.nms.sigma = (float)s;
+            }
+
             if (json_object_has_member(object, "conf-thresh")) {
                 gdouble c = json_object_get_double_member(object, "conf-thresh");
                 TS_INFO_MSG_V("\tconf-thresh:%f", c);
@@ -329,6 +444,46 @@ bool algStart(void* alg)
     return TRUE;
 }
 
+//
+// map_yuv_frame: planes of a NV12/I420 sample, the buffer stays mapped into map
+//
+static bool map_yuv_frame(GstSample* sample, GstMapInfo& map, yolov5::YUVImage& image)
+{
+    GstVideoInfo info;
+    GstCaps* caps = gst_sample_get_caps(sample);
+    if (!caps || !gst_video_info_from_caps(&info, caps)) {
+        TS_ERR_MSG_V("Invalid caps of the sample");
+        return false;
+    }
+    if (GST_VIDEO_INFO_FORMAT(&info) != GST_VIDEO_FORMAT_NV12 &&
+        GST_VIDEO_INFO_FORMAT(&info) != GST_VIDEO_FORMAT_I420) {
+        return false;
+    }
+
+    GstBuffer* buf = gst_sample_get_buffer(sample);
+    if (!buf || !gst_buffer_map(buf, &map, GST_MAP_READ)) {
+        TS_ERR_MSG_V("Failed to map the sample buffer");
+        return false;
+    }
+
+    // Padded planes come with a video meta.
+    GstVideoMeta* meta = gst_buffer_get_video_meta(buf);
+    for (guint i = 0; i < GST_VIDEO_INFO_N_PLANES(&info); i++) {
+        image.planes[i] = map.data + (meta ? meta->offset[i] : GST_VIDEO_INFO_PLANE_OFFSET(&info, i));
+        image.strides[i] = meta ? meta->stride[i] : GST_VIDEO_INFO_PLANE_STRIDE(&info, i);
+    }
+    image.format = GST_VIDEO_INFO_FORMAT(&info) == GST_VIDEO_FORMAT_NV12 ?
+        PIXEL_FORMAT_NV12 : PIXEL_FORMAT_I420;
+    image.width = GST_VIDEO_INFO_WIDTH(&info);
+    image.height = GST_VIDEO_INFO_HEIGHT(&info);
+    return true;
+}
+
+static bool is_yuv_format(const std::string& format)
+{
+    return 0 == format.compare("NV12") || 0 == format.compare("I420");
+}
+
 //
 // algProc
 //
@@ -348,20 +503,33 @@ std::shared_ptr<TsJsonObject> algProc(
     gst_structure_get_int(structure, "height", &height);
     std::string format((char*)gst_structure_get_string(
         structure, "format"));
-    if (0 != format.compare("RGB")) {
-        TS_ERR_MSG_V("Invalid format(%s!=RGB)", format.c_str());
+    if (0 != format.compare("RGB") && !is_yuv_format(format)) {
+        TS_ERR_MSG_V("Invalid format(%s!=RGB/NV12/I420)", format.c_str());
         gst_sample_unref(sample);
         return NULL;
     }
 
+    // The frame is read in place, keep it mapped until Detect() returns.
     GstMapInfo map;
     GstBuffer* buf = gst_sample_get_buffer(sample);
-    gst_buffer_map(buf, &map, GST_MAP_READ);
-    cv::Mat image(height, width, CV_8UC3, map.data);
+    std::vector<yolov5::ObjectData> results;
+    bool ret = false;
+    if (is_yuv_format(format)) {
+        // NV12/I420 straight from the decoder, converted at the model size only.
+        yolov5::YUVImage image;
+        if (!map_yuv_frame(sample, map, image)) {
+            gst_sample_unref(sample);
+            return NULL;
+        }
+        ret = a->alg_->Detect(image, results);
+    } else {
+        gst_buffer_map(buf, &map, GST_MAP_READ);
+        cv::Mat image(height, width, CV_8UC3, map.data);
+        ret = a->alg_->Detect(image, results);
+    }
     gst_buffer_unmap(buf, &map);
 
-    std::vector<yolov5::ObjectData> results;
-    if (!a->alg_->Detect(image, results)) {
+    if (!ret) {
         TS_WARN_MSG_V("Failed to detect face in the image");
         //return NULL;
     }
@@ -375,6 +543,87 @@ std::shared_ptr<TsJsonObject> algProc(
     return jo;
 }
 
+//
+// algProc2
+//
+std::shared_ptr<std::vector<std::shared_ptr<TsJsonObject>>> algProc2(
+    void* alg, const std::shared_ptr<std::vector<std::shared_ptr<TsGstSample>>>& datas)
+{
+    AlgCore* a = static_cast<AlgCore*>(alg);
+
+    //TS_INFO_MSG_V("algProc2 called");
+
+    std::vector<cv::Mat> images;
+    std::vector<std::pair<GstBuffer*, GstMapInfo>> maps;
+    std::vector<size_t> indexs;
+    // NV12/I420 frames skip the batch, results by index of datas
+    std::vector<std::pair<size_t, std::vector<yolov5::ObjectData>>> yuvResults;
+
+    for (size_t i = 0; i < datas->size(); i++) {
+        GstSample* sample = (*datas)[i]->GetSample();
+
+        gint width, height;
+        GstCaps* caps = gst_sample_get_caps(sample);
+        GstStructure* structure = gst_caps_get_structure(caps, 0);
+        gst_structure_get_int(structure, "width", &width);
+        gst_structure_get_int(structure, "height", &height);
+        std::string format((char*)gst_structure_get_string(
+            structure, "format"));
+        if (is_yuv_format(format)) {
+            GstMapInfo map;
+            yolov5::YUVImage image;
+            if (!map_yuv_frame(sample, map, image)) continue;
+            yuvResults.emplace_back(i, std::vector<yolov5::ObjectData>());
+            if (!a->alg_->Detect(image, yuvResults.back().second)) {
+                TS_WARN_MSG_V("Failed to detect objects in frame %zu", i);
+            }
+            gst_buffer_unmap(gst_sample_get_buffer(sample), &map);
+            continue;
+        }
+        if (0 != format.compare("RGB")) {
+            TS_ERR_MSG_V("Invalid format(%s!=RGB/NV12/I420)", format.c_str());
+            continue;
+        }
+
+        // keep the buffers mapped until the whole batch is detected.
+        GstMapInfo map;
+        GstBuffer* buf = gst_sample_get_buffer(sample);
+        gst_buffer_map(buf, &map, GST_MAP_READ);
+        maps.emplace_back(buf, map);
+        images.emplace_back(height, width, CV_8UC3, map.data);
+        indexs.push_back(i);
+    }
+
+    std::vector<std::vector<yolov5::ObjectData>> results;
+    if (!images.empty() && !a->alg_->DetectBatch(images, results)) {
+        TS_WARN_MSG_V("Failed to detect objects in the batch");
+    }
+
+    for (auto& m : maps) {
+        gst_buffer_unmap(m.first, &m.second);
+    }
+
+    auto jos = std::make_shared<std::vector<std::shared_ptr<TsJsonObject>>>(datas->size());
+    for (size_t i = 0; i < results.size(); i++) {
+        std::shared_ptr<TsJsonObject> jo = std::make_shared<
+            TsJsonObject>(results_to_json_object(results[i], a));
+        results_to_osd_object(results[i], jo->GetOsdObject(), a);
+        jo->SetLevel(TsJsonObject::Level::WARNING);
+        jo->SetSnapPicture(true);
+        (*jos)[indexs[i]] = jo;
+    }
+    for (auto& yuv : yuvResults) {
+        std::shared_ptr<TsJsonObject> jo = std::make_shared<
+            TsJsonObject>(results_to_json_object(yuv.second, a));
+        results_to_osd_object(yuv.second, jo->GetOsdObject(), a);
+        jo->SetLevel(TsJsonObject::Level::WARNING);
+        jo->SetSnapPicture(true);
+        (*jos)[yuv.first] = jo;
+    }
+
+    return jos;
+}
+
 //
 // algCtrl
 //
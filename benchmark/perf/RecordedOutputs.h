@@ -0,0 +1,81 @@
+/*
+ * @Description: Recorded yolov5s output tensors used by the benchmarks, no SNPE needed.
+ * @version: 1.0
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 11:40:52
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 11:40:52
+ */
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Set YOLOV5S_RECORDED_OUTPUTS to a Result_N directory written by snpe-net-run
+ * (see benchmark/yolov5s) to replay real tensors: output.raw, 329.raw, 331.raw.
+ * Without it, tensors of the same shape are synthesized with ~0.3% of the
+ * anchors holding an object, which is close to a typical street scene.
+ */
+
+struct RecordedLayer {
+    std::string name;
+    int height;
+    int width;
+    int channel;
+    std::vector<float> data;
+};
+
+static bool LoadRawLayer(const std::string& path, RecordedLayer& layer)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    layer.data.resize((size_t)layer.height * layer.width * layer.channel);
+    in.read(reinterpret_cast<char*>(layer.data.data()), layer.data.size() * sizeof(float));
+    return (size_t)in.gcount() == layer.data.size() * sizeof(float);
+}
+
+static void SynthesizeLayer(RecordedLayer& layer, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    const int step = layer.channel / 3;
+
+    layer.data.resize((size_t)layer.height * layer.width * layer.channel);
+    for (size_t anchor = 0; anchor < layer.data.size() / step; anchor++) {
+        float* p = layer.data.data() + anchor * step;
+        float dice = uniform(rng);
+        p[0] = uniform(rng);
+        p[1] = uniform(rng);
+        p[2] = 0.2f + 0.6f * uniform(rng);
+        p[3] = 0.2f + 0.6f * uniform(rng);
+        // 0.3% objects, 3% weak responses, background for the rest.
+        p[4] = dice < 0.003f ? 0.5f + 0.5f * uniform(rng) :
+               dice < 0.033f ? 0.001f + 0.2f * uniform(rng) : 0.001f * uniform(rng);
+        for (int m = 5; m < step; m++) {
+            p[m] = 0.05f * uniform(rng);
+        }
+        p[5 + (int)(uniform(rng) * (step - 5)) % (step - 5)] = 0.5f + 0.5f * uniform(rng);
+    }
+}
+
+static std::vector<RecordedLayer> LoadRecordedOutputs()
+{
+    std::vector<RecordedLayer> layers = {
+        {"output", 80, 80, 255, {}},
+        {"329",    40, 40, 255, {}},
+        {"331",    20, 20, 255, {}},
+    };
+
+    const char* dir = std::getenv("YOLOV5S_RECORDED_OUTPUTS");
+    for (size_t i = 0; i < layers.size(); i++) {
+        if (dir && LoadRawLayer(std::string(dir) + "/" + layers[i].name + ".raw", layers[i])) continue;
+        SynthesizeLayer(layers[i], 1202 + i);
+    }
+
+    return layers;
+}
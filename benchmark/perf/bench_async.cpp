@@ -0,0 +1,68 @@
+/*
+ * @Description: Micro benchmark of the async pipeline with a mock executor that sleeps.
+ * @version: 1.0
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 16:42:05
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 16:42:05
+ */
+
+#include <vector>
+#include <future>
+#include <memory>
+#include <thread>
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+
+#include "AsyncPipeline.h"
+
+// Stage costs of a DSP run: pre-process 4 ms, execute 8 ms, post-process 3 ms.
+static void Sleep(int ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static constexpr int kFrames = 32;
+
+struct MockJob {
+    int frame;
+    std::promise<int> promise;
+};
+
+static void BM_DetectSerial(benchmark::State& state)
+{
+    for (auto _ : state) {
+        for (int i = 0; i < kFrames; i++) {
+            Sleep(4);
+            Sleep(8);
+            Sleep(3);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kFrames);
+}
+
+// state.range(0) slots, i.e. SNPE buffer sets.
+static void BM_DetectAsync(benchmark::State& state)
+{
+    yolov5::AsyncPipeline<std::shared_ptr<MockJob>> pipeline(state.range(0),
+        [](std::shared_ptr<MockJob>&, size_t) { Sleep(4); return true; },
+        [](std::shared_ptr<MockJob>&, size_t) { Sleep(8); return true; },
+        [](std::shared_ptr<MockJob>& job, size_t, bool) { Sleep(3); job->promise.set_value(job->frame); });
+
+    std::vector<std::future<int>> futures(kFrames);
+    for (auto _ : state) {
+        // Submit blocks once the slots are busy, like DetectAsync() on a fast source.
+        for (int i = 0; i < kFrames; i++) {
+            std::shared_ptr<MockJob> job = std::make_shared<MockJob>();
+            job->frame = i;
+            futures[i] = job->promise.get_future();
+            pipeline.Submit(job);
+        }
+        for (auto& f : futures) benchmark::DoNotOptimize(f.get());
+    }
+    state.SetItemsProcessed(state.iterations() * kFrames);
+}
+
+BENCHMARK(BM_DetectSerial)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DetectAsync)->Arg(1)->Arg(2)->Arg(3)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,139 @@
+/*
+ * @Description: Routing of frames across runtimes, simulated latencies on a virtual clock.
+ * @version: 1.1
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 18:31:52
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 18:31:52
+ */
+
+#include <vector>
+#include <algorithm>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include "RuntimeBalancer.h"
+
+static constexpr int kFrames = 20000;
+
+// DSP, GPU and CPU replicas of the same model, ms per frame.
+static const std::vector<double> kLatencies = {8.0, 20.0, 120.0};
+
+struct SimResult {
+    double mean_ms = 0.0;
+    double p99_ms = 0.0;
+    std::vector<double> shares;
+};
+
+/*
+ * Frames arrive every interval_ms, each replica serves its queue in order with
+ * a +-20% jitter around its latency. balanced == false models the first free
+ * replica policy: a frame goes wherever it can start first.
+ */
+static SimResult Simulate(double interval_ms, bool balanced, double floorShare)
+{
+    const size_t n = kLatencies.size();
+    snpetask::BalancerConfig config;
+    config.floorShare = floorShare;
+    snpetask::RuntimeBalancer balancer(n, config);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> jitter(0.8, 1.2);
+
+    // Replica free time, and the frames each replica still has to finish: (end, latency)
+    std::vector<double> freeAt(n, 0.0);
+    std::vector<std::vector<std::pair<double, double>>> running(n);
+    std::vector<double> latencies;
+    std::vector<int> picks(n, 0);
+    latencies.reserve(kFrames);
+
+    for (int f = 0; f < kFrames; f++) {
+        double now = f * interval_ms;
+
+        // Report what completed before this arrival.
+        for (size_t i = 0; i < n; i++) {
+            auto& queue = running[i];
+            while (!queue.empty() && queue.front().first <= now) {
+                balancer.End(i, queue.front().second);
+                queue.erase(queue.begin());
+            }
+        }
+
+        size_t pick = 0;
+        if (balanced) {
+            pick = balancer.Pick();
+        } else {
+            for (size_t i = 1; i < n; i++) {
+                if (std::max(now, freeAt[i]) < std::max(now, freeAt[pick])) pick = i;
+            }
+        }
+        balancer.Begin(pick);
+        picks[pick]++;
+
+        double service = kLatencies[pick] * jitter(rng);
+        double start = std::max(now, freeAt[pick]);
+        freeAt[pick] = start + service;
+        running[pick].emplace_back(freeAt[pick], service);
+        latencies.push_back(freeAt[pick] - now);
+    }
+
+    SimResult result;
+    for (double l : latencies) result.mean_ms += l;
+    result.mean_ms /= latencies.size();
+    std::sort(latencies.begin(), latencies.end());
+    result.p99_ms = latencies[latencies.size() * 99 / 100];
+    for (size_t i = 0; i < n; i++) result.shares.push_back((double)picks[i] / kFrames);
+    return result;
+}
+
+// state.range(0): frame interval in 0.1 ms, 60 is 166 fps which the DSP alone can't keep.
+// state.range(1): floor share in 0.1%. Probes of the slow replicas land in the tail, the
+// sum of their floor shares has to stay under 1% to leave p99 alone.
+static void RunPolicy(benchmark::State& state, bool balanced)
+{
+    double interval_ms = state.range(0) / 10.0;
+    double floorShare = state.range(1) / 1000.0;
+
+    // Same workload on both policies: routing by completion time must not lose the tail,
+    // 1% off for the few frames the probes move, and the probes must give every replica
+    // the floor share, give or take the ones skipped while it was busy.
+    if (balanced) {
+        SimResult firstFree = Simulate(interval_ms, false, 0.0);
+        SimResult check = Simulate(interval_ms, true, floorShare);
+        if (check.p99_ms > 1.01 * firstFree.p99_ms) {
+            state.SkipWithError("Balanced p99 latency worse than first free");
+            return;
+        }
+        for (double share : check.shares) {
+            if (share < 0.9 * floorShare) {
+                state.SkipWithError("Replica share below the floor share");
+                return;
+            }
+        }
+    }
+
+    SimResult result;
+    for (auto _ : state) {
+        result = Simulate(interval_ms, balanced, floorShare);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * kFrames);
+    state.counters["mean_ms"] = result.mean_ms;
+    state.counters["p99_ms"] = result.p99_ms;
+    state.counters["dsp"] = result.shares[0];
+    state.counters["gpu"] = result.shares[1];
+    state.counters["cpu"] = result.shares[2];
+}
+
+static void BM_FirstFree(benchmark::State& state)
+{
+    RunPolicy(state, false);
+}
+
+static void BM_Balanced(benchmark::State& state)
+{
+    RunPolicy(state, true);
+}
+
+BENCHMARK(BM_FirstFree)->Args({100, 0})->Args({60, 0})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Balanced)->ArgsProduct({{100, 60}, {0, 2, 4}})->Unit(benchmark::kMillisecond);
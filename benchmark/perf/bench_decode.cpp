@@ -0,0 +1,185 @@
+/*
+ * @Description: Micro benchmark of yolov5s decode: legacy full copy vs early-exit objectness.
+ * @version: 1.1
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 11:40:52
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 11:40:52
+ */
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <benchmark/benchmark.h>
+
+#include "YOLOv5sDecode.h"
+#include "RecordedOutputs.h"
+
+static const float kStrides[3] = {8, 16, 32};
+static const float kAnchorGrid[][6] = {
+    {10, 13, 16, 30, 33, 23},
+    {30, 61, 62, 45, 59, 119},
+    {116, 90, 156, 198, 373, 326},
+};
+
+// Copy of ObjectDetectionImpl::PostProcess decode before the early-exit decoder:
+// decode everything into [25200 * 85], then scan objectness.
+static size_t LegacyDecode(const std::vector<RecordedLayer>& layers, float* output, float confThresh)
+{
+    float* tmpOutput = output;
+    for (size_t i = 0; i < layers.size(); i++) {
+        const float* predOutput = layers[i].data.data();
+        for (int j = 0; j < layers[i].height; j++) {
+            for (int k = 0; k < layers[i].width; k++) {
+                int anchorIdx = 0;
+                for (int l = 0; l < 3; l++) {
+                    for (int m = 0; m < layers[i].channel / 3; m++) {
+                        float value = *predOutput;
+                        if (m < 2) {
+                            float gridValue = m == 0 ? k : j;
+                            *tmpOutput = (value * 2 - 0.5 + gridValue) * kStrides[i];
+                        } else if (m < 4) {
+                            *tmpOutput = value * value * 4 * kAnchorGrid[i][anchorIdx++];
+                        } else {
+                            *tmpOutput = value;
+                        }
+                        tmpOutput++;
+                        predOutput++;
+                    }
+                }
+            }
+        }
+    }
+
+    size_t count = 0;
+    for (int i = 0; i < 25200; i++) {
+        float boxConfidence = output[i * 85 + 4];
+        if (boxConfidence > 0.001) {
+            int maxIdx = 5;
+            for (int j = 6; j < 85; j++) {
+                if (output[i * 85 + j] > output[i * 85 + maxIdx]) maxIdx = j;
+            }
+            if (boxConfidence * output[i * 85 + maxIdx] > confThresh) count++;
+        }
+    }
+    return count;
+}
+
+// Candidates the legacy decode keeps, read back from its [25200 * 85] output in anchor order.
+static std::vector<yolov5::Candidate> LegacyCandidates(const std::vector<RecordedLayer>& layers, float confThresh)
+{
+    std::vector<float> output(25200 * 85);
+    LegacyDecode(layers, output.data(), confThresh);
+
+    std::vector<yolov5::Candidate> candidates;
+    for (int i = 0; i < 25200; i++) {
+        const float* p = output.data() + i * 85;
+        if (p[4] <= 0.001) continue;
+        int maxIdx = 5;
+        for (int j = 6; j < 85; j++) {
+            if (p[j] > p[maxIdx]) maxIdx = j;
+        }
+        float score = p[4] * p[maxIdx];
+        if (score <= confThresh) continue;
+        candidates.push_back({p[0], p[1], p[2], p[3], score, maxIdx - 5});
+    }
+    return candidates;
+}
+
+// The legacy decode does the center math in double, hence the small tolerance.
+static bool SameCandidates(const std::vector<yolov5::Candidate>& a, const std::vector<yolov5::Candidate>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].label != b[i].label || std::fabs(a[i].score - b[i].score) > 1e-6f ||
+            std::fabs(a[i].cx - b[i].cx) > 1e-3f || std::fabs(a[i].cy - b[i].cy) > 1e-3f ||
+            std::fabs(a[i].width - b[i].width) > 1e-3f || std::fabs(a[i].height - b[i].height) > 1e-3f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void BM_DecodeLegacy(benchmark::State& state)
+{
+    auto layers = LoadRecordedOutputs();
+    std::vector<float> output(25200 * 85);
+    float confThresh = state.range(0) / 100.0f;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(LegacyDecode(layers, output.data(), confThresh));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_DecodeEarlyExit(benchmark::State& state)
+{
+    auto layers = LoadRecordedOutputs();
+    std::vector<yolov5::Candidate> candidates;
+    float confThresh = state.range(0) / 100.0f;
+
+    for (size_t i = 0; i < layers.size(); i++) {
+        yolov5::DecodeLayer(layers[i].data.data(), layers[i].height, layers[i].width,
+            layers[i].channel, i, std::max(0.001f, confThresh), confThresh, candidates);
+    }
+    if (!SameCandidates(candidates, LegacyCandidates(layers, confThresh))) {
+        state.SkipWithError("Early-exit decode differs from the legacy one");
+        return;
+    }
+
+    for (auto _ : state) {
+        candidates.clear();
+        for (size_t i = 0; i < layers.size(); i++) {
+            yolov5::DecodeLayer(layers[i].data.data(), layers[i].height, layers[i].width,
+                layers[i].channel, i, std::max(0.001f, confThresh), confThresh, candidates);
+        }
+        benchmark::DoNotOptimize(candidates.data());
+    }
+    state.counters["candidates"] = candidates.size();
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_DecodeEarlyExitTF8(benchmark::State& state)
+{
+    auto layers = LoadRecordedOutputs();
+    float table[256];
+    for (int i = 0; i < 256; i++) table[i] = i / 255.0f;
+
+    // The legacy decode of the dequantized tensors is the reference.
+    std::vector<std::vector<uint8_t>> quantized(layers.size());
+    std::vector<RecordedLayer> dequantized = layers;
+    for (size_t i = 0; i < layers.size(); i++) {
+        for (size_t j = 0; j < layers[i].data.size(); j++) {
+            quantized[i].push_back((uint8_t)(layers[i].data[j] * 255.0f + 0.5f));
+            dequantized[i].data[j] = table[quantized[i].back()];
+        }
+    }
+
+    std::vector<yolov5::Candidate> candidates;
+    float confThresh = state.range(0) / 100.0f;
+
+    for (size_t i = 0; i < layers.size(); i++) {
+        yolov5::DecodeLayer(quantized[i].data(), layers[i].height, layers[i].width,
+            layers[i].channel, i, table, std::max(0.001f, confThresh), confThresh, candidates);
+    }
+    if (!SameCandidates(candidates, LegacyCandidates(dequantized, confThresh))) {
+        state.SkipWithError("TF8 decode differs from the legacy one");
+        return;
+    }
+
+    for (auto _ : state) {
+        candidates.clear();
+        for (size_t i = 0; i < layers.size(); i++) {
+            yolov5::DecodeLayer(quantized[i].data(), layers[i].height, layers[i].width,
+                layers[i].channel, i, table, std::max(0.001f, confThresh), confThresh, candidates);
+        }
+        benchmark::DoNotOptimize(candidates.data());
+    }
+    state.counters["candidates"] = candidates.size();
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_DecodeLegacy)->Arg(20)->Arg(50)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_DecodeEarlyExit)->Arg(20)->Arg(50)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_DecodeEarlyExitTF8)->Arg(20)->Arg(50)->Unit(benchmark::kMicrosecond);
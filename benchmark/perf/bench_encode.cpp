@@ -0,0 +1,201 @@
+/*
+ * @Description: Message encoding of VideoAnalyzer: styled jsoncpp vs compact JSON vs binary.
+ * @version: 1.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 23:32:15
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 23:51:06
+ */
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+#include <benchmark/benchmark.h>
+#include <jsoncpp/json/json.h>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "Base64.h"
+#include "ResultEncoder.h"
+#include "MessagePublisher.h"
+
+static const std::vector<std::string> kModels = {"yolov5s-1", "yolov5s-2"};
+static const std::vector<std::vector<std::string>> kLabels = {
+    {"person", "bicycle", "car", "motorcycle", "bus", "truck"},
+    {"person", "bicycle", "car", "motorcycle", "bus", "truck"},
+};
+
+// state.range(0) detections spread over both models, no image.
+static void FillMessage(ResultMessage& message, int count)
+{
+    message.Clear();
+    message.cameraID = 3;
+    message.timestamp_ms = 1666162461677;
+    for (int i = 0; i < count; i++) {
+        message.objects.push_back({cv::Rect(17 * i, 9 * i, 120 + i, 240 - i), 0.5f + 0.01f * i,
+                                   (uint16_t)(i % 2), (uint16_t)(i % 6)});
+    }
+}
+
+// What InferenceFrame() used to do on the inference thread.
+static void BM_EncodeStyledJsoncpp(benchmark::State& state)
+{
+    ResultMessage message;
+    FillMessage(message, state.range(0));
+    for (auto _ : state) {
+        Json::Value root;
+        for (const auto& result : message.objects) {
+            Json::Value object;
+            object["bbox"]["x"] = result.bbox.x;
+            object["bbox"]["y"] = result.bbox.y;
+            object["bbox"]["width"] = result.bbox.width;
+            object["bbox"]["height"] = result.bbox.height;
+            object["confidence"] = result.confidence;
+            object["label"] = kLabels[result.model][result.label];
+            object["model"] = kModels[result.model];
+            root["results"].append(object);
+        }
+        root["timestamp"] = std::to_string(message.timestamp_ms);
+        root["camera-id"] = message.cameraID;
+        std::string payload = root.toStyledString();
+        benchmark::DoNotOptimize(payload.data());
+        state.counters["bytes"] = payload.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// state.range(1): message_format_t
+static void BM_EncodeResult(benchmark::State& state)
+{
+    ResultMessage message;
+    FillMessage(message, state.range(0));
+    ResultEncoder encoder((message_format_t)state.range(1), kModels, kLabels);
+    std::string payload;
+    for (auto _ : state) {
+        encoder.Encode(message, payload);
+        benchmark::DoNotOptimize(payload.data());
+    }
+    state.counters["bytes"] = payload.size();
+    state.SetItemsProcessed(state.iterations());
+}
+
+// The byte at a time encoder ResultEncoder had before Base64Encode().
+static void Base64Scalar(const uint8_t* data, size_t size, std::string& out)
+{
+    static const char kTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < size) v |= data[i + 1] << 8;
+        if (i + 2 < size) v |= data[i + 2];
+        out += kTable[(v >> 18) & 0x3F];
+        out += kTable[(v >> 12) & 0x3F];
+        out += i + 1 < size ? kTable[(v >> 6) & 0x3F] : '=';
+        out += i + 2 < size ? kTable[v & 0x3F] : '=';
+    }
+}
+
+// state.range(0) bytes, about the JPEG of a 1080p / 640x360 snapshot.
+static void BM_Base64Scalar(benchmark::State& state)
+{
+    std::vector<uint8_t> data(state.range(0));
+    for (size_t i = 0; i < data.size(); i++) data[i] = (uint8_t)(i * 2654435761u >> 13);
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        Base64Scalar(data.data(), data.size(), out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+// Every length up to two SIMD blocks (3 * lanes bytes) and a partial tail, then size bytes.
+static bool SameAsScalar(size_t size)
+{
+#if CV_SIMD
+    const size_t block = 3 * cv::v_uint8::nlanes;
+#else
+    const size_t block = 3;
+#endif
+    std::vector<uint8_t> data(std::max(size, 2 * block + 2));
+    for (size_t i = 0; i < data.size(); i++) data[i] = (uint8_t)(i * 2654435761u >> 13);
+
+    std::string expected, actual;
+    for (size_t n = 0; n <= 2 * block + 2; n++) {
+        expected.clear();
+        actual.clear();
+        Base64Scalar(data.data(), n, expected);
+        Base64Append(data.data(), n, actual);
+        if (actual != expected) return false;
+    }
+    expected.clear();
+    actual.clear();
+    Base64Scalar(data.data(), size, expected);
+    Base64Append(data.data(), size, actual);
+    return actual == expected;
+}
+
+static void BM_Base64(benchmark::State& state)
+{
+    if (!SameAsScalar(state.range(0))) {
+        state.SkipWithError("Base64Encode differs from the scalar encoder");
+        return;
+    }
+
+    std::vector<uint8_t> data(state.range(0));
+    for (size_t i = 0; i < data.size(); i++) data[i] = (uint8_t)(i * 2654435761u >> 13);
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        Base64Append(data.data(), data.size(), out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+// Messages per second through the publisher threads to an in process sink standing
+// in for the broker. The producer spins while the pool is exhausted, so the rate is
+// the one of encoding plus queueing, not of the drops.
+// state.range(2): publisher threads, state.range(3): 640x360 snapshot in every message.
+static void BM_PublishThroughput(benchmark::State& state)
+{
+    std::atomic<size_t> bytes{0};
+    ResultEncoder encoder((message_format_t)state.range(1), kModels, kLabels);
+    MessagePublisher publisher(32, state.range(2), encoder, [&bytes](const std::string& payload) {
+        bytes.fetch_add(payload.size(), std::memory_order_relaxed);
+        return true;
+    });
+    publisher.Start();
+
+    ResultMessage scratch;
+    FillMessage(scratch, state.range(0));
+    cv::Mat snapshot(360, 640, CV_8UC3);
+    cv::randu(snapshot, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::GaussianBlur(snapshot, snapshot, cv::Size(9, 9), 0);
+    for (auto _ : state) {
+        std::shared_ptr<ResultMessage> message;
+        while (!(message = publisher.Acquire())) std::this_thread::yield();
+        message->cameraID = scratch.cameraID;
+        message->timestamp_ms = scratch.timestamp_ms;
+        message->objects.assign(scratch.objects.begin(), scratch.objects.end());
+        if (state.range(3)) {
+            snapshot.copyTo(message->snapshot);
+            message->hasSnapshot = true;
+        }
+        publisher.Publish(std::move(message));
+    }
+    publisher.Stop();
+
+    state.counters["published"] = publisher.GetPublished();
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_EncodeStyledJsoncpp)->Arg(4)->Arg(32);
+BENCHMARK(BM_EncodeResult)->Args({4, MESSAGE_JSON})->Args({32, MESSAGE_JSON})
+                          ->Args({4, MESSAGE_BINARY})->Args({32, MESSAGE_BINARY});
+BENCHMARK(BM_Base64Scalar)->Arg(64 << 10)->Arg(256 << 10);
+BENCHMARK(BM_Base64)->Arg(64 << 10)->Arg(256 << 10);
+BENCHMARK(BM_PublishThroughput)->Args({32, MESSAGE_JSON, 1, 0})->Args({32, MESSAGE_BINARY, 1, 0})
+                               ->Args({4, MESSAGE_JSON, 1, 1})->Args({4, MESSAGE_JSON, 4, 1})
+                               ->Args({4, MESSAGE_BINARY, 4, 1})->UseRealTime();
@@ -0,0 +1,106 @@
+/*
+ * @Description: Micro benchmark of EventFilter, checked on a scripted scene first.
+ * @version: 1.0
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-18 02:14:06
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 02:14:06
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "EventFilter.h"
+
+static DetectionRecord MakeRecord(int x, int y, uint16_t label)
+{
+    return {cv::Rect(x, y, 100, 100), 0.9f, 0, label};
+}
+
+/*
+ * One object enters, drifts, moves, a second one of another label enters in its place
+ * then jumps away and the scene stays still: every frame gets its expected events.
+ */
+static bool CheckEventFilter(benchmark::State& state)
+{
+    EventFilterConfig config;
+    config.heartbeat_ms = 1000;
+    EventFilter filter(config);
+    int64_t now_ms = 0;
+
+    auto expect = [&](const std::vector<DetectionRecord>& objects, uint8_t events, const char* error) {
+        uint8_t got = filter.Update(objects, now_ms);
+        now_ms += 40;
+        if (got != events) state.SkipWithError(error);
+        return got == events;
+    };
+
+    const DetectionRecord a0 = MakeRecord(100, 100, 0);
+    const DetectionRecord a5 = MakeRecord(105, 100, 0);
+    const DetectionRecord a10 = MakeRecord(110, 100, 0);
+    const DetectionRecord a25 = MakeRecord(125, 100, 0);
+    const DetectionRecord b = MakeRecord(125, 100, 1);
+    const DetectionRecord bAway = MakeRecord(600, 400, 1);
+
+    if (!expect({}, EVENT_HEARTBEAT, "First frame not published") ||
+        !expect({}, 0, "Empty scene published") ||
+        !expect({a0}, EVENT_ENTER, "Enter not reported") ||
+        // IoU with the published position 0.91 then 0.82, over moveIoU.
+        !expect({a5}, 0, "Drift under the move threshold reported") ||
+        !expect({a10}, 0, "Drift under the move threshold reported") ||
+        // 0.60 once the drift adds up.
+        !expect({a25}, EVENT_MOVE, "Drift over the move threshold not reported") ||
+        !expect({a25}, 0, "Still object reported") ||
+        // Missed once, the one of another label in its place doesn't take it over.
+        !expect({b}, EVENT_ENTER, "Object of another label matched") ||
+        !expect({a25, b}, 0, "Object missed once reported") ||
+        // Under matchIoU: a new object, the old one is missed.
+        !expect({a25, bAway}, EVENT_ENTER, "Jump over the match threshold matched") ||
+        !expect({a25, bAway}, 0, "Leave before leaveFrames") ||
+        !expect({a25, bAway}, EVENT_LEAVE, "Leave after leaveFrames not reported")) {
+        return false;
+    }
+    if (2 != filter.Objects()) {
+        state.SkipWithError("Known objects miscounted");
+        return false;
+    }
+
+    // Last event at 440 ms, the heartbeat is due at 1440 ms.
+    while (now_ms < 1440) {
+        if (!expect({a25, bAway}, 0, "Heartbeat before heartbeat-ms")) return false;
+    }
+    return expect({a25, bAway}, EVENT_HEARTBEAT, "Heartbeat not published") &&
+        expect({a25, bAway}, 0, "Heartbeat repeated");
+}
+
+/*
+ * What a frame of an event driven stream costs: state.range(0) known objects
+ * jittering by a pixel, no event.
+ */
+static void BM_EventFilter(benchmark::State& state)
+{
+    if (!CheckEventFilter(state)) return;
+
+    const int count = state.range(0);
+    std::vector<std::vector<DetectionRecord>> frames(2);
+    for (int i = 0; i < count; i++) {
+        int x = (i % 8) * 220, y = (i / 8) * 120;
+        frames[0].push_back(MakeRecord(x, y, i % 6));
+        frames[1].push_back(MakeRecord(x + 1, y, i % 6));
+    }
+
+    EventFilterConfig config;
+    config.heartbeat_ms = 0;
+    EventFilter filter(config);
+    filter.Update(frames[0], 0);
+    int64_t now_ms = 0;
+    for (auto _ : state) {
+        now_ms += 40;
+        benchmark::DoNotOptimize(filter.Update(frames[now_ms / 40 % 2], now_ms));
+    }
+    state.counters["objects"] = filter.Objects();
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_EventFilter)->Arg(8)->Arg(64);
@@ -0,0 +1,88 @@
+/*
+ * @Description: Micro benchmark of the motion gate on 1080p luma and RGB frames.
+ * @version: 1.1
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-18 01:36:52
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 01:36:52
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/opencv.hpp>
+
+#include "MotionGate.h"
+
+/*
+ * 25 fps on a static scene at min-fps 1, then a block moving and stopping: the gate
+ * stays closed on the static frames but the one forced each second, and opens on
+ * the moving ones only.
+ */
+static bool CheckMotionGate(benchmark::State& state, const cv::Mat& background)
+{
+    MotionGate gate{MotionGateConfig()};
+    int64_t now_ms = 0;
+    auto expect = [&](const cv::Mat& frame, bool open, const char* error) {
+        bool got = gate.Update(frame, now_ms);
+        now_ms += 40;
+        if (got != open) state.SkipWithError(error);
+        return got == open;
+    };
+
+    if (!expect(background, true, "First frame not inferred")) return false;
+    while (now_ms < 1000) {
+        if (!expect(background, false, "Static frame opened the gate")) return false;
+    }
+    if (!expect(background, true, "Forced min-fps frame not inferred") ||
+        !expect(background, false, "Static frame opened the gate after the forced one")) {
+        return false;
+    }
+
+    cv::Mat moving[2];
+    for (int i = 0; i < 2; i++) {
+        background.copyTo(moving[i]);
+        cv::rectangle(moving[i], cv::Rect(200 + 60 * i, 400, 160, 120), cv::Scalar::all(255), cv::FILLED);
+    }
+    return expect(moving[0], true, "Block appearing kept the gate closed") &&
+        expect(moving[1], true, "Moving block kept the gate closed") &&
+        expect(moving[1], false, "Stopped block opened the gate");
+}
+
+/*
+ * The gate runs on every frame of a gated stream, its cost is what a static frame
+ * costs instead of a Detect(). state.range(0): 1 the Y plane of NV12, 3 RGB.
+ * state.range(1): 0 static scene (every block compared), 1 a moving object.
+ */
+static void BM_MotionGate(benchmark::State& state)
+{
+    const int type = 1 == state.range(0) ? CV_8UC1 : CV_8UC3;
+    cv::Mat background(1080, 1920, type);
+    cv::randu(background, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::GaussianBlur(background, background, cv::Size(15, 15), 0);
+
+    std::vector<cv::Mat> frames(8);
+    for (size_t i = 0; i < frames.size(); i++) {
+        background.copyTo(frames[i]);
+        if (state.range(1)) {
+            cv::rectangle(frames[i], cv::Rect(200 + 60 * i, 400, 160, 120), cv::Scalar::all(255), cv::FILLED);
+        }
+    }
+
+    if (!CheckMotionGate(state, background)) return;
+
+    // No forced frame, every one is compared.
+    MotionGateConfig config;
+    config.minFps = 0;
+    MotionGate gate{config};
+    gate.Update(background, 0);
+    size_t frame = 0;
+    size_t opened = 0;
+    for (auto _ : state) {
+        opened += gate.Update(frames[frame++ % frames.size()], 0);
+    }
+    state.counters["inferred"] = benchmark::Counter(opened, benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_MotionGate)->Args({1, 0})->Args({1, 1})->Args({3, 0})->Args({3, 1})->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,174 @@
+/*
+ * @Description: Micro benchmark of NMS: legacy all-pairs vs the NMS engine.
+ * @version: 1.1
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 13:48:10
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 13:48:10
+ */
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <benchmark/benchmark.h>
+
+#include "NMS.h"
+
+struct LegacyBox {
+    int x, y, width, height;
+    float confidence;
+    int label;
+};
+
+static float LegacyIoU(const LegacyBox& a, const LegacyBox& b)
+{
+    int xOverlap = std::max(0, std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x) + 1);
+    int yOverlap = std::max(0, std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y) + 1);
+    int intersection = xOverlap * yOverlap;
+    int unio = (a.width + 1) * (a.height + 1) + (b.width + 1) * (b.height + 1) - intersection;
+    return float(intersection) / unio;
+}
+
+// Copy of the former static ObjectDetectionImpl::nms().
+static std::vector<LegacyBox> LegacyNMS(std::vector<LegacyBox> winList, const float& nms_thresh)
+{
+    std::sort(winList.begin(), winList.end(), [] (const LegacyBox& left, const LegacyBox& right) {
+        return left.confidence > right.confidence;
+    });
+
+    std::vector<bool> flag(winList.size(), false);
+    for (size_t i = 0; i < winList.size(); i++) {
+        if (flag[i]) continue;
+        for (size_t j = i + 1; j < winList.size(); j++) {
+            if (LegacyIoU(winList[i], winList[j]) > nms_thresh) flag[j] = true;
+        }
+    }
+
+    std::vector<LegacyBox> ret;
+    for (size_t i = 0; i < winList.size(); i++) {
+        if (!flag[i]) ret.push_back(winList[i]);
+    }
+    return ret;
+}
+
+// Crowded 1080p frame: clusters of jittered boxes around objects, like a low threshold yields.
+static std::vector<LegacyBox> MakeBoxes(size_t n)
+{
+    std::mt19937 rng(1202);
+    std::uniform_int_distribution<int> cx(0, 1919), cy(0, 1079), size(16, 256), jitter(-8, 8), label(0, 79);
+    std::uniform_real_distribution<float> score(0.2f, 1.0f);
+
+    std::vector<LegacyBox> boxes;
+    while (boxes.size() < n) {
+        int x = cx(rng), y = cy(rng), w = size(rng), h = size(rng), l = label(rng);
+        for (int i = 0; i < 10 && boxes.size() < n; i++) {
+            boxes.push_back({x + jitter(rng), y + jitter(rng), w + jitter(rng), h + jitter(rng), score(rng), l});
+        }
+    }
+    return boxes;
+}
+
+static yolov5::BoxSet ToBoxSet(const std::vector<LegacyBox>& boxes)
+{
+    yolov5::BoxSet set;
+    for (const auto& b : boxes) {
+        set.push_back(b.x, b.y, b.x + b.width, b.y + b.height, b.confidence, b.label);
+    }
+    return set;
+}
+
+static bool BoxLess(const LegacyBox& a, const LegacyBox& b)
+{
+    if (a.confidence != b.confidence) return a.confidence > b.confidence;
+    if (a.x != b.x) return a.x < b.x;
+    if (a.y != b.y) return a.y < b.y;
+    if (a.width != b.width) return a.width < b.width;
+    if (a.height != b.height) return a.height < b.height;
+    return a.label < b.label;
+}
+
+// Hard NMS keeps the same boxes as the legacy one, run label by label when class aware.
+static bool SameAsLegacy(const std::vector<LegacyBox>& boxes, bool classAware, const std::vector<int>& keep)
+{
+    std::vector<LegacyBox> expected;
+    if (classAware) {
+        std::vector<std::vector<LegacyBox>> groups;
+        for (const auto& b : boxes) {
+            if ((int)groups.size() <= b.label) groups.resize(b.label + 1);
+            groups[b.label].push_back(b);
+        }
+        for (const auto& group : groups) {
+            auto kept = LegacyNMS(group, 0.5f);
+            expected.insert(expected.end(), kept.begin(), kept.end());
+        }
+    } else {
+        expected = LegacyNMS(boxes, 0.5f);
+    }
+
+    std::vector<LegacyBox> actual;
+    for (int idx : keep) actual.push_back(boxes[idx]);
+    if (actual.size() != expected.size()) return false;
+
+    std::sort(expected.begin(), expected.end(), BoxLess);
+    std::sort(actual.begin(), actual.end(), BoxLess);
+    for (size_t i = 0; i < actual.size(); i++) {
+        if (BoxLess(actual[i], expected[i]) || BoxLess(expected[i], actual[i])) return false;
+    }
+    return true;
+}
+
+static void BM_NMSLegacy(benchmark::State& state)
+{
+    auto boxes = MakeBoxes(state.range(0));
+    size_t kept = 0;
+
+    for (auto _ : state) {
+        kept = LegacyNMS(boxes, 0.5f).size();
+        benchmark::DoNotOptimize(kept);
+    }
+    state.counters["kept"] = kept;
+}
+
+static void RunEngine(benchmark::State& state, yolov5::nms_method_t method, bool classAware, int maxCandidates)
+{
+    auto boxes = MakeBoxes(state.range(0));
+    auto set = ToBoxSet(boxes);
+    yolov5::NMS nms;
+    yolov5::NMSConfig config;
+    config.method = method;
+    config.classAware = classAware;
+    config.maxCandidates = maxCandidates;
+    std::vector<int> keep;
+    std::vector<float> scores;
+
+    // Only the plain hard NMS has a legacy counterpart.
+    if (yolov5::NMS_HARD == method && 0 == maxCandidates) {
+        nms.Run(set, config, keep, scores);
+        if (!SameAsLegacy(boxes, classAware, keep)) {
+            state.SkipWithError("Hard NMS keeps other boxes than the legacy one");
+            return;
+        }
+    }
+
+    for (auto _ : state) {
+        nms.Run(set, config, keep, scores);
+        benchmark::DoNotOptimize(keep.data());
+    }
+    state.counters["kept"] = keep.size();
+}
+
+static void BM_NMSHard(benchmark::State& state)         { RunEngine(state, yolov5::NMS_HARD, false, 0); }
+static void BM_NMSHardClassAware(benchmark::State& state) { RunEngine(state, yolov5::NMS_HARD, true, 0); }
+static void BM_NMSHardTop1000(benchmark::State& state)  { RunEngine(state, yolov5::NMS_HARD, false, 1000); }
+static void BM_NMSFastTop1000(benchmark::State& state)  { RunEngine(state, yolov5::NMS_FAST, false, 1000); }
+static void BM_NMSSoftLinear(benchmark::State& state)   { RunEngine(state, yolov5::NMS_SOFT_LINEAR, false, 0); }
+static void BM_NMSSoftGaussian(benchmark::State& state) { RunEngine(state, yolov5::NMS_SOFT_GAUSSIAN, false, 0); }
+
+BENCHMARK(BM_NMSLegacy)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NMSHard)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NMSHardClassAware)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NMSHardTop1000)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NMSFastTop1000)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NMSSoftLinear)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NMSSoftGaussian)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,283 @@
+/*
+ * @Description: End to end benchmark of ObjectDetection over a mock SNPETask replaying recorded outputs.
+ * @version: 1.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 21:20:48
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 21:20:48
+ */
+
+#include <vector>
+#include <string>
+#include <future>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/opencv.hpp>
+
+#include "YOLOv5s.h"
+
+/*
+ * Built against benchmark/perf/mock, so the real pre-process, decode, NMS, replica
+ * leases and async pipeline run on any Linux box. Every benchmark reports p50/p95/p99
+ * latency per frame and frames per second, BM_Detect also the p50/p99 of each stage
+ * (see ObjectDetection::GetStageProfile()).
+ * Regression gate: keep a --benchmark_out=base.json run and compare a change with
+ * tools/compare.py of Google Benchmark.
+ * YOLOV5S_RECORDED_OUTPUTS replays real tensors (see RecordedOutputs.h),
+ * YOLOV5S_MOCK_EXECUTE_US adds an accelerator latency to every execute().
+ * BM_Detect also counts the heap allocations of Detect() once warm, it reports an
+ * error unless allocs_per_frame stays 0.
+ */
+
+// Every operator new of the process, BM_Detect reads it around Detect() only.
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+static std::vector<cv::Mat> LoadImages()
+{
+    std::vector<cv::Mat> images;
+    for (const char* dir : {"/benchmark/yolov5s/cropped", "/test/test_image"}) {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(std::string(PERF_SOURCE_DIR) + dir, ec)) {
+            std::string ext = entry.path().extension().string();
+            if (ext != ".jpg" && ext != ".jpeg" && ext != ".png") continue;
+            cv::Mat image = cv::imread(entry.path().string());
+            if (image.empty()) continue;
+            cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
+            images.push_back(image);
+        }
+    }
+
+    // No sample images around: one random 1080p frame.
+    if (images.empty()) {
+        cv::Mat frame(1080, 1920, CV_8UC3);
+        cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+        images.push_back(frame);
+    }
+    return images;
+}
+
+static const std::vector<cv::Mat>& Images()
+{
+    static std::vector<cv::Mat> images = LoadImages();
+    return images;
+}
+
+static yolov5::ObjectDetectionConfig MockConfig(userbuffer_encoding_t encoding, int replicas,
+                                                int batchSize = 1, int asyncDepth = 0)
+{
+    yolov5::ObjectDetectionConfig config;
+    config.model_path = "mock.dlc";
+    config.runtime = CPU;
+    config.runtimes.assign(replicas, CPU);
+    config.labels = 85;
+    config.grids = 25200;
+    config.batchSize = batchSize;
+    config.asyncDepth = asyncDepth;
+    config.inputLayers = {"images"};
+    config.outputLayers = {"Sigmoid_199", "Sigmoid_201", "Sigmoid_203"};
+    config.outputTensors = {"output", "329", "331"};
+    config.bufferEncoding = encoding;
+    config.stageProfiling = true;
+    return config;
+}
+
+/*
+ * Latency of every frame, percentiles go into the counters.
+ */
+class LatencyRecorder {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    void Add(Clock::time_point start) {
+        m_samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+
+    void Report(benchmark::State& state) {
+        if (m_samples.empty()) return;
+        std::sort(m_samples.begin(), m_samples.end());
+        // Threads report their own percentiles, the table shows their average.
+        state.counters["p50_ms"] = benchmark::Counter(Percentile(0.50), benchmark::Counter::kAvgThreads);
+        state.counters["p95_ms"] = benchmark::Counter(Percentile(0.95), benchmark::Counter::kAvgThreads);
+        state.counters["p99_ms"] = benchmark::Counter(Percentile(0.99), benchmark::Counter::kAvgThreads);
+        state.counters["fps"] = benchmark::Counter(m_samples.size(), benchmark::Counter::kIsRate);
+    }
+
+private:
+    double Percentile(double q) const {
+        size_t index = std::min(m_samples.size() - 1, (size_t)(q * m_samples.size()));
+        return m_samples[index];
+    }
+
+    std::vector<double> m_samples;
+};
+
+static void ReportStages(benchmark::State& state, yolov5::ObjectDetection& detector)
+{
+    std::vector<yolov5::StageProfile> profile;
+    if (!detector.GetStageProfile(profile)) return;
+    for (const auto& stage : profile) {
+        if (0 == stage.stage.compare(0, 5, "MOCK#") && std::string::npos != stage.stage.find(".init")) continue;
+        state.counters[stage.stage + ".p50_ms"] = stage.p50_ms;
+        state.counters[stage.stage + ".p99_ms"] = stage.p99_ms;
+    }
+}
+
+// state.range(0): buffer encoding, 0 float, 1 TF8.
+static void BM_Detect(benchmark::State& state)
+{
+    const std::vector<cv::Mat>& images = Images();
+    yolov5::ObjectDetection detector;
+    detector.Init(MockConfig((userbuffer_encoding_t)state.range(0), 1));
+    detector.SetScoreThreshold(0.3f, 0.5f);
+
+    LatencyRecorder latency;
+    std::vector<yolov5::ObjectData> results;
+    // Warm up: scratch buffers, stage names and results reach their high-water mark.
+    for (size_t i = 0; i < 2 * images.size(); i++) {
+        results.clear();
+        detector.Detect(images[i % images.size()], results);
+    }
+
+    size_t allocations = 0;
+    size_t frame = 0;
+    for (auto _ : state) {
+        results.clear();
+        auto start = LatencyRecorder::Clock::now();
+        size_t before = g_allocations.load(std::memory_order_relaxed);
+        detector.Detect(images[frame++ % images.size()], results);
+        allocations += g_allocations.load(std::memory_order_relaxed) - before;
+        latency.Add(start);
+        benchmark::DoNotOptimize(results.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    latency.Report(state);
+    ReportStages(state, detector);
+    state.counters["allocs_per_frame"] = benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+    detector.Deinit();
+    if (allocations > 0) {
+        std::string error = "Detect() allocated " + std::to_string(allocations) + " times once warm";
+        state.SkipWithError(error.c_str());
+    }
+}
+
+// Concurrent Detect() of state.threads() workers on as many replicas, like VideoAnalyzer.
+static yolov5::ObjectDetection* g_shared = nullptr;
+
+static void BM_DetectThreads(benchmark::State& state)
+{
+    const std::vector<cv::Mat>& images = Images();
+    if (0 == state.thread_index()) {
+        g_shared = new yolov5::ObjectDetection();
+        g_shared->Init(MockConfig(USERBUFFER_FLOAT, state.threads()));
+        g_shared->SetScoreThreshold(0.3f, 0.5f);
+    }
+
+    LatencyRecorder latency;
+    std::vector<yolov5::ObjectData> results;
+    size_t frame = state.thread_index();
+    for (auto _ : state) {
+        results.clear();
+        auto start = LatencyRecorder::Clock::now();
+        g_shared->Detect(images[frame++ % images.size()], results);
+        latency.Add(start);
+        benchmark::DoNotOptimize(results.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    latency.Report(state);
+    if (0 == state.thread_index()) {
+        delete g_shared;
+        g_shared = nullptr;
+    }
+}
+
+// state.range(0) frames per execute().
+static void BM_DetectBatch(benchmark::State& state)
+{
+    const std::vector<cv::Mat>& images = Images();
+    const int batch = state.range(0);
+    yolov5::ObjectDetection detector;
+    detector.Init(MockConfig(USERBUFFER_FLOAT, 1, batch));
+    detector.SetScoreThreshold(0.3f, 0.5f);
+
+    std::vector<cv::Mat> group(batch);
+    std::vector<std::vector<yolov5::ObjectData>> results;
+    LatencyRecorder latency;
+    size_t frame = 0;
+    for (auto _ : state) {
+        for (auto& image : group) image = images[frame++ % images.size()];
+        for (auto& slot : results) slot.clear();
+        auto start = LatencyRecorder::Clock::now();
+        detector.DetectBatch(group, results);
+        // Every frame of the group waits for the whole batch.
+        for (int i = 0; i < batch; i++) latency.Add(start);
+        benchmark::DoNotOptimize(results.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * batch);
+    latency.Report(state);
+    detector.Deinit();
+}
+
+// state.range(0) frames in flight.
+static void BM_DetectAsync(benchmark::State& state)
+{
+    const std::vector<cv::Mat>& images = Images();
+    const size_t depth = state.range(0);
+    yolov5::ObjectDetection detector;
+    detector.Init(MockConfig(USERBUFFER_FLOAT, 1, 1, depth));
+    detector.SetScoreThreshold(0.3f, 0.5f);
+
+    typedef std::pair<LatencyRecorder::Clock::time_point, std::future<std::vector<yolov5::ObjectData>>> InFlight;
+    std::deque<InFlight> inFlight;
+    LatencyRecorder latency;
+    size_t frame = 0;
+    for (auto _ : state) {
+        if (inFlight.size() >= depth) {
+            benchmark::DoNotOptimize(inFlight.front().second.get());
+            latency.Add(inFlight.front().first);
+            inFlight.pop_front();
+        }
+        auto start = LatencyRecorder::Clock::now();
+        inFlight.emplace_back(start, detector.DetectAsync(images[frame++ % images.size()]));
+    }
+    while (!inFlight.empty()) {
+        inFlight.front().second.wait();
+        latency.Add(inFlight.front().first);
+        inFlight.pop_front();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    latency.Report(state);
+    detector.Deinit();
+}
+
+BENCHMARK(BM_Detect)->Arg(USERBUFFER_FLOAT)->Arg(USERBUFFER_TF8)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_DetectThreads)->ThreadRange(1, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_DetectBatch)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_DetectAsync)->Arg(1)->Arg(3)->Unit(benchmark::kMillisecond)->UseRealTime();
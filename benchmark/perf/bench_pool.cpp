@@ -0,0 +1,82 @@
+/*
+ * @Description: Throughput of a TaskPool of fake replicas driven by several workers.
+ * @version: 1.0
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 17:48:26
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 17:48:26
+ */
+
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "TaskPool.h"
+
+// Stands for a SNPETask bound to one runtime: execute() just takes its latency.
+struct FakeTask {
+    explicit FakeTask(int latency_ms) : latency(latency_ms) {}
+    bool execute() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(latency));
+        return true;
+    }
+    int latency;
+};
+
+static constexpr int kFrames = 48;
+static constexpr int kWorkers = 4;
+
+// Workers share kFrames frames, each frame leases any free replica.
+static void RunPool(benchmark::State& state, const std::vector<int>& latencies)
+{
+    std::vector<snpetask::ReplicaStats> stats;
+    for (auto _ : state) {
+        snpetask::TaskPool<FakeTask> pool;
+        for (size_t i = 0; i < latencies.size(); i++) {
+            pool.Add(std::unique_ptr<FakeTask>(new FakeTask(latencies[i])), std::to_string(latencies[i]) + "ms#" + std::to_string(i));
+        }
+
+        std::vector<std::thread> workers;
+        for (int w = 0; w < kWorkers; w++) {
+            workers.emplace_back([&pool]() {
+                for (int n = 0; n < kFrames / kWorkers; n++) {
+                    auto lease = pool.Acquire();
+                    lease->execute();
+                }
+            });
+        }
+        for (auto& t : workers) t.join();
+        stats = pool.Stats();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kFrames);
+    for (auto& replica : stats) {
+        state.counters["util_" + replica.name] = replica.utilization;
+    }
+}
+
+// The DSP alone.
+static void BM_PoolDSP(benchmark::State& state)
+{
+    RunPool(state, {8});
+}
+
+// DSP plus a 2.5x slower GPU picking the frames the DSP can't take.
+static void BM_PoolDSPGPU(benchmark::State& state)
+{
+    RunPool(state, {8, 20});
+}
+
+// Two networks on the same DSP.
+static void BM_PoolDSPx2(benchmark::State& state)
+{
+    RunPool(state, {8, 8});
+}
+
+BENCHMARK(BM_PoolDSP)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PoolDSPGPU)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PoolDSPx2)->UseRealTime()->Unit(benchmark::kMillisecond);
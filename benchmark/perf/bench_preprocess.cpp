@@ -0,0 +1,177 @@
+/*
+ * @Description: Micro benchmark of yolov5s pre-process: legacy 3-pass path vs fused letterbox.
+ * @version: 1.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 09:40:11
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 09:40:11
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/opencv.hpp>
+
+#include "ImageProcess.h"
+
+static constexpr int kInputWidth = 640;
+static constexpr int kInputHeight = 640;
+
+static cv::Mat MakeFrame(int width, int height)
+{
+    cv::Mat frame(height, width, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+    return frame;
+}
+
+// Copy of ObjectDetectionImpl::PreProcess before the fused kernel.
+static void LegacyPreProcess(const cv::Mat& image, float* tensor)
+{
+    cv::Mat input(kInputHeight, kInputWidth, CV_32FC3, tensor);
+
+    float scale = std::min(kInputHeight / (float)image.rows, kInputWidth / (float)image.cols);
+    int scaledWidth = image.cols * scale;
+    int scaledHeight = image.rows * scale;
+    int xOffset = (kInputWidth - scaledWidth) / 2;
+    int yOffset = (kInputHeight - scaledHeight) / 2;
+
+    cv::Mat inputMat(kInputHeight, kInputWidth, CV_8UC3, cv::Scalar(128, 128, 128));
+    cv::Mat roiMat(inputMat, cv::Rect(xOffset, yOffset, scaledWidth, scaledHeight));
+    cv::resize(image, roiMat, cv::Size(scaledWidth, scaledHeight), cv::INTER_LINEAR);
+
+    inputMat.convertTo(input, CV_32FC3);
+    input /= 255.0f;
+}
+
+static float MaxAbsDiff(const std::vector<float>& a, const std::vector<float>& b)
+{
+    float diff = 0.0f;
+    for (size_t i = 0; i < a.size(); i++) {
+        diff = std::max(diff, std::fabs(a[i] - b[i]));
+    }
+    return diff;
+}
+
+static void BM_PreProcessLegacy(benchmark::State& state)
+{
+    cv::Mat frame = MakeFrame(state.range(0), state.range(1));
+    std::vector<float> tensor(kInputWidth * kInputHeight * 3);
+
+    for (auto _ : state) {
+        LegacyPreProcess(frame, tensor.data());
+        benchmark::DoNotOptimize(tensor.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_PreProcessFused(benchmark::State& state)
+{
+    cv::Mat frame = MakeFrame(state.range(0), state.range(1));
+    std::vector<float> tensor(kInputWidth * kInputHeight * 3);
+    yolov5::LetterboxNormalizer letterbox;
+    yolov5::LetterboxInfo info;
+
+    // Same tensor as the legacy path, the fused resizer is within 1 LSB of cv::resize.
+    std::vector<float> reference(tensor.size());
+    LegacyPreProcess(frame, reference.data());
+    letterbox.Run(frame, tensor.data(), kInputWidth, kInputHeight, info);
+    if (MaxAbsDiff(tensor, reference) > 1.001f / 255.0f) {
+        state.SkipWithError("Fused pre-process differs from the legacy one");
+        return;
+    }
+
+    for (auto _ : state) {
+        letterbox.Run(frame, tensor.data(), kInputWidth, kInputHeight, info);
+        benchmark::DoNotOptimize(tensor.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// NV12 frame of a random image: Y plane, then interleaved UV rows.
+static cv::Mat MakeNV12(int width, int height, yolov5::YUVImage& image)
+{
+    cv::Mat rgb = MakeFrame(width, height);
+    cv::GaussianBlur(rgb, rgb, cv::Size(5, 5), 0);
+    cv::Mat i420, nv12(height * 3 / 2, width, CV_8UC1);
+    cv::cvtColor(rgb, i420, cv::COLOR_RGB2YUV_I420);
+
+    const uint8_t* u = i420.ptr<uint8_t>(height);
+    const uint8_t* v = u + (width / 2) * (height / 2);
+    memcpy(nv12.data, i420.data, (size_t)width * height);
+    uint8_t* uv = nv12.ptr<uint8_t>(height);
+    for (int i = 0; i < (width / 2) * (height / 2); i++) {
+        uv[i * 2] = u[i];
+        uv[i * 2 + 1] = v[i];
+    }
+
+    image.format = PIXEL_FORMAT_NV12;
+    image.width = width;
+    image.height = height;
+    image.planes[0] = nv12.data;
+    image.planes[1] = uv;
+    image.strides[0] = image.strides[1] = width;
+    return nv12;
+}
+
+// Decoder NV12 -> full frame RGB -> letterbox, what an RGB appsink costs.
+static void BM_PreProcessNV12ViaRGB(benchmark::State& state)
+{
+    yolov5::YUVImage image;
+    cv::Mat nv12 = MakeNV12(state.range(0), state.range(1), image);
+    std::vector<float> tensor(kInputWidth * kInputHeight * 3);
+    yolov5::LetterboxNormalizer letterbox;
+    yolov5::LetterboxInfo info;
+    cv::Mat rgb;
+
+    for (auto _ : state) {
+        cv::cvtColor(nv12, rgb, cv::COLOR_YUV2RGB_NV12);
+        letterbox.Run(rgb, tensor.data(), kInputWidth, kInputHeight, info);
+        benchmark::DoNotOptimize(tensor.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Planes downscaled first, converted at the letterbox size. max_abs_diff: largest
+// distance to BM_PreProcessNV12ViaRGB in 0-255 pixel units (chroma is subsampled anyway).
+static void BM_PreProcessNV12(benchmark::State& state)
+{
+    yolov5::YUVImage image;
+    cv::Mat nv12 = MakeNV12(state.range(0), state.range(1), image);
+    std::vector<float> tensor(kInputWidth * kInputHeight * 3);
+    yolov5::LetterboxNormalizer letterbox;
+    yolov5::LetterboxInfo info;
+
+    for (auto _ : state) {
+        letterbox.Run(image, tensor.data(), kInputWidth, kInputHeight, info);
+        benchmark::DoNotOptimize(tensor.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    cv::Mat rgb;
+    std::vector<float> reference(tensor.size());
+    yolov5::LetterboxNormalizer referenceLetterbox;
+    cv::cvtColor(nv12, rgb, cv::COLOR_YUV2RGB_NV12);
+    referenceLetterbox.Run(rgb, reference.data(), kInputWidth, kInputHeight, info);
+    state.counters["max_abs_diff"] = MaxAbsDiff(tensor, reference) * 255.0f;
+}
+
+static void BM_NormalizeRow(benchmark::State& state)
+{
+    std::vector<uint8_t> src(state.range(0), 200);
+    std::vector<float> dst(state.range(0));
+
+    for (auto _ : state) {
+        yolov5::NormalizeRow(src.data(), dst.data(), src.size(), 1.0f / 255.0f);
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetBytesProcessed(state.iterations() * src.size());
+}
+
+BENCHMARK(BM_PreProcessLegacy)->Args({1920, 1080})->Args({1280, 720})->Args({640, 640})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PreProcessFused)->Args({1920, 1080})->Args({1280, 720})->Args({640, 640})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PreProcessNV12ViaRGB)->Args({1920, 1080})->Args({1280, 720})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PreProcessNV12)->Args({1920, 1080})->Args({1280, 720})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_NormalizeRow)->Arg(640 * 3)->Arg(640 * 640 * 3);
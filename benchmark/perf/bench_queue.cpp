@@ -0,0 +1,67 @@
+/*
+ * @Description: Contention benchmark of the frame queues: SafetyQueue vs RingQueue.
+ * @version: 1.0
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 14:58:40
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 14:58:40
+ */
+
+#include <vector>
+#include <thread>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "SafeQueue.h"
+#include "RingQueue.h"
+
+static constexpr int kItems = 1 << 16;
+static constexpr int kCapacity = 1024;
+
+// state.range(0) producers push kItems in total while one consumer drains them,
+// every queue runs with blocking push so nothing is dropped.
+template<typename Queue>
+static void RunContention(benchmark::State& state, Queue& queue)
+{
+    const int producers = state.range(0);
+    const int perProducer = kItems / producers;
+    std::vector<std::shared_ptr<int>> items(producers);
+    for (int i = 0; i < producers; i++) items[i] = std::make_shared<int>(i);
+
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < producers; i++) {
+            threads.emplace_back([&queue, &items, i, perProducer]() {
+                for (int n = 0; n < perProducer; n++) queue.product(items[i]);
+            });
+        }
+
+        std::shared_ptr<int> item;
+        for (int n = 0; n < perProducer * producers; n++) queue.consumption(item);
+        for (auto& t : threads) t.join();
+    }
+    state.SetItemsProcessed(state.iterations() * perProducer * producers);
+}
+
+static void BM_SafetyQueue(benchmark::State& state)
+{
+    SafetyQueue<int> queue(kCapacity);
+    RunContention(state, queue);
+}
+
+static void BM_RingQueueMPMC(benchmark::State& state)
+{
+    RingQueue<int, MPMCRing> queue(kCapacity, OVERFLOW_BLOCK);
+    RunContention(state, queue);
+}
+
+static void BM_RingQueueSPSC(benchmark::State& state)
+{
+    RingQueue<int, SPSCRing> queue(kCapacity, OVERFLOW_BLOCK);
+    RunContention(state, queue);
+}
+
+BENCHMARK(BM_SafetyQueue)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RingQueueMPMC)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RingQueueSPSC)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,169 @@
+/*
+ * @Description: Micro benchmark of ObjectTracker: detected frames vs predicted ones.
+ * @version: 1.1
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-18 00:58:13
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 00:58:13
+ */
+
+#include <vector>
+#include <cstdlib>
+
+#include <benchmark/benchmark.h>
+
+#include "Tracker.h"
+
+// state.range(0) objects moving at constant speed on a 1080p frame, 25 fps.
+static void MakeFrame(std::vector<yolov5::ObjectData>& objects, int count, int64_t timestamp_ms)
+{
+    objects.clear();
+    for (int i = 0; i < count; i++) {
+        yolov5::ObjectData object;
+        int x = (int)(37 * i + (i % 7 - 3) * 40 * timestamp_ms / 1000) % 1800;
+        object.bbox = cv::Rect(x < 0 ? x + 1800 : x, (53 * i) % 1000, 60 + i % 40, 80 + i % 30);
+        object.confidence = 0.5f + (i % 50) * 0.01f;
+        object.label = i % 6;
+        objects.push_back(object);
+    }
+}
+
+static const yolov5::ObjectData* FindTrack(const std::vector<yolov5::ObjectData>& objects, int trackId)
+{
+    for (auto& object : objects) {
+        if (object.trackId == trackId) return &object;
+    }
+    return nullptr;
+}
+
+/*
+ * Three objects at constant speed, detected at 25 fps for 10 frames, then predicted
+ * for 5 frames, detected again, then gone: the ids hold across the predicted frames,
+ * the predictions follow the motion and the tracks are dropped after max age.
+ */
+static bool CheckTracker(benchmark::State& state)
+{
+    yolov5::TrackerConfig config;
+    yolov5::ObjectTracker tracker{config};
+    std::vector<yolov5::ObjectData> objects;
+    const int count = 3;
+    // Pixels per s, boxes far enough apart never to overlap.
+    const int speeds[count] = {200, -150, 0};
+    auto truth = [&](int i, int64_t timestamp_ms) {
+        return cv::Rect(400 + 500 * i + speeds[i] * timestamp_ms / 1000, 300 + 200 * i, 80, 120);
+    };
+    auto detect = [&](int64_t timestamp_ms) {
+        objects.clear();
+        for (int i = 0; i < count; i++) {
+            yolov5::ObjectData object;
+            object.bbox = truth(i, timestamp_ms);
+            object.confidence = 0.9f;
+            object.label = i % 2;
+            objects.push_back(object);
+        }
+        tracker.Update(objects, timestamp_ms);
+    };
+
+    int64_t timestamp_ms = 0;
+    for (int f = 0; f < 10; f++, timestamp_ms += 40) detect(timestamp_ms);
+    int ids[count];
+    for (int i = 0; i < count; i++) ids[i] = objects[i].trackId;
+    if (ids[0] < 0 || ids[1] < 0 || ids[2] < 0 || ids[0] == ids[1] || ids[1] == ids[2] || ids[0] == ids[2]) {
+        state.SkipWithError("Tracks not confirmed with distinct ids");
+        return false;
+    }
+
+    int64_t lastDetected_ms = timestamp_ms - 40;
+    for (int f = 0; f < 5; f++, timestamp_ms += 40) {
+        objects.clear();
+        tracker.Predict(timestamp_ms, objects);
+        if ((int)objects.size() != count) {
+            state.SkipWithError("Predicted frame lost a track");
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            const yolov5::ObjectData* object = FindTrack(objects, ids[i]);
+            cv::Rect expected = truth(i, timestamp_ms);
+            if (nullptr == object || std::abs(object->bbox.x - expected.x) > 2 ||
+                std::abs(object->bbox.y - expected.y) > 2 ||
+                std::abs(object->bbox.width - expected.width) > 2) {
+                state.SkipWithError("Predicted box off the constant velocity motion");
+                return false;
+            }
+        }
+    }
+
+    detect(timestamp_ms);
+    for (int i = 0; i < count; i++) {
+        if (objects[i].trackId != ids[i]) {
+            state.SkipWithError("Track id changed across predicted frames");
+            return false;
+        }
+    }
+    lastDetected_ms = timestamp_ms;
+
+    // Predicted up to max age, then dropped by the next update.
+    objects.clear();
+    tracker.Predict(lastDetected_ms + config.maxAge_ms, objects);
+    if ((int)objects.size() != count) {
+        state.SkipWithError("Track dropped before max age");
+        return false;
+    }
+    objects.clear();
+    tracker.Predict(lastDetected_ms + config.maxAge_ms + 40, objects);
+    if (!objects.empty()) {
+        state.SkipWithError("Track predicted after max age");
+        return false;
+    }
+    objects.clear();
+    tracker.Update(objects, lastDetected_ms + config.maxAge_ms + 40);
+    if (0 != tracker.Tracks()) {
+        state.SkipWithError("Track kept after max age");
+        return false;
+    }
+    return true;
+}
+
+static void BM_TrackerUpdate(benchmark::State& state)
+{
+    if (!CheckTracker(state)) return;
+
+    yolov5::ObjectTracker tracker{yolov5::TrackerConfig()};
+    std::vector<yolov5::ObjectData> objects;
+    int64_t timestamp_ms = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        MakeFrame(objects, state.range(0), timestamp_ms);
+        state.ResumeTiming();
+        tracker.Update(objects, timestamp_ms);
+        benchmark::DoNotOptimize(objects.data());
+        timestamp_ms += 40;
+    }
+    state.counters["tracks"] = tracker.Tracks();
+    state.SetItemsProcessed(state.iterations());
+}
+
+// What a frame skipped by the detector costs: one detection every 5 frames.
+static void BM_TrackerPredict(benchmark::State& state)
+{
+    if (!CheckTracker(state)) return;
+
+    yolov5::ObjectTracker tracker{yolov5::TrackerConfig()};
+    std::vector<yolov5::ObjectData> objects;
+    int64_t timestamp_ms = 0;
+    for (int i = 0; i < 5; i++, timestamp_ms += 200) {
+        MakeFrame(objects, state.range(0), timestamp_ms);
+        tracker.Update(objects, timestamp_ms);
+    }
+    for (auto _ : state) {
+        objects.clear();
+        tracker.Predict(timestamp_ms, objects);
+        benchmark::DoNotOptimize(objects.data());
+        timestamp_ms += 40;
+    }
+    state.counters["tracks"] = tracker.Tracks();
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_TrackerUpdate)->Arg(8)->Arg(64);
+BENCHMARK(BM_TrackerPredict)->Arg(8)->Arg(64);
@@ -0,0 +1,261 @@
+/*
+ * @Description: SNPETask stand-in replaying recorded yolov5s outputs, no SNPE needed.
+ * @version: 1.1
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 21:05:36
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 21:05:36
+ */
+
+#ifndef __SNPE_TASK_H__
+#define __SNPE_TASK_H__
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+
+#include "utils.h"
+#include "StageProfiler.h"
+#include "TensorHandle.h"
+#include "../RecordedOutputs.h"
+
+namespace snpetask {
+
+/*
+ * Same interface as snpetask/SNPETask.h for what ObjectDetectionImpl uses. Input
+ * "images" is [batch, 640, 640, 3], outputs are the recorded layers (see
+ * RecordedOutputs.h), copied into every buffer set at init() and never touched
+ * again: execute() only waits YOLOV5S_MOCK_EXECUTE_US (0 by default), so the
+ * benchmarks time our own code and not a simulated accelerator.
+ */
+
+class SNPETask {
+public:
+    SNPETask() = default;
+    ~SNPETask() = default;
+
+    bool init(const std::string& model_path, const runtime_t runtime,
+              const userbuffer_encoding_t encoding = USERBUFFER_FLOAT) {
+        (void)model_path;
+        (void)runtime;
+        m_encoding = encoding;
+        int64_t start = GetTimeStamp_us();
+
+        const char* executeUs = std::getenv("YOLOV5S_MOCK_EXECUTE_US");
+        m_execute_us = executeUs ? std::atoll(executeUs) : 0;
+
+        // Sigmoid outputs in [0, 1]: TF8 with 1 / 255 steps, same for the 0-255 pixels.
+        m_quant.stepExactly0 = 0;
+        m_quant.stepSize = 1.0f / 255.0f;
+
+        m_inputDescs.clear();
+        m_outputDescs.clear();
+        m_inputDescs.push_back(MakeDesc("images", {m_batchSize, 640, 640, 3}));
+        std::vector<RecordedLayer> layers = LoadRecordedOutputs();
+        for (const auto& layer : layers) {
+            m_outputDescs.push_back(MakeDesc(layer.name,
+                {m_batchSize, (size_t)layer.height, (size_t)layer.width, (size_t)layer.channel}));
+        }
+
+        m_bufferSets = std::vector<BufferSet>(m_bufferSetCount);
+        size_t inputSize = m_batchSize * 640 * 640 * 3;
+        for (auto& set : m_bufferSets) {
+            set.inputFloat["images"].resize(USERBUFFER_FLOAT == encoding ? inputSize : 0);
+            set.inputRaw["images"].resize(USERBUFFER_TF8 == encoding ? inputSize : 0);
+            for (const auto& layer : layers) {
+                std::vector<float>& floats = set.outputFloat[layer.name];
+                std::vector<uint8_t>& raws = set.outputRaw[layer.name];
+                for (size_t slot = 0; slot < m_batchSize; slot++) {
+                    if (USERBUFFER_TF8 == encoding) {
+                        for (float v : layer.data) {
+                            raws.push_back((uint8_t)std::lround(std::min(1.0f, std::max(0.0f, v)) * 255.0f));
+                        }
+                    } else {
+                        floats.insert(floats.end(), layer.data.begin(), layer.data.end());
+                    }
+                }
+            }
+        }
+
+        if (m_profiler) m_profiler->record(m_stageBuild, GetTimeStamp_us() - start);
+        m_isInit = true;
+        return true;
+    }
+
+    bool deInit() {
+        m_bufferSets.clear();
+        m_inputDescs.clear();
+        m_outputDescs.clear();
+        m_isInit = false;
+        return true;
+    }
+
+    bool setOutputLayers(std::vector<std::string>& outputLayers) {
+        (void)outputLayers;
+        return true;
+    }
+    bool setBatchSize(size_t batchSize) {
+        m_batchSize = batchSize ? batchSize : 1;
+        return true;
+    }
+    size_t getBatchSize() {
+        return m_batchSize;
+    }
+    bool setBufferSets(size_t count) {
+        m_bufferSetCount = count ? count : 1;
+        return true;
+    }
+    size_t getBufferSets() {
+        return m_bufferSets.size() ? m_bufferSets.size() : m_bufferSetCount;
+    }
+    bool setPerformanceProfile(performance_profile_t profile) {
+        m_profile = profile;
+        return true;
+    }
+    performance_profile_t getPerformanceProfile() {
+        return m_profile;
+    }
+    void setProfiler(std::shared_ptr<StageProfiler> profiler, const std::string& name = "") {
+        std::string prefix = name.empty() ? "" : name + ".";
+        m_stageBuild = prefix + "init.build";
+        m_stageExecute = prefix + "execute";
+        m_profiler = profiler;
+    }
+
+    std::vector<size_t> getInputShape(const std::string& name) {
+        const TensorDesc* desc = getInputDesc(name);
+        return desc ? desc->shape : std::vector<size_t>();
+    }
+    std::vector<size_t> getOutputShape(const std::string& name) {
+        const TensorDesc* desc = getOutputDesc(name);
+        return desc ? desc->shape : std::vector<size_t>();
+    }
+
+    const TensorDesc* getInputDesc(const std::string& name) {
+        return FindDesc(m_inputDescs, name);
+    }
+    const TensorDesc* getOutputDesc(const std::string& name) {
+        return FindDesc(m_outputDescs, name);
+    }
+    TensorHandle getInputHandle(const std::string& name, size_t set = 0) {
+        TensorHandle handle;
+        handle.desc = getInputDesc(name);
+        if (nullptr == handle.desc || set >= m_bufferSets.size()) return TensorHandle();
+        handle.data = getInputBuffer(name, set);
+        handle.quant = &m_quant;
+        return handle;
+    }
+    TensorHandle getOutputHandle(const std::string& name, size_t set = 0) {
+        TensorHandle handle;
+        handle.desc = getOutputDesc(name);
+        if (nullptr == handle.desc || set >= m_bufferSets.size()) return TensorHandle();
+        handle.data = getOutputBuffer(name, set);
+        handle.quant = &m_quant;
+        return handle;
+    }
+
+    float* getInputTensor(const std::string& name, size_t set = 0) {
+        return Data(m_bufferSets.at(set).inputFloat, name);
+    }
+    float* getOutputTensor(const std::string& name, size_t set = 0) {
+        return Data(m_bufferSets.at(set).outputFloat, name);
+    }
+    uint8_t* getInputBuffer(const std::string& name, size_t set = 0) {
+        return USERBUFFER_TF8 == m_encoding ? Data(m_bufferSets.at(set).inputRaw, name)
+                                            : reinterpret_cast<uint8_t*>(getInputTensor(name, set));
+    }
+    uint8_t* getOutputBuffer(const std::string& name, size_t set = 0) {
+        return USERBUFFER_TF8 == m_encoding ? Data(m_bufferSets.at(set).outputRaw, name)
+                                            : reinterpret_cast<uint8_t*>(getOutputTensor(name, set));
+    }
+
+    userbuffer_encoding_t getInputEncoding(const std::string& name) {
+        (void)name;
+        return m_encoding;
+    }
+    userbuffer_encoding_t getOutputEncoding(const std::string& name) {
+        (void)name;
+        return m_encoding;
+    }
+    QuantParams getInputQuantParams(const std::string& name) {
+        (void)name;
+        return m_quant;
+    }
+    QuantParams getOutputQuantParams(const std::string& name, size_t set = 0) {
+        (void)name;
+        (void)set;
+        return m_quant;
+    }
+
+    bool isInit() {
+        return m_isInit;
+    }
+
+    bool execute(size_t set = 0) {
+        if (set >= m_bufferSets.size()) return false;
+        ScopedStage stage(m_profiler.get(), m_stageExecute);
+        if (m_execute_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(m_execute_us));
+        return true;
+    }
+
+private:
+    TensorDesc MakeDesc(const std::string& name, const std::vector<size_t>& shape) const {
+        TensorDesc desc;
+        desc.name = name;
+        desc.shape = shape;
+        desc.encoding = m_encoding;
+        desc.elementSize = USERBUFFER_TF8 == m_encoding ? sizeof(uint8_t) : sizeof(float);
+        desc.quant = m_quant;
+        desc.strides.resize(shape.size());
+        size_t stride = desc.elementSize;
+        for (size_t i = shape.size(); i > 0; i--) {
+            desc.strides[i - 1] = stride;
+            stride *= shape[i - 1];
+        }
+        return desc;
+    }
+
+    static const TensorDesc* FindDesc(const std::vector<TensorDesc>& descs, const std::string& name) {
+        for (const auto& desc : descs) {
+            if (desc.name == name) return &desc;
+        }
+        return nullptr;
+    }
+
+    template<typename T>
+    static T* Data(std::unordered_map<std::string, std::vector<T>>& tensors, const std::string& name) {
+        auto it = tensors.find(name);
+        return (it == tensors.end() || it->second.empty()) ? nullptr : it->second.data();
+    }
+
+    struct BufferSet {
+        std::unordered_map<std::string, std::vector<float>> inputFloat;
+        std::unordered_map<std::string, std::vector<uint8_t>> inputRaw;
+        std::unordered_map<std::string, std::vector<float>> outputFloat;
+        std::unordered_map<std::string, std::vector<uint8_t>> outputRaw;
+    };
+
+    bool m_isInit = false;
+    userbuffer_encoding_t m_encoding = USERBUFFER_FLOAT;
+    size_t m_batchSize = 1;
+    size_t m_bufferSetCount = 1;
+    std::vector<BufferSet> m_bufferSets;
+    std::vector<TensorDesc> m_inputDescs;
+    std::vector<TensorDesc> m_outputDescs;
+    QuantParams m_quant;
+    performance_profile_t m_profile = PROFILE_BURST;
+    int64_t m_execute_us = 0;
+
+    std::shared_ptr<StageProfiler> m_profiler;
+    std::string m_stageBuild;
+    std::string m_stageExecute;
+};
+
+}    // namespace snpetask
+
+#endif    // __SNPE_TASK_H__
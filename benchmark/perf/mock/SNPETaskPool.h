@@ -0,0 +1,118 @@
+/*
+ * @Description: SNPETaskPool stand-in building mock replicas, no SNPE needed.
+ * @version: 1.1
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 21:05:36
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 21:05:36
+ */
+
+#ifndef __SNPE_TASK_POOL_H__
+#define __SNPE_TASK_POOL_H__
+
+#include <vector>
+#include <string>
+
+#include "SNPETask.h"
+#include "TaskPool.h"
+
+namespace snpetask {
+
+/*
+ * Same interface as snpetask/SNPETaskPool.h, the leases, balancing and stats are
+ * the real TaskPool ones. SNPE only options are accepted and ignored.
+ */
+class SNPETaskPool : public TaskPool<SNPETask> {
+public:
+    SNPETaskPool() = default;
+    ~SNPETaskPool() {
+        deInit();
+    }
+
+    bool setOutputLayers(std::vector<std::string>& outputLayers) {
+        m_outputLayers = outputLayers;
+        return true;
+    }
+    bool setBatchSize(size_t batchSize) {
+        m_batchSize = batchSize;
+        return true;
+    }
+    bool setBufferSets(size_t count) {
+        m_bufferSets = count;
+        return true;
+    }
+    bool setInitCacheDir(const std::string&) {
+        return true;
+    }
+    bool setExecutionPriority(execution_priority_t) {
+        return true;
+    }
+    bool setCpuFixedPointMode(bool) {
+        return true;
+    }
+    bool setProfilingLevel(profiling_level_t) {
+        return true;
+    }
+    bool setDiagLogDir(const std::string&) {
+        return true;
+    }
+    bool setProfiler(std::shared_ptr<StageProfiler> profiler) {
+        m_profiler = profiler;
+        return true;
+    }
+    bool setPerformanceProfile(performance_profile_t profile) {
+        m_profile = profile;
+        bool ret = true;
+        for (size_t i = 0; m_isInit && i < Size(); i++) {
+            ret &= RunExclusive(i, [profile](SNPETask& task) {
+                return task.setPerformanceProfile(profile);
+            });
+        }
+        return ret;
+    }
+    performance_profile_t getPerformanceProfile() {
+        return m_profile;
+    }
+
+    bool init(const std::string& model_path, const std::vector<runtime_t>& runtimes,
+              const userbuffer_encoding_t encoding = USERBUFFER_FLOAT) {
+        for (size_t i = 0; i < runtimes.size(); i++) {
+            std::string name = "MOCK#" + std::to_string(i);
+            std::unique_ptr<SNPETask> task(new SNPETask());
+            task->setProfiler(m_profiler, name);
+            task->setOutputLayers(m_outputLayers);
+            task->setBatchSize(m_batchSize);
+            task->setBufferSets(0 == Size() ? m_bufferSets : 1);
+            task->setPerformanceProfile(m_profile);
+            if (!task->init(model_path, runtimes[i], encoding)) continue;
+            Add(std::move(task), name);
+        }
+        m_isInit = Size() > 0;
+        return m_isInit;
+    }
+
+    bool deInit() {
+        for (size_t i = 0; i < Size(); i++) {
+            At(i).deInit();
+        }
+        Clear();
+        m_isInit = false;
+        return true;
+    }
+
+    bool isInit() {
+        return m_isInit;
+    }
+
+private:
+    bool m_isInit = false;
+    std::vector<std::string> m_outputLayers;
+    size_t m_batchSize = 1;
+    size_t m_bufferSets = 1;
+    performance_profile_t m_profile = PROFILE_BURST;
+    std::shared_ptr<StageProfiler> m_profiler;
+};
+
+}    // namespace snpetask
+
+#endif    // __SNPE_TASK_POOL_H__
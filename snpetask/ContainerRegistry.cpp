@@ -0,0 +1,284 @@
+/*
+ * @Description: Memory mapped DLC containers shared by the tasks, and their init caches.
+ * @version: 1.4
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 19:02:16
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 19:02:16
+ */
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#if !defined(WIN32) && !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "SNPE/SNPEUtil.h"
+#include "DlSystem/DlVersion.h"
+#include "DlSystem/DlError.h"
+
+#include "ContainerRegistry.h"
+
+namespace snpetask {
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+#if defined(WIN32) || defined(_WIN32)
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    m_buffer.resize((size_t)in.tellg());
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size())) {
+        m_buffer.clear();
+        return false;
+    }
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (MAP_FAILED == addr) return false;
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const uint8_t*>(addr);
+    m_size = st.st_size;
+    m_mapped = true;
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+#if !defined(WIN32) && !defined(_WIN32)
+    if (m_mapped) munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
+
+SharedContainer::~SharedContainer()
+{
+    if (nullptr != m_handle) Snpe_DlContainer_Delete(m_handle);
+}
+
+ContainerRegistry& ContainerRegistry::instance()
+{
+    static ContainerRegistry registry;
+    return registry;
+}
+
+static std::string canonicalPath(const std::string& path)
+{
+    std::error_code ec;
+    std::string canonical = std::filesystem::weakly_canonical(path, ec).string();
+    return ec ? path : canonical;
+}
+
+static std::string runtimesListPath(const std::string& cachePath)
+{
+    return cachePath + ".runtimes";
+}
+
+bool SharedContainer::hasInitCache(const std::string& runtimes)
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+    return m_cachedRuntimes.count(runtimes) > 0;
+}
+
+std::shared_ptr<SharedContainer> ContainerRegistry::open(const std::string& model_path, const std::string& cachePath)
+{
+    // Keyed by the cache when there is one: it names the model and the build config.
+    std::string key = canonicalPath(cachePath.empty() ? model_path : cachePath);
+
+    std::lock_guard<std::mutex> locker(m_mutex);
+    auto iter = m_containers.find(key);
+    if (iter != m_containers.end()) {
+        if (auto container = iter->second.lock()) {
+            LOG_INFO("Share opened container {}.", container->path());
+            return container;
+        }
+    }
+
+    std::shared_ptr<SharedContainer> container;
+    std::error_code ec;
+    if (!cachePath.empty() && std::filesystem::exists(cachePath, ec)) {
+        if ((container = openFile(cachePath))) {
+            container->m_isInitCache = true;
+            std::ifstream list(runtimesListPath(cachePath));
+            std::string runtimes;
+            while (std::getline(list, runtimes)) {
+                if (!runtimes.empty()) container->m_cachedRuntimes.insert(runtimes);
+            }
+        } else {
+            LOG_WARN("Can't open init cache {}, remove it and open {}.", cachePath, model_path);
+            std::filesystem::remove(cachePath, ec);
+            std::filesystem::remove(runtimesListPath(cachePath), ec);
+        }
+    }
+    if (!container && !(container = openFile(model_path))) return nullptr;
+
+    m_containers[key] = container;
+    return container;
+}
+
+void ContainerRegistry::discardInitCache(const std::string& cachePath)
+{
+    LOG_WARN("Remove init cache {}, the model file is read again.", cachePath);
+    std::error_code ec;
+    std::filesystem::remove(cachePath, ec);
+    std::filesystem::remove(runtimesListPath(cachePath), ec);
+
+    std::lock_guard<std::mutex> locker(m_mutex);
+    m_containers.erase(canonicalPath(cachePath));
+}
+
+std::shared_ptr<SharedContainer> ContainerRegistry::openFile(const std::string& path)
+{
+    std::shared_ptr<SharedContainer> container(new SharedContainer());
+    container->m_path = canonicalPath(path);
+    if (!container->m_file.open(path)) {
+        LOG_ERROR("Can't map model file {}.", path);
+        return nullptr;
+    }
+    container->m_handle = Snpe_DlContainer_OpenBuffer(container->m_file.data(), container->m_file.size());
+    if (nullptr == container->m_handle) {
+        LOG_ERROR("Can't open model container {}: {}", path, Snpe_ErrorCode_GetLastErrorString());
+        return nullptr;
+    }
+
+    return container;
+}
+
+static uint64_t hashString(const std::string& str, uint64_t hash = 0xcbf29ce484222325ULL)
+{
+    for (unsigned char ch : str) hash = (hash ^ ch) * 0x100000001b3ULL;
+    return hash;
+}
+
+// Size and modification time only: reading the whole DLC would cost what the cache saves.
+uint64_t hashFileStamp(const std::string& path)
+{
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) return 0;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return 0;
+
+    return hashString(std::to_string(size) + ":" + std::to_string(mtime.time_since_epoch().count()));
+}
+
+std::string initCachePath(const std::string& cacheDir, const std::string& model_path,
+                          const std::vector<std::string>& outputLayers,
+                          size_t batchSize, userbuffer_encoding_t encoding, bool cpuFixedPoint)
+{
+    uint64_t modelHash = hashFileStamp(model_path);
+    if (0 == modelHash) return "";
+
+    Snpe_DlVersion_Handle_t versionHandle = Snpe_Util_GetLibraryVersion();
+    uint64_t configHash = hashString(Snpe_DlVersion_ToString(versionHandle));
+    Snpe_DlVersion_Delete(versionHandle);
+    for (auto& layer : outputLayers) configHash = hashString(layer + ";", configHash);
+    configHash = hashString("batch=" + std::to_string(batchSize) +
+                            ";encoding=" + std::to_string((int)encoding) +
+                            ";cpu-fixed-point=" + std::to_string((int)cpuFixedPoint) + ";", configHash);
+
+    std::ostringstream name;
+    name << std::filesystem::path(model_path).stem().string() << "-"
+         << std::hex << std::setw(16) << std::setfill('0') << modelHash << "-"
+         << std::setw(16) << configHash << ".dlc";
+
+    return (std::filesystem::path(cacheDir) / name.str()).string();
+}
+
+bool saveInitCache(SharedContainer& container, const std::string& cachePath, const std::string& runtimes)
+{
+    std::error_code ec;
+    std::filesystem::path path(cachePath);
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    std::lock_guard<std::mutex> locker(container.m_mutex);
+    std::string tmpPath = cachePath + ".tmp";
+    if (SNPE_SUCCESS != Snpe_DlContainer_Save(container.handle(), tmpPath.c_str())) {
+        LOG_ERROR("Can't save init cache {}: {}", tmpPath, Snpe_ErrorCode_GetLastErrorString());
+        return false;
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        LOG_ERROR("Can't move init cache to {}: {}", cachePath, ec.message());
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    // Rewritten from the container, a list left by an older cache at the same path goes.
+    container.m_cachedRuntimes.insert(runtimes);
+    std::string listPath = runtimesListPath(cachePath);
+    {
+        std::ofstream list(listPath + ".tmp", std::ios::trunc);
+        for (auto& name : container.m_cachedRuntimes) list << name << "\n";
+        if (!list.good()) {
+            LOG_ERROR("Can't write init cache runtimes {}.", listPath);
+            return false;
+        }
+    }
+    std::filesystem::rename(listPath + ".tmp", listPath, ec);
+    if (ec) {
+        LOG_ERROR("Can't move init cache runtimes to {}: {}", listPath, ec.message());
+        std::filesystem::remove(listPath + ".tmp", ec);
+        return false;
+    }
+
+    return true;
+}
+
+std::string runtimeListName(const std::vector<runtime_t>& runtimes)
+{
+    std::string name;
+    for (auto runtime : runtimes) {
+        if (!name.empty()) name += "-";
+        name += runtimeName(runtime);
+    }
+    return name;
+}
+
+const char* runtimeName(runtime_t runtime)
+{
+    switch (runtime) {
+        case CPU:
+            return "CPU";
+        case GPU:
+            return "GPU";
+        case GPU_FLOAT16:
+            return "GPU_FLOAT16";
+        case DSP:
+            return "DSP";
+        case DSP_FIXED8:
+            return "DSP_FIXED8";
+        case AIP:
+            return "AIP";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+}    // namespace snpetask
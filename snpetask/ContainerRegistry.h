@@ -0,0 +1,152 @@
+/*
+ * @Description: Memory mapped DLC containers shared by the tasks, and their init caches.
+ * @version: 1.4
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 19:02:16
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 19:02:16
+ */
+
+#ifndef __CONTAINER_REGISTRY_H__
+#define __CONTAINER_REGISTRY_H__
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <mutex>
+#include <cstdint>
+
+#include "DlContainer/DlContainer.h"
+
+#include "utils.h"
+
+namespace snpetask {
+
+/**
+ * @brief: Read only view of a whole file, mmap() where available, read into memory otherwise.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const uint8_t* data() const {
+        return m_data;
+    }
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_mapped = false;
+    std::vector<uint8_t> m_buffer;
+};
+
+/**
+ * @brief: An opened DLC, the file stays mapped as long as the container lives.
+ */
+class SharedContainer {
+public:
+    ~SharedContainer();
+
+    Snpe_DlContainer_Handle_t handle() const {
+        return m_handle;
+    }
+    // The file the container was opened from.
+    const std::string& path() const {
+        return m_path;
+    }
+    // Opened from an init cache rather than from the model file.
+    bool isInitCache() const {
+        return m_isInitCache;
+    }
+    // The networks of the runtime list, see runtimeListName(), are recorded in the init cache.
+    bool hasInitCache(const std::string& runtimes);
+
+private:
+    friend class ContainerRegistry;
+    friend bool saveInitCache(SharedContainer& container, const std::string& cachePath,
+                              const std::string& runtimes);
+    SharedContainer() = default;
+
+    std::string m_path;
+    MappedFile m_file;
+    Snpe_DlContainer_Handle_t m_handle = nullptr;
+    bool m_isInitCache = false;
+
+    std::mutex m_mutex;
+    std::set<std::string> m_cachedRuntimes;
+};
+
+/**
+ * @brief: Detectors of the same model file share one opened container, whatever runtimes
+ * they build on it. With an init cache the container is the cache file, which records
+ * the networks of every runtime list built on it.
+ */
+class ContainerRegistry {
+public:
+    static ContainerRegistry& instance();
+
+    /**
+     * @brief: Open cachePath if it exists, model_path otherwise, or return the container
+     * already opened for them. A cache failing to open is removed and model_path opened.
+     * @param {string} cachePath: initCachePath() of the model, "" without init cache.
+     * @return {std::shared_ptr<SharedContainer>} nullptr if it can't be opened.
+     */
+    std::shared_ptr<SharedContainer> open(const std::string& model_path, const std::string& cachePath = "");
+
+    /**
+     * @brief: Remove a cache the networks failed to build from, the next open() of it
+     * reads the model file again. Holders of the old container keep it.
+     */
+    void discardInitCache(const std::string& cachePath);
+
+private:
+    ContainerRegistry() = default;
+
+    std::shared_ptr<SharedContainer> openFile(const std::string& path);
+
+    std::mutex m_mutex;
+    std::map<std::string, std::weak_ptr<SharedContainer>> m_containers;
+};
+
+/**
+ * @brief: Hash of the size and modification time of a file, 0 if it can't be stat'ed.
+ */
+uint64_t hashFileStamp(const std::string& path);
+
+/**
+ * @brief: Init cache file of model_path in cacheDir. The name holds the size/mtime hash of
+ * the model, the SNPE version, the output layers, the batch size, the user buffer encoding
+ * and the CPU fixed point mode: any change misses the cache. Runtime lists share the file,
+ * each one adds its networks to it.
+ */
+std::string initCachePath(const std::string& cacheDir, const std::string& model_path,
+                          const std::vector<std::string>& outputLayers,
+                          size_t batchSize, userbuffer_encoding_t encoding, bool cpuFixedPoint);
+
+/**
+ * @brief: Save a container holding the init caches of the networks built on it, and
+ * record runtimes in the "<cachePath>.runtimes" list next to it. Written aside then
+ * renamed, so a killed process never leaves a broken cache.
+ */
+bool saveInitCache(SharedContainer& container, const std::string& cachePath, const std::string& runtimes);
+
+// e.g. "DSP-GPU" for {DSP, GPU}.
+std::string runtimeListName(const std::vector<runtime_t>& runtimes);
+
+const char* runtimeName(runtime_t runtime);
+
+}    // namespace snpetask
+
+#endif    // __CONTAINER_REGISTRY_H__
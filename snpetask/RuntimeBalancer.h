@@ -0,0 +1,151 @@
+/*
+ * @Description: Routes frames across runtime replicas by expected completion time.
+ * @version: 1.4
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 18:02:47
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 18:02:47
+ */
+
+#ifndef __RUNTIME_BALANCER_H__
+#define __RUNTIME_BALANCER_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+namespace snpetask {
+
+/**
+ * @brief: Balancer config info.
+ */
+struct BalancerConfig {
+    // Weight of the newest latency sample in the moving average.
+    double alpha = 0.2;
+    // An idle replica not picked for the last 1 / floorShare frames takes one as a probe,
+    // keeping the latency of a slow runtime fresh. 0 to disable.
+    double floorShare = 0.0;
+    // Smoothing of Share(), about the last 1 / shareDecay frames count.
+    double shareDecay = 1.0 / 32;
+};
+
+/**
+ * @brief: Picks the replica finishing a new frame first: (frames queued or running + 1)
+ * x moving average latency. Replicas without a sample yet are probed first.
+ * Not thread safe, TaskPool calls it under its own lock.
+ */
+class RuntimeBalancer {
+public:
+    explicit RuntimeBalancer(size_t replicas, const BalancerConfig& config = BalancerConfig()) :
+        m_config(config), m_replicas(replicas) {}
+
+    size_t Size() const {
+        return m_replicas.size();
+    }
+
+    size_t Pick() {
+        size_t best = 0;
+
+        // Never measured: its latency is unknown, try it once it is idle.
+        for (size_t i = 0; i < m_replicas.size(); i++) {
+            if (0 == m_replicas[i].samples && 0 == m_replicas[i].pending) return Chosen(i);
+        }
+
+        // Probe: the idle replica unpicked the longest once it missed ceil(1 / floorShare)
+        // frames. Idle only, or a runtime slower than floorShare x arrival rate would queue forever.
+        if (m_config.floorShare > 0.0) {
+            uint64_t period = (uint64_t)std::ceil(1.0 / m_config.floorShare);
+            uint64_t oldest = m_picks;
+            bool isProbe = false;
+            for (size_t i = 0; i < m_replicas.size(); i++) {
+                if (0 == m_replicas[i].pending && m_picks - m_replicas[i].lastPick >= period &&
+                    m_replicas[i].lastPick < oldest) {
+                    oldest = m_replicas[i].lastPick;
+                    best = i;
+                    isProbe = true;
+                }
+            }
+            if (isProbe) return Chosen(best);
+        }
+
+        // A busy replica without a sample would cost 0 and take every frame until its
+        // first one is done, skip it. All of them in that state: the shortest queue.
+        double bestCost = -1.0;
+        for (size_t i = 0; i < m_replicas.size(); i++) {
+            if (0 == m_replicas[i].samples) continue;
+            double cost = ExpectedCompletion(i);
+            if (bestCost < 0.0 || cost < bestCost) {
+                bestCost = cost;
+                best = i;
+            }
+        }
+        if (bestCost < 0.0) {
+            for (size_t i = 1; i < m_replicas.size(); i++) {
+                if (m_replicas[i].pending < m_replicas[best].pending) best = i;
+            }
+        }
+        return Chosen(best);
+    }
+
+    // A frame is queued on or running on replica i.
+    void Begin(size_t i) {
+        m_replicas[i].pending++;
+    }
+
+    // The frame is done after latency_ms on replica i. Without sample the latency
+    // doesn't span a whole frame and is left out of the average.
+    void End(size_t i, double latency_ms, bool sample = true) {
+        Replica& replica = m_replicas[i];
+        if (replica.pending > 0) replica.pending--;
+        if (!sample) return;
+        replica.latency_ms = replica.samples ? replica.latency_ms + m_config.alpha * (latency_ms - replica.latency_ms)
+                                             : latency_ms;
+        replica.samples++;
+    }
+
+    // Time for replica i to finish its queue plus one more frame.
+    double ExpectedCompletion(size_t i) const {
+        return (m_replicas[i].pending + 1) * m_replicas[i].latency_ms;
+    }
+
+    double Latency(size_t i) const {
+        return m_replicas[i].latency_ms;
+    }
+
+    size_t Pending(size_t i) const {
+        return m_replicas[i].pending;
+    }
+
+    // Recent share of the picks, [0.0f, 1.0f]
+    double Share(size_t i) const {
+        return m_replicas[i].share;
+    }
+
+private:
+    struct Replica {
+        size_t pending = 0;
+        uint64_t samples = 0;
+        double latency_ms = 0.0;
+        double share = 0.0;
+        // Value of m_picks when last picked.
+        uint64_t lastPick = 0;
+    };
+
+    size_t Chosen(size_t chosen) {
+        m_picks++;
+        m_replicas[chosen].lastPick = m_picks;
+        for (size_t i = 0; i < m_replicas.size(); i++) {
+            m_replicas[i].share += m_config.shareDecay * ((i == chosen ? 1.0 : 0.0) - m_replicas[i].share);
+        }
+        return chosen;
+    }
+
+    BalancerConfig m_config;
+    std::vector<Replica> m_replicas;
+    uint64_t m_picks = 0;
+};
+
+}    // namespace snpetask
+
+#endif    // __RUNTIME_BALANCER_H__
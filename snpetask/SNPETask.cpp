@@ -1,6 +1,6 @@
 /*
  * @Description: Inference SDK based on SNPE.
- * @version: 1.1
+ * @version: 1.5
  * @Author: Ricardo Lu<shenglu1202@163.com>
  * @Date: 2022-05-18 09:48:36
  * @LastEditors: Ricardo Lu
@@ -8,55 +8,173 @@
  */
 
 
+#include <filesystem>
+
 #include "SNPETask.h"
 
 namespace snpetask{
 
-static size_t calcSizeFromDims(const size_t* dims, size_t rank, size_t elementSize)
+// Tightly packed layout of a tensor of the network, strides in bytes.
+// For example, a float tensor of dimension 2x4x3 has the strides (48,12,4).
+static TensorDesc createTensorDesc(const char* name, Snpe_TensorShape_Handle_t bufferShapeHandle,
+                                   userbuffer_encoding_t encoding)
 {
-    if (rank == 0) return 0;
-    size_t size = elementSize;
-    while (rank--) {
-        size *= *dims;
-        dims++;
+    TensorDesc desc;
+    desc.name = name;
+    desc.encoding = encoding;
+    desc.elementSize = USERBUFFER_TF8 == encoding ? sizeof(uint8_t) : sizeof(float);
+    size_t rank = Snpe_TensorShape_Rank(bufferShapeHandle);
+    for (size_t i = 0; i < rank; i++) {
+        desc.shape.push_back(Snpe_TensorShape_At(bufferShapeHandle, i));
+    }
+    desc.strides.resize(rank);
+    size_t stride = desc.elementSize;
+    for (size_t i = rank; i > 0; i--) {
+        desc.strides[i - 1] = stride;
+        stride *= desc.shape[i - 1];
     }
-    return size;
+    return desc;
 }
 
 static void createUserBuffer(Snpe_UserBufferMap_Handle_t userBufferMapHandle,
-                      std::unordered_map<std::string, std::vector<uint8_t>>& applicationBuffers,
+                      std::unordered_map<std::string, TensorBuffer>& applicationBuffers,
                       std::vector<Snpe_IUserBuffer_Handle_t>& snpeUserBackedBuffersHandle,
-                      Snpe_TensorShape_Handle_t bufferShapeHandle,
-                      const char* name,
-                      size_t bufferElementSize)
-{
-    // Calculate the stride based on buffer strides, assuming tightly packed.
-    // Note: Strides = Number of bytes to advance to the next element in each dimension.
-    // For example, if a float tensor of dimension 2x4x3 is tightly packed in a buffer of 96 bytes, then the strides would be (48,12,4)
-    // Note: Buffer stride is usually known and does not need to be calculated.
-    std::vector<size_t> strides(Snpe_TensorShape_Rank(bufferShapeHandle));
-    strides[strides.size() - 1] = sizeof(float);
-    size_t stride = strides[strides.size() - 1];
-    for (size_t i = Snpe_TensorShape_Rank(bufferShapeHandle) - 1; i > 0; i--)
-    {
-        stride *= Snpe_TensorShape_At(bufferShapeHandle, i);
-        strides[i - 1] = stride;
-    }
-    Snpe_TensorShape_Handle_t stridesHandle = Snpe_TensorShape_CreateDimsSize(strides.data(), Snpe_TensorShape_Rank(bufferShapeHandle));
-    size_t bufSize = calcSizeFromDims(Snpe_TensorShape_GetDimensions(bufferShapeHandle), Snpe_TensorShape_Rank(bufferShapeHandle), bufferElementSize);
+                      const TensorDesc& desc,
+                      Snpe_UserBufferEncoding_Handle_t userBufferEncodingHandle)
+{
+    const char* name = desc.name.c_str();
+    Snpe_TensorShape_Handle_t stridesHandle = Snpe_TensorShape_CreateDimsSize(desc.strides.data(), desc.strides.size());
+    size_t bufSize = desc.bytes();
     LOG_INFO("Create [{}] buffer size: {}.", name, bufSize);
-    // set the buffer encoding type
-    Snpe_UserBufferEncoding_Handle_t userBufferEncodingFloatHandle = Snpe_UserBufferEncodingFloat_Create();
     // create user-backed storage to load input data onto it
-    applicationBuffers.emplace(name, std::vector<uint8_t>(bufSize));
+    applicationBuffers.emplace(name, TensorBuffer(bufSize));
     // create SNPE user buffer from the user-backed buffer
     snpeUserBackedBuffersHandle.push_back(Snpe_Util_CreateUserBuffer(applicationBuffers.at(name).data(),
                                                   bufSize,
                                                   stridesHandle,
-                                                  userBufferEncodingFloatHandle));
+                                                  userBufferEncodingHandle));
     // add the user-backed buffer to the inputMap, which is later on fed to the network for execution
     Snpe_UserBufferMap_Add(userBufferMapHandle, name, snpeUserBackedBuffersHandle.back());
-    Snpe_UserBufferEncodingFloat_Delete(userBufferEncodingFloatHandle);
+    Snpe_TensorShape_Delete(stridesHandle);
+}
+
+static const TensorDesc* findTensorDesc(const std::vector<TensorDesc>& descs, const std::string& name)
+{
+    for (const auto& desc : descs) {
+        if (desc.name == name) return &desc;
+    }
+    return nullptr;
+}
+
+static bool isTfNEncoding(Snpe_UserBufferEncoding_Handle_t encodingHandle)
+{
+    auto elementType = Snpe_UserBufferEncoding_GetElementType(encodingHandle);
+    return SNPE_USERBUFFERENCODING_ELEMENTTYPE_TF8 == elementType ||
+           SNPE_USERBUFFERENCODING_ELEMENTTYPE_TFN == elementType;
+}
+
+// Build a throwaway CPU network to read the input dimensions of the model,
+// and return them with the batch dimension resized.
+static Snpe_TensorShapeMap_Handle_t createBatchedInputShapes(Snpe_DlContainer_Handle_t container,
+                      Snpe_StringList_Handle_t outputLayers,
+                      size_t batchSize)
+{
+    Snpe_SNPEBuilder_Handle_t probeBuilderHandle = Snpe_SNPEBuilder_Create(container);
+    Snpe_RuntimeList_Handle_t probeRuntimeList = Snpe_RuntimeList_Create();
+    Snpe_RuntimeList_Add(probeRuntimeList, SNPE_RUNTIME_CPU);
+    Snpe_SNPEBuilder_SetRuntimeProcessorOrder(probeBuilderHandle, probeRuntimeList);
+    if (nullptr != outputLayers) Snpe_SNPEBuilder_SetOutputLayers(probeBuilderHandle, outputLayers);
+    Snpe_SNPE_Handle_t probeHandle = Snpe_SNPEBuilder_Build(probeBuilderHandle);
+    Snpe_RuntimeList_Delete(probeRuntimeList);
+    Snpe_SNPEBuilder_Delete(probeBuilderHandle);
+    if (nullptr == probeHandle) {
+        LOG_ERROR("Probe build failed: {}", Snpe_ErrorCode_GetLastErrorString());
+        return nullptr;
+    }
+
+    Snpe_TensorShapeMap_Handle_t inputShapeMapHandle = Snpe_TensorShapeMap_Create();
+    Snpe_StringList_Handle_t inputNamesHandle = Snpe_SNPE_GetInputTensorNames(probeHandle);
+    for (size_t i = 0; i < Snpe_StringList_Size(inputNamesHandle); ++i) {
+        const char* name = Snpe_StringList_At(inputNamesHandle, i);
+        auto bufferAttributesOptHandle = Snpe_SNPE_GetInputOutputBufferAttributes(probeHandle, name);
+        if (nullptr == bufferAttributesOptHandle) {
+            LOG_ERROR("Error obtaining attributes for input tensor: {}", name);
+            Snpe_TensorShapeMap_Delete(inputShapeMapHandle);
+            Snpe_StringList_Delete(inputNamesHandle);
+            Snpe_SNPE_Delete(probeHandle);
+            return nullptr;
+        }
+        auto bufferShapeHandle = Snpe_IBufferAttributes_GetDims(bufferAttributesOptHandle);
+
+        std::vector<size_t> dims;
+        for (size_t j = 0; j < Snpe_TensorShape_Rank(bufferShapeHandle); j++) {
+            dims.push_back(Snpe_TensorShape_At(bufferShapeHandle, j));
+        }
+        dims[0] = batchSize;
+        LOG_INFO("Resize input [{}] batch dimension to {}.", name, batchSize);
+
+        Snpe_TensorShape_Handle_t batchedShapeHandle = Snpe_TensorShape_CreateDimsSize(dims.data(), dims.size());
+        Snpe_TensorShapeMap_Add(inputShapeMapHandle, name, batchedShapeHandle);
+        Snpe_TensorShape_Delete(batchedShapeHandle);
+        Snpe_TensorShape_Delete(bufferShapeHandle);
+        Snpe_IBufferAttributes_Delete(bufferAttributesOptHandle);
+    }
+    Snpe_StringList_Delete(inputNamesHandle);
+    Snpe_SNPE_Delete(probeHandle);
+
+    return inputShapeMapHandle;
+}
+
+static Snpe_PerformanceProfile_t snpeProfile(performance_profile_t profile)
+{
+    switch (profile) {
+        case PROFILE_BURST:
+            return SNPE_PERFORMANCE_PROFILE_BURST;
+        case PROFILE_HIGH_PERFORMANCE:
+            return SNPE_PERFORMANCE_PROFILE_HIGH_PERFORMANCE;
+        case PROFILE_SUSTAINED_HIGH_PERFORMANCE:
+            return SNPE_PERFORMANCE_PROFILE_SUSTAINED_HIGH_PERFORMANCE;
+        case PROFILE_BALANCED:
+            return SNPE_PERFORMANCE_PROFILE_BALANCED;
+        case PROFILE_LOW_BALANCED:
+            return SNPE_PERFORMANCE_PROFILE_LOW_BALANCED;
+        case PROFILE_HIGH_POWER_SAVER:
+            return SNPE_PERFORMANCE_PROFILE_HIGH_POWER_SAVER;
+        case PROFILE_POWER_SAVER:
+            return SNPE_PERFORMANCE_PROFILE_POWER_SAVER;
+        case PROFILE_LOW_POWER_SAVER:
+            return SNPE_PERFORMANCE_PROFILE_LOW_POWER_SAVER;
+        case PROFILE_EXTREME_POWER_SAVER:
+            return SNPE_PERFORMANCE_PROFILE_EXTREME_POWER_SAVER;
+        default:
+            return SNPE_PERFORMANCE_PROFILE_DEFAULT;
+    }
+}
+
+static Snpe_ProfilingLevel_t snpeProfilingLevel(profiling_level_t level)
+{
+    switch (level) {
+        case PROFILING_BASIC:
+            return SNPE_PROFILING_LEVEL_BASIC;
+        case PROFILING_MODERATE:
+            return SNPE_PROFILING_LEVEL_MODERATE;
+        case PROFILING_DETAILED:
+            return SNPE_PROFILING_LEVEL_DETAILED;
+        default:
+            return SNPE_PROFILING_LEVEL_OFF;
+    }
+}
+
+static Snpe_ExecutionPriorityHint_t snpePriority(execution_priority_t priority)
+{
+    switch (priority) {
+        case PRIORITY_HIGH:
+            return SNPE_EXECUTION_PRIORITY_HIGH;
+        case PRIORITY_LOW:
+            return SNPE_EXECUTION_PRIORITY_LOW;
+        default:
+            return SNPE_EXECUTION_PRIORITY_NORMAL;
+    }
 }
 
 SNPETask::SNPETask()
@@ -69,8 +187,6 @@ SNPETask::SNPETask()
     m_snpe = nullptr;
     m_runtimeList = nullptr;
     m_outputLayers = nullptr;
-    m_inputUserBufferMap = nullptr;
-    m_outputUserBufferMap = nullptr;
 }
 
 SNPETask::~SNPETask()
@@ -78,8 +194,55 @@ SNPETask::~SNPETask()
 
 }
 
-bool SNPETask::init(const std::string& model_path, const runtime_t runtime)
+bool SNPETask::init(const std::string& model_path, const runtime_t runtime,
+                    const userbuffer_encoding_t encoding)
+{
+    int64_t start = GetTimeStamp_ms();
+    std::string cachePath;
+    std::string runtimes = runtimeListName({runtime});
+    if (!m_initCacheDir.empty()) {
+        cachePath = initCachePath(m_initCacheDir, model_path, m_outputLayerNames,
+                                  m_batchSize, encoding, m_cpuFixedPoint);
+    }
+    int64_t keyed = GetTimeStamp_ms();
+
+    m_sharedContainer = ContainerRegistry::instance().open(model_path, cachePath);
+    if (!m_sharedContainer) return false;
+    bool isCached = m_sharedContainer->hasInitCache(runtimes);
+    int64_t opened = GetTimeStamp_ms();
+    if (m_profiler) m_profiler->record(m_stageOpen, (opened - keyed) * 1000);
+
+    if (!init(m_sharedContainer->handle(), runtime, encoding)) {
+        if (!m_sharedContainer->isInitCache()) return false;
+
+        // A broken or stale cache: build from the model again, which rewrites the cache.
+        LOG_WARN("SNPETask can't build from init cache {}, retry from {}.", cachePath, model_path);
+        deInit();
+        ContainerRegistry::instance().discardInitCache(cachePath);
+        m_sharedContainer = ContainerRegistry::instance().open(model_path, cachePath);
+        if (!m_sharedContainer) return false;
+        isCached = false;
+        if (!init(m_sharedContainer->handle(), runtime, encoding)) return false;
+    }
+    int64_t built = GetTimeStamp_ms();
+
+    if (!isCached && !cachePath.empty() && saveInitCache(*m_sharedContainer, cachePath, runtimes)) {
+        LOG_INFO("Saved init cache {} of {}.", cachePath, runtimes);
+    }
+
+    LOG_INFO("SNPETask init {} ms: cache key {} ms, open {} ms{}, build {} ms, cache save {} ms.",
+        GetTimeStamp_ms() - start, keyed - start, opened - keyed, isCached ? " (init cache hit)" : "",
+        built - opened, GetTimeStamp_ms() - built);
+    return true;
+}
+
+bool SNPETask::init(Snpe_DlContainer_Handle_t container, const runtime_t runtime,
+                    const userbuffer_encoding_t encoding)
 {
+    m_encoding = encoding;
+    m_container = container;
+    int64_t start = GetTimeStamp_ms();
+
     switch (runtime) {
         case CPU:
             m_runtime = SNPE_RUNTIME_CPU;
@@ -109,33 +272,78 @@ bool SNPETask::init(const std::string& model_path, const runtime_t runtime)
         m_runtime = SNPE_RUNTIME_CPU;
     }
 
-    m_container = Snpe_DlContainer_Open(model_path.c_str());
     Snpe_SNPEBuilder_Handle_t snpeBuilderHandle = Snpe_SNPEBuilder_Create(m_container);
-    Snpe_PerformanceProfile_t profile = SNPE_PERFORMANCE_PROFILE_BURST;
     if (nullptr == m_runtimeList) m_runtimeList = Snpe_RuntimeList_Create();
     Snpe_RuntimeList_Add(m_runtimeList, m_runtime);
     Snpe_RuntimeList_Add(m_runtimeList, SNPE_RUNTIME_CPU);
     Snpe_SNPEBuilder_SetRuntimeProcessorOrder(snpeBuilderHandle, m_runtimeList);
     if (Snpe_SNPEBuilder_SetOutputLayers(snpeBuilderHandle, m_outputLayers)) {
         LOG_ERROR("Snpe_SNPEBuilder_SetOutputLayers failed: {}", Snpe_ErrorCode_GetLastErrorString());
+        Snpe_SNPEBuilder_Delete(snpeBuilderHandle);
         return false;
     }
+    Snpe_TensorShapeMap_Handle_t inputShapeMapHandle = nullptr;
+    if (m_batchSize > 1) {
+        if (nullptr == (inputShapeMapHandle = createBatchedInputShapes(m_container, m_outputLayers, m_batchSize))) {
+            LOG_ERROR("Can't resize input dimensions to batch {}", m_batchSize);
+            Snpe_SNPEBuilder_Delete(snpeBuilderHandle);
+            return false;
+        }
+        Snpe_SNPEBuilder_SetInputDimensions(snpeBuilderHandle, inputShapeMapHandle);
+    }
     Snpe_SNPEBuilder_SetUseUserSuppliedBuffers(snpeBuilderHandle, true);
-    Snpe_SNPEBuilder_SetPerformanceProfile(snpeBuilderHandle, profile);
+    Snpe_SNPEBuilder_SetPerformanceProfile(snpeBuilderHandle, snpeProfile(m_profile));
+    Snpe_SNPEBuilder_SetExecutionPriorityHint(snpeBuilderHandle, snpePriority(m_priority));
+    Snpe_SNPEBuilder_SetCpuFixedPointMode(snpeBuilderHandle, m_cpuFixedPoint);
+    if (PROFILING_OFF != m_profilingLevel &&
+        SNPE_SUCCESS != Snpe_SNPEBuilder_SetProfilingLevel(snpeBuilderHandle, snpeProfilingLevel(m_profilingLevel))) {
+        LOG_WARN("Set profiling level failed: {}", Snpe_ErrorCode_GetLastErrorString());
+    }
+    // Reuses the prepared graph stored in the container, or records one to be saved.
+    if (!m_initCacheDir.empty() && SNPE_SUCCESS != Snpe_SNPEBuilder_SetInitCacheMode(snpeBuilderHandle, true)) {
+        LOG_WARN("Init cache not supported: {}", Snpe_ErrorCode_GetLastErrorString());
+    }
     m_snpe = Snpe_SNPEBuilder_Build(snpeBuilderHandle);
+    int64_t built = GetTimeStamp_ms();
+    // The built network doesn't need its builder, every error path below is covered.
+    Snpe_SNPEBuilder_Delete(snpeBuilderHandle);
+    if (nullptr != inputShapeMapHandle) Snpe_TensorShapeMap_Delete(inputShapeMapHandle);
     if (nullptr == m_snpe) {
         const char* errStr = Snpe_ErrorCode_GetLastErrorString();
         LOG_ERROR("SNPE build failed: {}", errStr);
         return false;
     }
+    if (m_profiler) m_profiler->record(m_stageBuild, (built - start) * 1000);
+
+    if (!m_diagLogDir.empty()) {
+        m_diagLog = Snpe_SNPE_GetDiagLogInterface_Ref(m_snpe);
+        Snpe_Options_Handle_t optionsHandle = Snpe_IDiagLog_GetOptions(m_diagLog);
+        Snpe_Options_SetLogFileDirectory(optionsHandle, m_diagLogDir.c_str());
+        // Keep a bounded history on long runs.
+        Snpe_Options_SetLogFileRotateCount(optionsHandle, 4);
+        if (SNPE_SUCCESS != Snpe_IDiagLog_SetOptions(m_diagLog, optionsHandle) ||
+            SNPE_SUCCESS != Snpe_IDiagLog_Start(m_diagLog)) {
+            LOG_WARN("Can't start the diagnostic log in {}: {}", m_diagLogDir, Snpe_ErrorCode_GetLastErrorString());
+            m_diagLog = nullptr;
+        } else {
+            LOG_INFO("SNPE diagnostic log in {}.", m_diagLogDir);
+        }
+        Snpe_Options_Delete(optionsHandle);
+    }
 
     // get input tensor names of the network that need to be populated
     Snpe_StringList_Handle_t inputNamesHandle = Snpe_SNPE_GetInputTensorNames(m_snpe);
     if (nullptr == inputNamesHandle) throw std::runtime_error("Error obtaining input tensor names");
     assert(Snpe_StringList_Size(inputNamesHandle) > 0);
 
+    // every buffer set owns its storage and user buffer maps
+    m_bufferSets = std::vector<BufferSet>(m_bufferSetCount);
+    for (auto& bufferSet : m_bufferSets) {
+        bufferSet.inputUserBufferMap = Snpe_UserBufferMap_Create();
+        bufferSet.outputUserBufferMap = Snpe_UserBufferMap_Create();
+    }
+
     // create SNPE user buffers for each application storage buffer
-    if (nullptr == m_inputUserBufferMap) m_inputUserBufferMap = Snpe_UserBufferMap_Create();
     for (size_t i = 0; i < Snpe_StringList_Size(inputNamesHandle); ++i) {
         const char* name = Snpe_StringList_At(inputNamesHandle, i);
         // get attributes of buffer by name
@@ -146,14 +354,36 @@ bool SNPETask::init(const std::string& model_path, const runtime_t runtime)
         }
 
         auto bufferShapeHandle = Snpe_IBufferAttributes_GetDims(bufferAttributesOptHandle);
-        std::vector<size_t> tensorShape;
-        for (size_t j = 0; j < Snpe_TensorShape_Rank(bufferShapeHandle); j++) {
-            tensorShape.push_back(Snpe_TensorShape_At(bufferShapeHandle, j));
-        }
-        m_inputShapes.emplace(name, tensorShape);
 
-        // size_t bufferElementSize = Snpe_IBufferAttributes_GetElementSize(bufferAttributesOptHandle);
-        createUserBuffer(m_inputUserBufferMap, m_inputTensors, m_inputUserBuffers, bufferShapeHandle, name, sizeof(float));
+        // TF8 inputs have to be quantized with the static encoding of the model.
+        Snpe_UserBufferEncoding_Handle_t modelEncodingHandle = Snpe_IBufferAttributes_GetEncoding_Ref(bufferAttributesOptHandle);
+        if (USERBUFFER_TF8 == m_encoding && isTfNEncoding(modelEncodingHandle)) {
+            TensorDesc desc = createTensorDesc(name, bufferShapeHandle, USERBUFFER_TF8);
+            desc.quant.stepExactly0 = Snpe_UserBufferEncodingTfN_GetStepExactly0(modelEncodingHandle);
+            desc.quant.stepSize = Snpe_UserBufferEncodingTfN_GetQuantizedStepSize(modelEncodingHandle);
+            LOG_INFO("Input [{}] TF8 encoding: stepExactly0 {}, stepSize {}.", name, desc.quant.stepExactly0, desc.quant.stepSize);
+
+            Snpe_UserBufferEncoding_Handle_t userBufferEncodingTfNHandle =
+                Snpe_UserBufferEncodingTfN_Create(desc.quant.stepExactly0, desc.quant.stepSize, 8);
+            for (auto& bufferSet : m_bufferSets) {
+                createUserBuffer(bufferSet.inputUserBufferMap, bufferSet.inputTensors, bufferSet.inputUserBuffers,
+                                 desc, userBufferEncodingTfNHandle);
+            }
+            Snpe_UserBufferEncodingTfN_Delete(userBufferEncodingTfNHandle);
+            m_inputDescs.push_back(std::move(desc));
+        } else {
+            if (USERBUFFER_TF8 == m_encoding) {
+                LOG_WARN("Input [{}] is not quantized in this model, fall back to float user buffer.", name);
+            }
+            TensorDesc desc = createTensorDesc(name, bufferShapeHandle, USERBUFFER_FLOAT);
+            Snpe_UserBufferEncoding_Handle_t userBufferEncodingFloatHandle = Snpe_UserBufferEncodingFloat_Create();
+            for (auto& bufferSet : m_bufferSets) {
+                createUserBuffer(bufferSet.inputUserBufferMap, bufferSet.inputTensors, bufferSet.inputUserBuffers,
+                                 desc, userBufferEncodingFloatHandle);
+            }
+            Snpe_UserBufferEncodingFloat_Delete(userBufferEncodingFloatHandle);
+            m_inputDescs.push_back(std::move(desc));
+        }
 
         Snpe_IBufferAttributes_Delete(bufferAttributesOptHandle);
         Snpe_TensorShape_Delete(bufferShapeHandle);
@@ -161,7 +391,6 @@ bool SNPETask::init(const std::string& model_path, const runtime_t runtime)
     Snpe_StringList_Delete(inputNamesHandle);
 
     // get output tensor names of the network that need to be populated
-    if (nullptr == m_outputUserBufferMap) m_outputUserBufferMap = Snpe_UserBufferMap_Create();
     Snpe_StringList_Handle_t outputNamesHandle = Snpe_SNPE_GetOutputTensorNames(m_snpe);
     if (nullptr == outputNamesHandle) throw std::runtime_error("Error obtaining input tensor names");
     assert(Snpe_StringList_Size(outputNamesHandle) > 0);
@@ -177,22 +406,38 @@ bool SNPETask::init(const std::string& model_path, const runtime_t runtime)
         }
 
         auto bufferShapeHandle = Snpe_IBufferAttributes_GetDims(bufferAttributesOptHandle);
-        std::vector<size_t> tensorShape;
-        for (size_t j = 0; j < Snpe_TensorShape_Rank(bufferShapeHandle); j++) {
-            tensorShape.push_back(Snpe_TensorShape_At(bufferShapeHandle, j));
+        TensorDesc desc = createTensorDesc(name, bufferShapeHandle, m_encoding);
+
+        // TF8 outputs: SNPE fills in stepExactly0/stepSize of the buffer on every execute().
+        if (USERBUFFER_TF8 == m_encoding) {
+            Snpe_UserBufferEncoding_Handle_t userBufferEncodingTfNHandle = Snpe_UserBufferEncodingTfN_Create(0, 1.0f, 8);
+            for (auto& bufferSet : m_bufferSets) {
+                createUserBuffer(bufferSet.outputUserBufferMap, bufferSet.outputTensors, bufferSet.outputUserBuffers,
+                                 desc, userBufferEncodingTfNHandle);
+            }
+            Snpe_UserBufferEncodingTfN_Delete(userBufferEncodingTfNHandle);
+        } else {
+            Snpe_UserBufferEncoding_Handle_t userBufferEncodingFloatHandle = Snpe_UserBufferEncodingFloat_Create();
+            for (auto& bufferSet : m_bufferSets) {
+                createUserBuffer(bufferSet.outputUserBufferMap, bufferSet.outputTensors, bufferSet.outputUserBuffers,
+                                 desc, userBufferEncodingFloatHandle);
+            }
+            Snpe_UserBufferEncodingFloat_Delete(userBufferEncodingFloatHandle);
         }
-        m_outputShapes.emplace(name, tensorShape);
-
-        // size_t bufferElementSize = Snpe_IBufferAttributes_GetElementSize(bufferAttributesOptHandle);
-        createUserBuffer(m_outputUserBufferMap, m_outputTensors, m_outputUserBuffers, bufferShapeHandle, name, sizeof(float));
+        m_outputDescs.push_back(std::move(desc));
 
         Snpe_IBufferAttributes_Delete(bufferAttributesOptHandle);
         Snpe_TensorShape_Delete(bufferShapeHandle);
     }
 
     Snpe_StringList_Delete(outputNamesHandle);
-    Snpe_SNPEBuilder_Delete(snpeBuilderHandle);
+    for (auto& bufferSet : m_bufferSets) {
+        bufferSet.outputQuantParams.resize(m_outputDescs.size());
+    }
 
+    LOG_INFO("SNPETask build {} ms, {} user buffer sets {} ms.", built - start,
+        m_bufferSets.size(), GetTimeStamp_ms() - built);
+    if (m_profiler) m_profiler->record(m_stageBuffers, (GetTimeStamp_ms() - built) * 1000);
     m_isInit = true;
 
     return true;
@@ -201,20 +446,30 @@ bool SNPETask::init(const std::string& model_path, const runtime_t runtime)
 bool SNPETask::deInit()
 {
     if (nullptr != m_runtimeList) Snpe_RuntimeList_Delete(m_runtimeList);
-    for (auto& input : m_inputUserBuffers) {
-        if (nullptr != input) Snpe_IUserBuffer_Delete(input);
-    }
-    m_inputUserBuffers.clear();
-    for (auto& output : m_outputUserBuffers) {
-        if (nullptr != output) Snpe_IUserBuffer_Delete(output);
-    }
-    m_outputUserBuffers.clear();
+    m_runtimeList = nullptr;
+    for (auto& bufferSet : m_bufferSets) {
+        for (auto& input : bufferSet.inputUserBuffers) {
+            if (nullptr != input) Snpe_IUserBuffer_Delete(input);
+        }
+        for (auto& output : bufferSet.outputUserBuffers) {
+            if (nullptr != output) Snpe_IUserBuffer_Delete(output);
+        }
 
-    if (nullptr != m_inputUserBufferMap) Snpe_UserBufferMap_Delete(m_inputUserBufferMap);
-    if (nullptr != m_outputUserBufferMap) Snpe_UserBufferMap_Delete(m_outputUserBufferMap);
+        if (nullptr != bufferSet.inputUserBufferMap) Snpe_UserBufferMap_Delete(bufferSet.inputUserBufferMap);
+        if (nullptr != bufferSet.outputUserBufferMap) Snpe_UserBufferMap_Delete(bufferSet.outputUserBufferMap);
+    }
+    m_bufferSets.clear();
+    m_inputDescs.clear();
+    m_outputDescs.clear();
 
+    // Flushes the diagnostic log.
+    if (nullptr != m_diagLog) Snpe_IDiagLog_Stop(m_diagLog);
+    m_diagLog = nullptr;
     if (nullptr != m_snpe) Snpe_SNPE_Delete(m_snpe);
-    if (nullptr != m_container) Snpe_DlContainer_Delete(m_container);
+    m_snpe = nullptr;
+    // A container opened by init() goes once the last task built on it is gone.
+    m_sharedContainer.reset();
+    m_container = nullptr;
 
     return true;
 }
@@ -223,6 +478,7 @@ bool SNPETask::setOutputLayers(std::vector<std::string>& outputLayers)
 {
     if (nullptr == m_outputLayers) m_outputLayers = Snpe_StringList_Create();
 
+    m_outputLayerNames.insert(m_outputLayerNames.end(), outputLayers.begin(), outputLayers.end());
     for (size_t i = 0; i < outputLayers.size(); i ++) {
         if (SNPE_SUCCESS != Snpe_StringList_Append(m_outputLayers, outputLayers[i].c_str())) {
             LOG_ERROR("Append output name: {} failed: {}.", outputLayers[i], Snpe_ErrorCode_GetLastErrorString());
@@ -233,11 +489,119 @@ bool SNPETask::setOutputLayers(std::vector<std::string>& outputLayers)
     return true;
 }
 
+bool SNPETask::setBatchSize(size_t batchSize)
+{
+    if (isInit()) {
+        LOG_ERROR("The setBatchSize() needs to be called before SNPETask is initialized!");
+        return false;
+    }
+    if (batchSize == 0) {
+        LOG_ERROR("Invalid batch size: {}", batchSize);
+        return false;
+    }
+
+    m_batchSize = batchSize;
+    return true;
+}
+
+bool SNPETask::setPerformanceProfile(performance_profile_t profile)
+{
+    if (isInit() && profile != m_profile) {
+        if (SNPE_SUCCESS != Snpe_SNPE_SetPerformanceProfile(m_snpe, snpeProfile(profile))) {
+            LOG_ERROR("Switch performance profile failed: {}", Snpe_ErrorCode_GetLastErrorString());
+            return false;
+        }
+    }
+
+    m_profile = profile;
+    return true;
+}
+
+bool SNPETask::setExecutionPriority(execution_priority_t priority)
+{
+    if (isInit()) {
+        LOG_ERROR("The setExecutionPriority() needs to be called before SNPETask is initialized!");
+        return false;
+    }
+
+    m_priority = priority;
+    return true;
+}
+
+bool SNPETask::setCpuFixedPointMode(bool enable)
+{
+    if (isInit()) {
+        LOG_ERROR("The setCpuFixedPointMode() needs to be called before SNPETask is initialized!");
+        return false;
+    }
+
+    m_cpuFixedPoint = enable;
+    return true;
+}
+
+bool SNPETask::setProfilingLevel(profiling_level_t level)
+{
+    if (isInit()) {
+        LOG_ERROR("The setProfilingLevel() needs to be called before SNPETask is initialized!");
+        return false;
+    }
+
+    m_profilingLevel = level;
+    return true;
+}
+
+bool SNPETask::setDiagLogDir(const std::string& dir)
+{
+    if (isInit()) {
+        LOG_ERROR("The setDiagLogDir() needs to be called before SNPETask is initialized!");
+        return false;
+    }
+
+    m_diagLogDir = dir;
+    return true;
+}
+
+void SNPETask::setProfiler(std::shared_ptr<StageProfiler> profiler, const std::string& name)
+{
+    std::string prefix = name.empty() ? "" : name + ".";
+    m_stageOpen = prefix + "init.open";
+    m_stageBuild = prefix + "init.build";
+    m_stageBuffers = prefix + "init.buffers";
+    m_stageExecute = prefix + "execute";
+    m_profiler = profiler;
+}
+
+bool SNPETask::setInitCacheDir(const std::string& cacheDir)
+{
+    if (isInit()) {
+        LOG_ERROR("The setInitCacheDir() needs to be called before SNPETask is initialized!");
+        return false;
+    }
+
+    m_initCacheDir = cacheDir;
+    return true;
+}
+
+bool SNPETask::setBufferSets(size_t count)
+{
+    if (isInit()) {
+        LOG_ERROR("The setBufferSets() needs to be called before SNPETask is initialized!");
+        return false;
+    }
+    if (count == 0) {
+        LOG_ERROR("Invalid buffer set count: {}", count);
+        return false;
+    }
+
+    m_bufferSetCount = count;
+    return true;
+}
+
 std::vector<size_t> SNPETask::getInputShape(const std::string& name)
 {
     if (isInit()) {
-        if (m_inputShapes.find(name) != m_inputShapes.end()) {
-            return m_inputShapes.at(name);
+        if (const TensorDesc* desc = findTensorDesc(m_inputDescs, name)) {
+            return desc->shape;
         }
         LOG_ERROR("Can't find any input layer named {}", name.c_str());
         return {};
@@ -250,8 +614,8 @@ std::vector<size_t> SNPETask::getInputShape(const std::string& name)
 std::vector<size_t> SNPETask::getOutputShape(const std::string& name)
 {
     if (isInit()) {
-        if (m_outputShapes.find(name) != m_outputShapes.end()) {
-            return m_outputShapes.at(name);
+        if (const TensorDesc* desc = findTensorDesc(m_outputDescs, name)) {
+            return desc->shape;
         }
         LOG_ERROR("Can't find any ouput layer named {}", name.c_str());
         return {};
@@ -261,11 +625,56 @@ std::vector<size_t> SNPETask::getOutputShape(const std::string& name)
     }
 }
 
-float* SNPETask::getInputTensor(const std::string& name)
+const TensorDesc* SNPETask::getInputDesc(const std::string& name)
+{
+    return findTensorDesc(m_inputDescs, name);
+}
+
+const TensorDesc* SNPETask::getOutputDesc(const std::string& name)
+{
+    return findTensorDesc(m_outputDescs, name);
+}
+
+TensorHandle SNPETask::getInputHandle(const std::string& name, size_t set)
+{
+    TensorHandle handle;
+    handle.desc = getInputDesc(name);
+    if (nullptr == handle.desc || set >= m_bufferSets.size()) {
+        LOG_ERROR("Can't resolve input tensor {} of buffer set {}", name.c_str(), set);
+        return TensorHandle();
+    }
+    handle.data = m_bufferSets[set].inputTensors.at(name).data();
+    handle.quant = &handle.desc->quant;
+    return handle;
+}
+
+TensorHandle SNPETask::getOutputHandle(const std::string& name, size_t set)
+{
+    TensorHandle handle;
+    handle.desc = getOutputDesc(name);
+    if (nullptr == handle.desc || set >= m_bufferSets.size()) {
+        LOG_ERROR("Can't resolve output tensor {} of buffer set {}", name.c_str(), set);
+        return TensorHandle();
+    }
+    handle.data = m_bufferSets[set].outputTensors.at(name).data();
+    handle.quant = &m_bufferSets[set].outputQuantParams[handle.desc - m_outputDescs.data()];
+    return handle;
+}
+
+float* SNPETask::getInputTensor(const std::string& name, size_t set)
 {
     if (isInit()) {
-        if (m_inputTensors.find(name) != m_inputTensors.end()) {
-            return reinterpret_cast<float*>(m_inputTensors.at(name).data());
+        if (set >= m_bufferSets.size()) {
+            LOG_ERROR("Invalid buffer set {} of {}", set, m_bufferSets.size());
+            return nullptr;
+        }
+        if (USERBUFFER_TF8 == getInputEncoding(name)) {
+            LOG_ERROR("Input tensor {} is TF8 encoded, use getInputBuffer() instead", name.c_str());
+            return nullptr;
+        }
+        auto& tensors = m_bufferSets[set].inputTensors;
+        if (tensors.find(name) != tensors.end()) {
+            return reinterpret_cast<float*>(tensors.at(name).data());
         }
         LOG_ERROR("Can't find any input tensor named {}", name.c_str());
         return nullptr;
@@ -275,11 +684,20 @@ float* SNPETask::getInputTensor(const std::string& name)
     }
 }
 
-float* SNPETask::getOutputTensor(const std::string& name)
+float* SNPETask::getOutputTensor(const std::string& name, size_t set)
 {
     if (isInit()) {
-        if (m_outputTensors.find(name) != m_outputTensors.end()) {
-            return reinterpret_cast<float*>(m_outputTensors.at(name).data());
+        if (set >= m_bufferSets.size()) {
+            LOG_ERROR("Invalid buffer set {} of {}", set, m_bufferSets.size());
+            return nullptr;
+        }
+        if (USERBUFFER_TF8 == getOutputEncoding(name)) {
+            LOG_ERROR("Output tensor {} is TF8 encoded, use getOutputBuffer() instead", name.c_str());
+            return nullptr;
+        }
+        auto& tensors = m_bufferSets[set].outputTensors;
+        if (tensors.find(name) != tensors.end()) {
+            return reinterpret_cast<float*>(tensors.at(name).data());
         }
         LOG_ERROR("Can't find any output tensor named {}", name.c_str());
         return nullptr;
@@ -289,13 +707,103 @@ float* SNPETask::getOutputTensor(const std::string& name)
     }
 }
 
-bool SNPETask::execute()
+uint8_t* SNPETask::getInputBuffer(const std::string& name, size_t set)
 {
-    if (SNPE_SUCCESS != Snpe_SNPE_ExecuteUserBuffers(m_snpe, m_inputUserBufferMap, m_outputUserBufferMap)) {
+    if (isInit()) {
+        if (set >= m_bufferSets.size()) {
+            LOG_ERROR("Invalid buffer set {} of {}", set, m_bufferSets.size());
+            return nullptr;
+        }
+        auto& tensors = m_bufferSets[set].inputTensors;
+        if (tensors.find(name) != tensors.end()) {
+            return tensors.at(name).data();
+        }
+        LOG_ERROR("Can't find any input tensor named {}", name.c_str());
+        return nullptr;
+    } else {
+        LOG_ERROR("The getInputBuffer() needs to be called after SNPETask is initialized!");
+        return nullptr;
+    }
+}
+
+uint8_t* SNPETask::getOutputBuffer(const std::string& name, size_t set)
+{
+    if (isInit()) {
+        if (set >= m_bufferSets.size()) {
+            LOG_ERROR("Invalid buffer set {} of {}", set, m_bufferSets.size());
+            return nullptr;
+        }
+        auto& tensors = m_bufferSets[set].outputTensors;
+        if (tensors.find(name) != tensors.end()) {
+            return tensors.at(name).data();
+        }
+        LOG_ERROR("Can't find any output tensor named {}", name.c_str());
+        return nullptr;
+    } else {
+        LOG_ERROR("The getOutputBuffer() needs to be called after SNPETask is initialized!");
+        return nullptr;
+    }
+}
+
+userbuffer_encoding_t SNPETask::getInputEncoding(const std::string& name)
+{
+    const TensorDesc* desc = findTensorDesc(m_inputDescs, name);
+    return nullptr != desc ? desc->encoding : USERBUFFER_FLOAT;
+}
+
+userbuffer_encoding_t SNPETask::getOutputEncoding(const std::string& name)
+{
+    const TensorDesc* desc = findTensorDesc(m_outputDescs, name);
+    return nullptr != desc ? desc->encoding : USERBUFFER_FLOAT;
+}
+
+QuantParams SNPETask::getInputQuantParams(const std::string& name)
+{
+    const TensorDesc* desc = findTensorDesc(m_inputDescs, name);
+    if (nullptr == desc || USERBUFFER_TF8 != desc->encoding) {
+        LOG_ERROR("Input tensor {} is not TF8 encoded", name.c_str());
+        return {};
+    }
+    return desc->quant;
+}
+
+QuantParams SNPETask::getOutputQuantParams(const std::string& name, size_t set)
+{
+    const TensorDesc* desc = findTensorDesc(m_outputDescs, name);
+    if (nullptr == desc || USERBUFFER_TF8 != desc->encoding) {
+        LOG_ERROR("Output tensor {} is not TF8 encoded", name.c_str());
+        return {};
+    }
+    if (set >= m_bufferSets.size()) {
+        LOG_ERROR("Invalid buffer set {} of {}", set, m_bufferSets.size());
+        return {};
+    }
+    return m_bufferSets[set].outputQuantParams[desc - m_outputDescs.data()];
+}
+
+bool SNPETask::execute(size_t set)
+{
+    if (set >= m_bufferSets.size()) {
+        LOG_ERROR("Invalid buffer set {} of {}", set, m_bufferSets.size());
+        return false;
+    }
+
+    ScopedStage stage(m_profiler.get(), m_stageExecute);
+    if (SNPE_SUCCESS != Snpe_SNPE_ExecuteUserBuffers(m_snpe, m_bufferSets[set].inputUserBufferMap,
+                                                     m_bufferSets[set].outputUserBufferMap)) {
         LOG_ERROR("SNPETask execute failed: {}", Snpe_ErrorCode_GetLastErrorString());
         return false;
     }
 
+    // Output buffers and their descs were created in the same order.
+    BufferSet& bufferSet = m_bufferSets[set];
+    for (size_t i = 0; i < m_outputDescs.size(); i++) {
+        if (USERBUFFER_TF8 != m_outputDescs[i].encoding) continue;
+        Snpe_UserBufferEncoding_Handle_t encodingHandle = Snpe_IUserBuffer_GetEncoding_Ref(bufferSet.outputUserBuffers[i]);
+        bufferSet.outputQuantParams[i].stepExactly0 = Snpe_UserBufferEncodingTfN_GetStepExactly0(encodingHandle);
+        bufferSet.outputQuantParams[i].stepSize = Snpe_UserBufferEncodingTfN_GetQuantizedStepSize(encodingHandle);
+    }
+
     return true;
 }
 
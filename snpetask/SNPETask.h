@@ -1,6 +1,6 @@
 /*
  * @Description: Inference SDK based on SNPE. 
- * @version: 1.1
+ * @version: 1.4
  * @Author: Ricardo Lu<shenglu1202@163.com>
  * @Date: 2022-05-17 20:28:01
  * @LastEditors: Ricardo Lu
@@ -23,52 +23,171 @@
 #include "DlSystem/DlEnums.h"
 #include "DlSystem/DlError.h"
 #include "DlSystem/TensorShape.h"
+#include "DlSystem/IUserBuffer.h"
+#include "DlSystem/UserBufferMap.h"
+#include "DlSystem/TensorShapeMap.h"
 #include "DlContainer/DlContainer.h"
+#include "DiagLog/IDiagLog.h"
+#include "DiagLog/Options.h"
 
 #include "utils.h"
+#include "ContainerRegistry.h"
+#include "StageProfiler.h"
+#include "TensorHandle.h"
 
 namespace snpetask {
 
+/**
+ * @brief: Leaves new elements uninitialized, so the pages of a tensor are only
+ * committed by its first write instead of a memset at init.
+ */
+template<typename T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template<typename U>
+    struct rebind {
+        typedef DefaultInitAllocator<U> other;
+    };
+
+    DefaultInitAllocator() = default;
+    template<typename U>
+    DefaultInitAllocator(const DefaultInitAllocator<U>&) noexcept {}
+
+    template<typename U>
+    void construct(U* ptr) {
+        ::new (static_cast<void*>(ptr)) U;
+    }
+    template<typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) {
+        ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+    }
+};
+
+typedef std::vector<uint8_t, DefaultInitAllocator<uint8_t>> TensorBuffer;
+
 class SNPETask {
 public:
     SNPETask();
     ~SNPETask();
 
-    bool init(const std::string& model_path, const runtime_t runtime);
+    bool init(const std::string& model_path, const runtime_t runtime,
+              const userbuffer_encoding_t encoding = USERBUFFER_FLOAT);
+    // Build on a container opened by the caller, it must outlive this task.
+    bool init(Snpe_DlContainer_Handle_t container, const runtime_t runtime,
+              const userbuffer_encoding_t encoding = USERBUFFER_FLOAT);
+    // Accelerator profile: before init() for the build, after init() it switches the
+    // built network in place. Must not overlap execute() on this task.
+    bool setPerformanceProfile(performance_profile_t profile);
+    performance_profile_t getPerformanceProfile() {
+        return m_profile;
+    }
+    // Must be called before init().
+    bool setExecutionPriority(execution_priority_t priority);
+    // Run the CPU runtime (and CPU fallback layers) in 8 bit fixed point, must be called before init().
+    bool setCpuFixedPointMode(bool enable);
+    // SNPE profiling of the network, must be called before init(). Its per layer events
+    // are only written to the diagnostic log, see setDiagLogDir().
+    bool setProfilingLevel(profiling_level_t level);
+    // Write the SNPE diagnostic log (read it with snpe-diagview) into dir, must be called before init().
+    bool setDiagLogDir(const std::string& dir);
+    // Record init and execute() timings as "<name>.init.build", "<name>.execute"...
+    // into profiler, nullptr to stop. Must be called before init() to see the init stages.
+    void setProfiler(std::shared_ptr<StageProfiler> profiler, const std::string& name = "");
+    // Keep the prepared networks in cacheDir, must be called before init().
+    // The next init() with the same model file, runtime, outputs, batch, buffer encoding
+    // and CPU fixed point mode skips the graph preparation. A cache failing to build is
+    // removed and the model file read again.
+    bool setInitCacheDir(const std::string& cacheDir);
     bool deInit();
     bool setOutputLayers(std::vector<std::string>& outputLayers);
+    // Resize the batch dimension of all inputs, must be called before init().
+    bool setBatchSize(size_t batchSize);
+    size_t getBatchSize() {
+        return m_batchSize;
+    }
+    // Number of independent input/output buffer sets, must be called before init().
+    // While one set executes, the others can be filled or read by other threads.
+    bool setBufferSets(size_t count);
+    size_t getBufferSets() {
+        return m_bufferSets.size() ? m_bufferSets.size() : m_bufferSetCount;
+    }
 
     std::vector<size_t> getInputShape(const std::string& name);
     std::vector<size_t> getOutputShape(const std::string& name);
 
-    float* getInputTensor(const std::string& name);
-    float* getOutputTensor(const std::string& name);
+    // Layout of a tensor, nullptr if there is none named so. Valid until deInit().
+    const TensorDesc* getInputDesc(const std::string& name);
+    const TensorDesc* getOutputDesc(const std::string& name);
+    // Resolve a tensor of one buffer set once, then read it with no lookup per frame.
+    TensorHandle getInputHandle(const std::string& name, size_t set = 0);
+    TensorHandle getOutputHandle(const std::string& name, size_t set = 0);
+
+    float* getInputTensor(const std::string& name, size_t set = 0);
+    float* getOutputTensor(const std::string& name, size_t set = 0);
+
+    // Raw user buffers, valid for both float and TF8 encoded tensors.
+    uint8_t* getInputBuffer(const std::string& name, size_t set = 0);
+    uint8_t* getOutputBuffer(const std::string& name, size_t set = 0);
+
+    userbuffer_encoding_t getInputEncoding(const std::string& name);
+    userbuffer_encoding_t getOutputEncoding(const std::string& name);
+
+    // Input params are fixed by the model, output params are refreshed by every execute().
+    QuantParams getInputQuantParams(const std::string& name);
+    QuantParams getOutputQuantParams(const std::string& name, size_t set = 0);
 
     bool isInit() {
         return m_isInit;
     }
 
-    bool execute();
+    // Execute on one buffer set, calls must not overlap on the same SNPETask.
+    bool execute(size_t set = 0);
 
 private:
     bool m_isInit = false;
 
     Snpe_DlContainer_Handle_t m_container;
+    // Set when init() opened the container from a path.
+    std::shared_ptr<SharedContainer> m_sharedContainer;
+    std::string m_initCacheDir;
+    std::vector<std::string> m_outputLayerNames;
     Snpe_SNPE_Handle_t m_snpe;
     Snpe_Runtime_t m_runtime;
     Snpe_RuntimeList_Handle_t m_runtimeList;
     Snpe_StringList_Handle_t m_outputLayers;
 
-    std::map<std::string, std::vector<size_t> > m_inputShapes;
-    std::map<std::string, std::vector<size_t> > m_outputShapes;
-
-    std::vector<Snpe_IUserBuffer_Handle_t> m_inputUserBuffers;
-    std::vector<Snpe_IUserBuffer_Handle_t> m_outputUserBuffers;
-    Snpe_UserBufferMap_Handle_t m_inputUserBufferMap;
-    Snpe_UserBufferMap_Handle_t m_outputUserBufferMap;
-
-    std::unordered_map<std::string, std::vector<uint8_t>> m_inputTensors;
-    std::unordered_map<std::string, std::vector<uint8_t>> m_outputTensors;
+    // Built by init() and never resized after, TensorHandle points into them.
+    std::vector<TensorDesc> m_inputDescs;
+    std::vector<TensorDesc> m_outputDescs;
+
+    struct BufferSet {
+        std::vector<Snpe_IUserBuffer_Handle_t> inputUserBuffers;
+        std::vector<Snpe_IUserBuffer_Handle_t> outputUserBuffers;
+        Snpe_UserBufferMap_Handle_t inputUserBufferMap = nullptr;
+        Snpe_UserBufferMap_Handle_t outputUserBufferMap = nullptr;
+
+        std::unordered_map<std::string, TensorBuffer> inputTensors;
+        std::unordered_map<std::string, TensorBuffer> outputTensors;
+        // Indexed like m_outputDescs, refreshed by execute() for TF8 outputs
+        std::vector<QuantParams> outputQuantParams;
+    };
+    std::vector<BufferSet> m_bufferSets;
+    size_t m_bufferSetCount = 1;
+
+    size_t m_batchSize = 1;
+    performance_profile_t m_profile = PROFILE_BURST;
+    execution_priority_t m_priority = PRIORITY_NORMAL;
+    bool m_cpuFixedPoint = false;
+    profiling_level_t m_profilingLevel = PROFILING_OFF;
+    std::string m_diagLogDir;
+    Snpe_IDiagLog_Handle_t m_diagLog = nullptr;
+
+    std::shared_ptr<StageProfiler> m_profiler;
+    // Stage names built once by setProfiler()
+    std::string m_stageOpen;
+    std::string m_stageBuild;
+    std::string m_stageBuffers;
+    std::string m_stageExecute;
+    userbuffer_encoding_t m_encoding = USERBUFFER_FLOAT;
 };
 
 }    // namespace snpetask
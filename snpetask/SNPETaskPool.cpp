@@ -0,0 +1,256 @@
+/*
+ * @Description: SNPETask replicas of one model sharing its container.
+ * @version: 1.5
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 17:21:08
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 17:21:08
+ */
+
+#include <filesystem>
+
+#include "SNPETaskPool.h"
+
+namespace snpetask {
+
+SNPETaskPool::SNPETaskPool()
+{
+
+}
+
+SNPETaskPool::~SNPETaskPool()
+{
+    deInit();
+}
+
+bool SNPETaskPool::setOutputLayers(std::vector<std::string>& outputLayers)
+{
+    if (isInit()) {
+        LOG_ERROR("The setOutputLayers() needs to be called before SNPETaskPool is initialized!");
+        return false;
+    }
+
+    m_outputLayers = outputLayers;
+    return true;
+}
+
+bool SNPETaskPool::setBatchSize(size_t batchSize)
+{
+    if (isInit()) {
+        LOG_ERROR("The setBatchSize() needs to be called before SNPETaskPool is initialized!");
+        return false;
+    }
+
+    m_batchSize = batchSize;
+    return true;
+}
+
+bool SNPETaskPool::setBufferSets(size_t count)
+{
+    if (isInit()) {
+        LOG_ERROR("The setBufferSets() needs to be called before SNPETaskPool is initialized!");
+        return false;
+    }
+
+    m_bufferSets = count;
+    return true;
+}
+
+bool SNPETaskPool::setInitCacheDir(const std::string& cacheDir)
+{
+    if (isInit()) {
+        LOG_ERROR("The setInitCacheDir() needs to be called before SNPETaskPool is initialized!");
+        return false;
+    }
+
+    m_initCacheDir = cacheDir;
+    return true;
+}
+
+bool SNPETaskPool::setExecutionPriority(execution_priority_t priority)
+{
+    if (isInit()) {
+        LOG_ERROR("The setExecutionPriority() needs to be called before SNPETaskPool is initialized!");
+        return false;
+    }
+
+    m_priority = priority;
+    return true;
+}
+
+bool SNPETaskPool::setCpuFixedPointMode(bool enable)
+{
+    if (isInit()) {
+        LOG_ERROR("The setCpuFixedPointMode() needs to be called before SNPETaskPool is initialized!");
+        return false;
+    }
+
+    m_cpuFixedPoint = enable;
+    return true;
+}
+
+bool SNPETaskPool::setProfilingLevel(profiling_level_t level)
+{
+    if (isInit()) {
+        LOG_ERROR("The setProfilingLevel() needs to be called before SNPETaskPool is initialized!");
+        return false;
+    }
+
+    m_profilingLevel = level;
+    return true;
+}
+
+bool SNPETaskPool::setDiagLogDir(const std::string& dir)
+{
+    if (isInit()) {
+        LOG_ERROR("The setDiagLogDir() needs to be called before SNPETaskPool is initialized!");
+        return false;
+    }
+
+    m_diagLogDir = dir;
+    return true;
+}
+
+bool SNPETaskPool::setProfiler(std::shared_ptr<StageProfiler> profiler)
+{
+    if (isInit()) {
+        LOG_ERROR("The setProfiler() needs to be called before SNPETaskPool is initialized!");
+        return false;
+    }
+
+    m_profiler = profiler;
+    return true;
+}
+
+bool SNPETaskPool::setPerformanceProfile(performance_profile_t profile)
+{
+    if (!isInit()) {
+        m_profile = profile;
+        return true;
+    }
+
+    int64_t start = GetTimeStamp_ms();
+    bool ret = true;
+    for (size_t i = 0; i < Size(); i++) {
+        ret &= RunExclusive(i, [profile](SNPETask& task) {
+            return task.setPerformanceProfile(profile);
+        });
+    }
+    m_profile = profile;
+    LOG_DEBUG("SNPETaskPool switched performance profile to {} in {} ms.", (int)profile, GetTimeStamp_ms() - start);
+    return ret;
+}
+
+void SNPETaskPool::buildReplicas(const std::vector<runtime_t>& runtimes, const userbuffer_encoding_t encoding)
+{
+    for (size_t i = 0; i < runtimes.size(); i++) {
+        std::string name = std::string(runtimeName(runtimes[i])) + "#" + std::to_string(i);
+        std::string diagLogDir;
+        if (!m_diagLogDir.empty()) {
+            diagLogDir = (std::filesystem::path(m_diagLogDir) /
+                          (std::string(runtimeName(runtimes[i])) + "_" + std::to_string(i))).string();
+            std::error_code ec;
+            std::filesystem::create_directories(diagLogDir, ec);
+        }
+
+        std::unique_ptr<SNPETask> task(new SNPETask());
+        task->setProfiler(m_profiler, name);
+        if (!task->setOutputLayers(m_outputLayers) ||
+            !task->setBatchSize(m_batchSize) ||
+            !task->setBufferSets(0 == Size() ? m_bufferSets : 1) ||
+            !task->setInitCacheDir(m_initCacheDir) ||
+            !task->setPerformanceProfile(m_profile) ||
+            !task->setExecutionPriority(m_priority) ||
+            !task->setCpuFixedPointMode(m_cpuFixedPoint) ||
+            !task->setProfilingLevel(m_profilingLevel) ||
+            !task->setDiagLogDir(diagLogDir) ||
+            !task->init(m_container->handle(), runtimes[i], encoding)) {
+            LOG_ERROR("Can't build replica {} on {}, skip it.", i, runtimeName(runtimes[i]));
+            task->deInit();
+            continue;
+        }
+
+        Add(std::move(task), name);
+        LOG_INFO("SNPETaskPool replica {} ready.", name);
+    }
+}
+
+bool SNPETaskPool::init(const std::string& model_path, const std::vector<runtime_t>& runtimes,
+                        const userbuffer_encoding_t encoding)
+{
+    if (runtimes.empty()) {
+        LOG_ERROR("SNPETaskPool needs at least one runtime.");
+        return false;
+    }
+
+    int64_t start = GetTimeStamp_ms();
+    std::string cachePath;
+    std::string runtimesName = runtimeListName(runtimes);
+    if (!m_initCacheDir.empty()) {
+        cachePath = initCachePath(m_initCacheDir, model_path, m_outputLayers,
+                                  m_batchSize, encoding, m_cpuFixedPoint);
+    }
+    int64_t keyed = GetTimeStamp_ms();
+
+    m_container = ContainerRegistry::instance().open(model_path, cachePath);
+    if (!m_container) {
+        LOG_ERROR("Can't open model container {}.", model_path);
+        return false;
+    }
+    bool isCached = m_container->hasInitCache(runtimesName);
+    int64_t opened = GetTimeStamp_ms();
+    if (m_profiler) m_profiler->record("init.open", (opened - keyed) * 1000);
+
+    buildReplicas(runtimes, encoding);
+
+    // A broken or stale cache: build from the model again, which rewrites the cache.
+    if (Size() < runtimes.size() && m_container->isInitCache()) {
+        LOG_WARN("SNPETaskPool built {} of {} replicas from init cache {}, retry from {}.",
+            Size(), runtimes.size(), cachePath, model_path);
+        deInit();
+        ContainerRegistry::instance().discardInitCache(cachePath);
+        m_container = ContainerRegistry::instance().open(model_path, cachePath);
+        if (!m_container) {
+            LOG_ERROR("Can't open model container {}.", model_path);
+            return false;
+        }
+        isCached = false;
+        buildReplicas(runtimes, encoding);
+    }
+
+    if (0 == Size()) {
+        LOG_ERROR("SNPETaskPool built no replica of {}.", model_path);
+        deInit();
+        return false;
+    }
+    int64_t built = GetTimeStamp_ms();
+
+    // Only a complete set of replicas is worth caching.
+    if (!isCached && !cachePath.empty() && Size() == runtimes.size() &&
+        saveInitCache(*m_container, cachePath, runtimesName)) {
+        LOG_INFO("Saved init cache {} of {}.", cachePath, runtimesName);
+    }
+
+    LOG_INFO("SNPETaskPool init {} ms: cache key {} ms, open {} ms{}, build {} replicas {} ms, cache save {} ms.",
+        GetTimeStamp_ms() - start, keyed - start, opened - keyed, isCached ? " (init cache hit)" : "",
+        Size(), built - opened, GetTimeStamp_ms() - built);
+
+    m_isInit = true;
+    return true;
+}
+
+bool SNPETaskPool::deInit()
+{
+    for (size_t i = 0; i < Size(); i++) {
+        At(i).deInit();
+    }
+    Clear();
+
+    // Every network built on the container is gone.
+    m_container.reset();
+
+    m_isInit = false;
+    return true;
+}
+
+}    // namespace snpetask
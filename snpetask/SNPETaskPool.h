@@ -0,0 +1,87 @@
+/*
+ * @Description: SNPETask replicas of one model sharing its container.
+ * @version: 1.4
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 17:21:08
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 17:21:08
+ */
+
+#ifndef __SNPE_TASK_POOL_H__
+#define __SNPE_TASK_POOL_H__
+
+#include <vector>
+#include <string>
+
+#include "SNPETask.h"
+#include "TaskPool.h"
+
+namespace snpetask {
+
+/**
+ * @brief: Builds one network per runtime on one container, e.g. {DSP, GPU, CPU}
+ * keeps all three busy. Pools of the same model file share the container. Worker threads take a replica with Acquire() for a whole
+ * pre-process -> execute -> post-process round, since the buffers belong to the replica.
+ */
+class SNPETaskPool : public TaskPool<SNPETask> {
+public:
+    SNPETaskPool();
+    ~SNPETaskPool();
+
+    // Applied to every replica, must be called before init().
+    bool setOutputLayers(std::vector<std::string>& outputLayers);
+    bool setBatchSize(size_t batchSize);
+    // Buffer sets of the first replica, the one Acquire(0) work is bound to, the others get one.
+    bool setBufferSets(size_t count);
+    // One init cache file per model and build config, shared with the other pools and
+    // tasks of the model whatever their runtimes, see ContainerRegistry.
+    bool setInitCacheDir(const std::string& cacheDir);
+    bool setExecutionPriority(execution_priority_t priority);
+    bool setCpuFixedPointMode(bool enable);
+    // Before init() for the build, after init() every replica switches between two frames.
+    bool setPerformanceProfile(performance_profile_t profile);
+    performance_profile_t getPerformanceProfile() {
+        return m_profile;
+    }
+    bool setProfilingLevel(profiling_level_t level);
+    // Every replica logs into its own sub directory, e.g. dir/DSP_0.
+    bool setDiagLogDir(const std::string& dir);
+    // Replica stages are named after the replica, e.g. "DSP#0.execute".
+    bool setProfiler(std::shared_ptr<StageProfiler> profiler);
+
+    /**
+     * @brief: Build one replica per entry of runtimes, a runtime may be repeated.
+     * A replica failing to build is skipped.
+     * @return {bool} true if at least one replica is built.
+     */
+    bool init(const std::string& model_path, const std::vector<runtime_t>& runtimes,
+              const userbuffer_encoding_t encoding = USERBUFFER_FLOAT);
+    // No lease may be held.
+    bool deInit();
+
+    bool isInit() {
+        return m_isInit;
+    }
+
+private:
+    // One replica per runtime on m_container, the failing ones are skipped.
+    void buildReplicas(const std::vector<runtime_t>& runtimes, const userbuffer_encoding_t encoding);
+
+    bool m_isInit = false;
+
+    std::shared_ptr<SharedContainer> m_container;
+    std::string m_initCacheDir;
+    std::vector<std::string> m_outputLayers;
+    size_t m_batchSize = 1;
+    size_t m_bufferSets = 1;
+    performance_profile_t m_profile = PROFILE_BURST;
+    execution_priority_t m_priority = PRIORITY_NORMAL;
+    bool m_cpuFixedPoint = false;
+    profiling_level_t m_profilingLevel = PROFILING_OFF;
+    std::string m_diagLogDir;
+    std::shared_ptr<StageProfiler> m_profiler;
+};
+
+}    // namespace snpetask
+
+#endif    // __SNPE_TASK_POOL_H__
@@ -0,0 +1,154 @@
+/*
+ * @Description: Latency histograms of the inference stages, collected in process.
+ * @version: 1.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 20:14:05
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 20:14:05
+ */
+
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+#include "StageProfiler.h"
+
+namespace snpetask {
+
+static int highestBit(uint64_t value)
+{
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t us)
+{
+    if (us < kLinear) return us;
+    // Top 3 bits below the leading one pick the sub bucket.
+    int exponent = highestBit(us);
+    size_t sub = (us >> (exponent - 3)) & (kSubBuckets - 1);
+    return kLinear + (exponent - 4) * kSubBuckets + sub;
+}
+
+double LatencyHistogram::bucketMiddle(size_t bucket)
+{
+    if (bucket < kLinear) return (double)bucket;
+    int exponent = (bucket - kLinear) / kSubBuckets + 4;
+    size_t sub = (bucket - kLinear) % kSubBuckets;
+    double width = std::ldexp(1.0, exponent - 3);
+    return (kSubBuckets + sub) * width + width / 2.0;
+}
+
+double LatencyHistogram::percentile(double q) const
+{
+    if (0 == m_count) return 0.0;
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q * m_count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < m_buckets.size(); i++) {
+        seen += m_buckets[i];
+        if (seen >= rank) return std::min(bucketMiddle(i), (double)m_max);
+    }
+    return (double)m_max;
+}
+
+StageStats LatencyHistogram::stats(const std::string& name) const
+{
+    StageStats stats;
+    stats.name = name;
+    stats.count = m_count;
+    if (0 == m_count) return stats;
+    stats.mean_us = (double)m_sum / m_count;
+    stats.p50_us = percentile(0.50);
+    stats.p90_us = percentile(0.90);
+    stats.p95_us = percentile(0.95);
+    stats.p99_us = percentile(0.99);
+    stats.max_us = (double)m_max;
+    return stats;
+}
+
+void StageProfiler::record(std::string_view stage, uint64_t us)
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+    auto it = m_stages.find(stage);
+    if (it == m_stages.end()) it = m_stages.emplace(std::string(stage), Stage()).first;
+    it->second.total.record(us);
+    it->second.window.record(us);
+}
+
+std::vector<StageStats> StageProfiler::snapshot() const
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+    std::vector<StageStats> stats;
+    for (const auto& stage : m_stages) {
+        stats.push_back(stage.second.total.stats(stage.first));
+    }
+    return stats;
+}
+
+void StageProfiler::reset()
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+    for (auto& stage : m_stages) {
+        stage.second.total.clear();
+        stage.second.window.clear();
+    }
+}
+
+void StageProfiler::setDump(const std::string& tag, const std::string& csvPath, int64_t interval_ms)
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+    m_tag = tag;
+    m_csvPath = csvPath;
+    m_interval_ms = interval_ms;
+    m_nextDump_ms = GetTimeStamp_ms() + interval_ms;
+}
+
+void StageProfiler::tick()
+{
+    if (m_interval_ms <= 0) return;
+    int64_t now = GetTimeStamp_ms();
+    int64_t due = m_nextDump_ms.load(std::memory_order_relaxed);
+    // One caller per interval wins the dump.
+    if (now < due || !m_nextDump_ms.compare_exchange_strong(due, now + m_interval_ms)) return;
+
+    std::vector<StageStats> window;
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        for (auto& stage : m_stages) {
+            if (0 == stage.second.window.count()) continue;
+            window.push_back(stage.second.window.stats(stage.first));
+            stage.second.window.clear();
+        }
+    }
+
+    for (const auto& stats : window) {
+        LOG_INFO("{} {}: {} samples, mean {:.2f} ms, p50 {:.2f} ms, p90 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms.",
+            m_tag, stats.name, stats.count, stats.mean_us / 1000.0, stats.p50_us / 1000.0,
+            stats.p90_us / 1000.0, stats.p99_us / 1000.0, stats.max_us / 1000.0);
+    }
+    if (!m_csvPath.empty() && !window.empty() && !appendCsv(m_csvPath, m_tag, window)) {
+        LOG_WARN("Can't append stage profile to {}.", m_csvPath);
+    }
+}
+
+bool StageProfiler::appendCsv(const std::string& path, const std::string& tag,
+                              const std::vector<StageStats>& stats)
+{
+    std::error_code ec;
+    bool isNew = !std::filesystem::exists(path, ec);
+    std::ofstream out(path, std::ios::app);
+    if (!out) return false;
+
+    if (isNew) out << "timestamp_ms,tag,stage,count,mean_us,p50_us,p90_us,p95_us,p99_us,max_us\n";
+    int64_t now = GetTimeStamp_ms();
+    for (const auto& stage : stats) {
+        out << now << ',' << tag << ',' << stage.name << ',' << stage.count << ','
+            << stage.mean_us << ',' << stage.p50_us << ',' << stage.p90_us << ','
+            << stage.p95_us << ',' << stage.p99_us << ',' << stage.max_us << '\n';
+    }
+    return (bool)out;
+}
+
+}   // namespace snpetask
@@ -0,0 +1,150 @@
+/*
+ * @Description: Latency histograms of the inference stages, collected in process.
+ * @version: 1.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 20:14:05
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 20:14:05
+ */
+
+#ifndef __STAGE_PROFILER_H__
+#define __STAGE_PROFILER_H__
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include "utils.h"
+
+namespace snpetask {
+
+/**
+ * @brief: Aggregated timings of one stage, in microseconds.
+ */
+struct StageStats {
+    std::string name;
+    uint64_t count = 0;
+    double mean_us = 0.0;
+    double p50_us = 0.0;
+    double p90_us = 0.0;
+    double p95_us = 0.0;
+    double p99_us = 0.0;
+    double max_us = 0.0;
+};
+
+/**
+ * @brief: Log-linear latency histogram: exact below 16 us, then 8 buckets per
+ * power of two, so any percentile is within 6% of the true value.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram() : m_buckets(kBuckets, 0) {}
+
+    void record(uint64_t us) {
+        m_buckets[bucketOf(us)]++;
+        m_count++;
+        m_sum += us;
+        if (us > m_max) m_max = us;
+    }
+
+    void clear() {
+        std::fill(m_buckets.begin(), m_buckets.end(), 0);
+        m_count = 0;
+        m_sum = 0;
+        m_max = 0;
+    }
+
+    uint64_t count() const {
+        return m_count;
+    }
+
+    // q in [0.0f, 1.0f], middle of the bucket holding the q-th sample.
+    double percentile(double q) const;
+
+    StageStats stats(const std::string& name) const;
+
+private:
+    static constexpr size_t kLinear = 16;
+    static constexpr size_t kSubBuckets = 8;
+    static constexpr size_t kBuckets = kLinear + (64 - 4) * kSubBuckets;
+
+    static size_t bucketOf(uint64_t us);
+    static double bucketMiddle(size_t bucket);
+
+    std::vector<uint64_t> m_buckets;
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_max = 0;
+};
+
+/**
+ * @brief: Named stage histograms shared by the tasks of one model. Thread safe.
+ * Every sample counts in the totals (snapshot()) and in the current dump window,
+ * tick() logs the window and appends it to a CSV file once per interval.
+ */
+class StageProfiler {
+public:
+    StageProfiler() = default;
+    StageProfiler(const StageProfiler&) = delete;
+    StageProfiler& operator=(const StageProfiler&) = delete;
+
+    void record(std::string_view stage, uint64_t us);
+
+    // Totals since creation or reset(), sorted by stage name.
+    std::vector<StageStats> snapshot() const;
+    void reset();
+
+    // Periodic dump from tick(), tag prefixes the log lines. Empty csvPath logs only,
+    // interval_ms <= 0 disables it.
+    void setDump(const std::string& tag, const std::string& csvPath, int64_t interval_ms);
+    // Cheap unless the interval is over, call it after each frame.
+    void tick();
+
+    // One row per stage: timestamp_ms,tag,stage,count,mean_us,p50_us,p90_us,p95_us,p99_us,max_us
+    static bool appendCsv(const std::string& path, const std::string& tag,
+                          const std::vector<StageStats>& stats);
+
+private:
+    struct Stage {
+        LatencyHistogram total;
+        LatencyHistogram window;
+    };
+
+    // std::less<> finds by string_view without a temporary key.
+    std::map<std::string, Stage, std::less<>> m_stages;
+    mutable std::mutex m_mutex;
+
+    std::string m_tag;
+    std::string m_csvPath;
+    int64_t m_interval_ms = 0;
+    std::atomic<int64_t> m_nextDump_ms{0};
+};
+
+/**
+ * @brief: Records the lifetime of the scope as stage, nothing without a profiler.
+ * The stage name must outlive it, e.g. a literal or a member string.
+ */
+class ScopedStage {
+public:
+    ScopedStage(StageProfiler* profiler, std::string_view stage) :
+        m_profiler(profiler), m_stage(stage), m_start(profiler ? GetTimeStamp_us() : 0) {}
+    ~ScopedStage() {
+        if (nullptr != m_profiler) m_profiler->record(m_stage, GetTimeStamp_us() - m_start);
+    }
+
+    ScopedStage(const ScopedStage&) = delete;
+    ScopedStage& operator=(const ScopedStage&) = delete;
+
+private:
+    StageProfiler* m_profiler;
+    std::string_view m_stage;
+    int64_t m_start;
+};
+
+}    // namespace snpetask
+
+#endif    // __STAGE_PROFILER_H__
@@ -0,0 +1,319 @@
+/*
+ * @Description: Pool of inference task replicas handed out by leases.
+ * @version: 1.3
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 17:05:31
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 17:05:31
+ */
+
+#ifndef __TASK_POOL_H__
+#define __TASK_POOL_H__
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+#include "RuntimeBalancer.h"
+
+namespace snpetask {
+
+/**
+ * @brief: Usage of one replica since the pool was filled or ResetStats().
+ */
+struct ReplicaStats {
+    std::string name;
+    uint64_t leases = 0;
+    double busy_ms = 0.0;
+    // Fraction of the wall time the replica was leased, [0.0f, 1.0f]
+    double utilization = 0.0;
+    // Lease time, moving average if balanced, mean otherwise
+    double latency_ms = 0.0;
+};
+
+/**
+ * @brief: N interchangeable replicas of Task, one lease holder at a time each.
+ * Acquire() prefers the lowest index, so the replicas should be added fastest
+ * first: the slower ones only take frames while the faster ones are busy.
+ * With SetBalancer() it waits for the replica expected to finish first instead.
+ * Task is a template parameter so the scheduling can run on fake tasks.
+ */
+template<typename Task>
+class TaskPool {
+public:
+    /**
+     * @brief: Exclusive use of one replica, given back on destruction.
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept {
+            *this = std::move(other);
+        }
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                Release();
+                m_pool = other.m_pool;
+                m_task = other.m_task;
+                m_index = other.m_index;
+                other.m_pool = nullptr;
+                other.m_task = nullptr;
+            }
+            return *this;
+        }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ~Lease() {
+            Release();
+        }
+
+        explicit operator bool() const {
+            return nullptr != m_pool;
+        }
+        Task* operator->() const {
+            return m_task;
+        }
+        Task& operator*() const {
+            return *m_task;
+        }
+        size_t Index() const {
+            return m_index;
+        }
+
+        void Release() {
+            if (nullptr != m_pool) {
+                m_pool->Return(m_index);
+                m_pool = nullptr;
+                m_task = nullptr;
+            }
+        }
+
+    private:
+        friend class TaskPool;
+        Lease(TaskPool* pool, Task* task, size_t index) : m_pool(pool), m_task(task), m_index(index) {}
+
+        TaskPool* m_pool = nullptr;
+        Task* m_task = nullptr;
+        size_t m_index = 0;
+    };
+
+    TaskPool() : m_since(Clock::now()) {}
+    virtual ~TaskPool() = default;
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    // Replicas are added before any lease is taken.
+    size_t Add(std::unique_ptr<Task> task, const std::string& name) {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        Replica replica;
+        replica.task = std::move(task);
+        replica.name = name;
+        m_replicas.push_back(std::move(replica));
+        m_since = Clock::now();
+        return m_replicas.size() - 1;
+    }
+
+    size_t Size() const {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        return m_replicas.size();
+    }
+
+    // Direct access for setup and queries, not for execution.
+    Task& At(size_t index) {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        return *m_replicas.at(index).task;
+    }
+
+    const std::string& Name(size_t index) const {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        return m_replicas.at(index).name;
+    }
+
+    // Route Acquire() by expected completion time, after the replicas are added.
+    void SetBalancer(const BalancerConfig& config) {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_balancer.reset(new RuntimeBalancer(m_replicas.size(), config));
+    }
+
+    bool IsBalanced() const {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        return nullptr != m_balancer;
+    }
+
+    /**
+     * @brief: Lease the first free replica, wait for one if all are busy.
+     * Balanced: lease the replica the balancer picks, waiting for it even if
+     * a slower one is free.
+     * @return {Lease} Empty if the pool has no replica.
+     */
+    Lease Acquire() {
+        std::unique_lock<std::mutex> locker(m_mutex);
+        if (m_replicas.empty()) return Lease();
+        size_t index = 0;
+        if (m_balancer) {
+            index = m_balancer->Pick();
+            m_balancer->Begin(index);
+            m_cond.wait(locker, [this, index]() { return !m_replicas[index].busy; });
+        } else {
+            m_cond.wait(locker, [this, &index]() { return FirstFree(index); });
+        }
+        return Take(index);
+    }
+
+    /**
+     * @brief: Lease the replica index, for work bound to its buffers.
+     * @param {bool} sample: false if the lease covers only part of a frame (e.g. the
+     * execute stage alone), the balancer then counts it as queued work but keeps its
+     * time out of the latency average.
+     */
+    Lease Acquire(size_t index, bool sample = true) {
+        std::unique_lock<std::mutex> locker(m_mutex);
+        if (index >= m_replicas.size()) return Lease();
+        if (m_balancer) m_balancer->Begin(index);
+        m_cond.wait(locker, [this, index]() { return !m_replicas[index].busy; });
+        return Take(index, sample);
+    }
+
+    /**
+     * @brief: Maintenance on replica index: waits for it like Acquire(index) and calls
+     * fn(task), without counting in the stats or the balancer.
+     */
+    template<typename Fn>
+    bool RunExclusive(size_t index, Fn fn) {
+        Task* task = nullptr;
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            if (index >= m_replicas.size()) return false;
+            m_cond.wait(locker, [this, index]() { return !m_replicas[index].busy; });
+            m_replicas[index].busy = true;
+            task = m_replicas[index].task.get();
+        }
+
+        bool ret = fn(*task);
+
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            m_replicas[index].busy = false;
+        }
+        m_cond.notify_all();
+        return ret;
+    }
+
+    // Empty lease if every replica is busy.
+    Lease TryAcquire() {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        size_t index = 0;
+        if (!FirstFree(index)) return Lease();
+        if (m_balancer) m_balancer->Begin(index);
+        return Take(index);
+    }
+
+    std::vector<ReplicaStats> Stats() const {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        Clock::time_point now = Clock::now();
+        double wall_ms = std::chrono::duration<double, std::milli>(now - m_since).count();
+
+        std::vector<ReplicaStats> stats(m_replicas.size());
+        for (size_t i = 0; i < m_replicas.size(); i++) {
+            const Replica& replica = m_replicas[i];
+            stats[i].name = replica.name;
+            stats[i].leases = replica.leases;
+            stats[i].busy_ms = replica.busy_ms;
+            // The running lease counts up to now.
+            if (replica.busy) {
+                Clock::time_point start = replica.start < m_since ? m_since : replica.start;
+                stats[i].busy_ms += std::chrono::duration<double, std::milli>(now - start).count();
+            }
+            stats[i].utilization = wall_ms > 0.0 ? stats[i].busy_ms / wall_ms : 0.0;
+            if (m_balancer) {
+                stats[i].latency_ms = m_balancer->Latency(i);
+            } else if (replica.leases > 0) {
+                stats[i].latency_ms = replica.busy_ms / replica.leases;
+            }
+        }
+        return stats;
+    }
+
+    void ResetStats() {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        for (auto& replica : m_replicas) {
+            replica.leases = 0;
+            replica.busy_ms = 0.0;
+        }
+        m_since = Clock::now();
+    }
+
+protected:
+    // Called with no lease out.
+    void Clear() {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        m_replicas.clear();
+        m_balancer.reset();
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Replica {
+        std::unique_ptr<Task> task;
+        std::string name;
+        bool busy = false;
+        // The running lease feeds the balancer latency
+        bool sample = true;
+        uint64_t leases = 0;
+        double busy_ms = 0.0;
+        Clock::time_point start;
+    };
+
+    bool FirstFree(size_t& index) const {
+        for (size_t i = 0; i < m_replicas.size(); i++) {
+            if (!m_replicas[i].busy) {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Lease Take(size_t index, bool sample = true) {
+        Replica& replica = m_replicas[index];
+        replica.busy = true;
+        replica.sample = sample;
+        replica.leases++;
+        replica.start = Clock::now();
+        return Lease(this, replica.task.get(), index);
+    }
+
+    void Return(size_t index) {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            Replica& replica = m_replicas[index];
+            Clock::time_point now = Clock::now();
+            Clock::time_point start = replica.start < m_since ? m_since : replica.start;
+            replica.busy_ms += std::chrono::duration<double, std::milli>(now - start).count();
+            replica.busy = false;
+            if (m_balancer) {
+                m_balancer->End(index, std::chrono::duration<double, std::milli>(now - replica.start).count(),
+                                replica.sample);
+            }
+        }
+        // Waiters may want this very replica, or any of them.
+        m_cond.notify_all();
+    }
+
+    std::vector<Replica> m_replicas;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    Clock::time_point m_since;
+    std::unique_ptr<RuntimeBalancer> m_balancer;
+};
+
+}    // namespace snpetask
+
+#endif    // __TASK_POOL_H__
@@ -0,0 +1,106 @@
+/*
+ * @Description: Tensor descriptors and handles resolved once from SNPETask.
+ * @version: 1.0
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 22:41:12
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 22:41:12
+ */
+
+#ifndef __TENSOR_HANDLE_H__
+#define __TENSOR_HANDLE_H__
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "utils.h"
+
+namespace snpetask {
+
+/**
+ * @brief: Quantization parameters of a TF8 tensor: real = (quantized - stepExactly0) * stepSize.
+ */
+struct QuantParams {
+    uint64_t stepExactly0 = 0;
+    float stepSize = 1.0f;
+};
+
+/**
+ * @brief: Layout of one network tensor, the same in every buffer set of a task.
+ * Pre/post-processing reads the geometry from it instead of asking the task by name.
+ */
+struct TensorDesc {
+    std::string name;
+    // e.g. [N, H, W, C] for the image tensors of a NHWC network
+    std::vector<size_t> shape;
+    // Bytes to the next element of each dimension, tightly packed
+    std::vector<size_t> strides;
+    userbuffer_encoding_t encoding = USERBUFFER_FLOAT;
+    // sizeof(float) or sizeof(uint8_t), follows encoding
+    size_t elementSize = sizeof(float);
+    // Static TF8 encoding of an input, unused for outputs (see TensorHandle::quant).
+    QuantParams quant;
+
+    size_t rank() const {
+        return shape.size();
+    }
+    size_t dim(size_t i) const {
+        return i < shape.size() ? shape[i] : 0;
+    }
+    size_t elements() const {
+        size_t count = shape.empty() ? 0 : 1;
+        for (size_t d : shape) count *= d;
+        return count;
+    }
+    size_t bytes() const {
+        return elements() * elementSize;
+    }
+
+    // NHWC accessors, meaningful for rank 4 tensors only.
+    size_t batch() const {
+        return dim(0);
+    }
+    size_t height() const {
+        return dim(1);
+    }
+    size_t width() const {
+        return dim(2);
+    }
+    size_t channels() const {
+        return dim(3);
+    }
+};
+
+/**
+ * @brief: One tensor of one buffer set, resolved by name once with
+ * SNPETask::getInputHandle()/getOutputHandle(): reading it needs no lookup.
+ * Valid until deInit() of the task, empty if the name or set doesn't exist.
+ */
+struct TensorHandle {
+    // Start of the user buffer, float or uint8_t elements after desc->encoding
+    uint8_t* data = nullptr;
+    const TensorDesc* desc = nullptr;
+    // Inputs: the static encoding of the model. TF8 outputs: refreshed by every
+    // execute() of the buffer set, read it after execute() returns.
+    const QuantParams* quant = nullptr;
+
+    explicit operator bool() const {
+        return nullptr != data;
+    }
+
+    template<typename T>
+    T* as() const {
+        return reinterpret_cast<T*>(data);
+    }
+
+    // First element of batch slot, desc->rank() >= 1.
+    template<typename T>
+    T* slot(size_t index) const {
+        return reinterpret_cast<T*>(data + index * desc->strides[0]);
+    }
+};
+
+}    // namespace snpetask
+
+#endif    // __TENSOR_HANDLE_H__
@@ -140,6 +140,36 @@ static bool parse_args(yolov5::ObjectDetectionConfig& config, const std::string&
                 config.runtime = device2runtime(r);
             }
 
+            if (json_object_has_member(object, "buffer-encoding")) {
+                std::string e((const char*)json_object_get_string_member(object, "buffer-encoding"));
+                LOG_INFO("buffer-encoding: {}", e);
+                config.bufferEncoding = (0 == e.compare("tf8")) ? USERBUFFER_TF8 : USERBUFFER_FLOAT;
+            }
+
+            if (json_object_has_member(object, "nms-method")) {
+                std::string n((const char*)json_object_get_string_member(object, "nms-method"));
+                LOG_INFO("nms-method: {}", n);
+                config.nms.method = yolov5::ParseNMSMethod(n);
+            }
+
+            if (json_object_has_member(object, "nms-class-aware")) {
+                bool c = json_object_get_boolean_member(object, "nms-class-aware");
+                LOG_INFO("nms-class-aware: {}", c);
+                config.nms.classAware = c;
+            }
+
+            if (json_object_has_member(object, "nms-max-candidates")) {
+                int m = json_object_get_int_member(object, "nms-max-candidates");
+                LOG_INFO("nms-max-candidates: {}", m);
+                config.nms.maxCandidates = m;
+            }
+
+            if (json_object_has_member(object, "nms-sigma")) {
+                double s = json_object_get_double_member(object, "nms-sigma");
+                LOG_INFO("nms-sigma: {}", s);
+                config.nms.sigma = (float)s;
+            }
+
             if (json_object_has_member(object, "labels")) {
                 int l = json_object_get_int_member(object, "labels");
                 LOG_INFO("labels: {}", l);
@@ -0,0 +1,79 @@
+/*
+ * @Description: Base64 encoding into caller owned buffers, vectorized where OpenCV has SIMD.
+ * @version: 2.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 23:51:06
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 23:51:06
+ */
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "Base64.h"
+
+static const char kBase64Table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+size_t Base64Encode(const uint8_t* src, size_t size, char* dst)
+{
+    char* out = dst;
+    size_t i = 0;
+#if CV_SIMD
+    // 3 * lanes bytes deinterleaved into b0, b1, b2, split into 4 vectors of 6 bit
+    // indices and mapped to ASCII by adding the offset of their range:
+    // [0, 25] 'A', [26, 51] 'a' - 26, [52, 61] '0' - 52, 62 '+' - 62, 63 '/' - 63.
+    // uint8 lanes have no shifts, they go through uint16 and the bits crossing
+    // into the neighbour byte are masked out.
+    const int lanes = cv::v_uint8::nlanes;
+    const cv::v_uint8 m03 = cv::vx_setall_u8(0x03);
+    const cv::v_uint8 m0f = cv::vx_setall_u8(0x0F);
+    const cv::v_uint8 m3f = cv::vx_setall_u8(0x3F);
+    const cv::v_uint8 n25 = cv::vx_setall_u8(25);
+    const cv::v_uint8 n51 = cv::vx_setall_u8(51);
+    const cv::v_uint8 n62 = cv::vx_setall_u8(62);
+    const cv::v_uint8 n63 = cv::vx_setall_u8(63);
+    const cv::v_uint8 upper = cv::vx_setall_u8('A');
+    const cv::v_uint8 toLower = cv::vx_setall_u8('a' - 26 - 'A');
+    const cv::v_uint8 toDigit = cv::vx_setall_u8((uint8_t)('0' - 52 - ('a' - 26)));
+    const cv::v_uint8 toPlus = cv::vx_setall_u8((uint8_t)('+' - 62 - ('0' - 52)));
+    const cv::v_uint8 toSlash = cv::vx_setall_u8((uint8_t)('/' - 63 - ('0' - 52)));
+
+    auto ascii = [&](const cv::v_uint8& index) {
+        cv::v_uint8 offset = cv::v_add_wrap(upper, (index > n25) & toLower);
+        offset = cv::v_add_wrap(offset, (index > n51) & toDigit);
+        offset = cv::v_add_wrap(offset, (index == n62) & toPlus);
+        offset = cv::v_add_wrap(offset, (index == n63) & toSlash);
+        return cv::v_add_wrap(index, offset);
+    };
+
+    for (; i + 3 * lanes <= size; i += 3 * lanes) {
+        cv::v_uint8 b0, b1, b2;
+        cv::v_load_deinterleave(src + i, b0, b1, b2);
+        cv::v_uint8 i0 = cv::v_reinterpret_as_u8(cv::v_shr<2>(cv::v_reinterpret_as_u16(b0))) & m3f;
+        cv::v_uint8 i1 = cv::v_reinterpret_as_u8(cv::v_shl<4>(cv::v_reinterpret_as_u16(b0 & m03))) |
+                         (cv::v_reinterpret_as_u8(cv::v_shr<4>(cv::v_reinterpret_as_u16(b1))) & m0f);
+        cv::v_uint8 i2 = cv::v_reinterpret_as_u8(cv::v_shl<2>(cv::v_reinterpret_as_u16(b1 & m0f))) |
+                         (cv::v_reinterpret_as_u8(cv::v_shr<6>(cv::v_reinterpret_as_u16(b2))) & m03);
+        cv::v_uint8 i3 = b2 & m3f;
+        cv::v_store_interleave((uint8_t*)out, ascii(i0), ascii(i1), ascii(i2), ascii(i3));
+        out += 4 * lanes;
+    }
+    cv::vx_cleanup();
+#endif
+    for (; i + 3 <= size; i += 3) {
+        uint32_t v = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+        *out++ = kBase64Table[(v >> 18) & 0x3F];
+        *out++ = kBase64Table[(v >> 12) & 0x3F];
+        *out++ = kBase64Table[(v >> 6) & 0x3F];
+        *out++ = kBase64Table[v & 0x3F];
+    }
+    if (i < size) {
+        uint32_t v = src[i] << 16;
+        if (i + 1 < size) v |= src[i + 1] << 8;
+        *out++ = kBase64Table[(v >> 18) & 0x3F];
+        *out++ = kBase64Table[(v >> 12) & 0x3F];
+        *out++ = i + 1 < size ? kBase64Table[(v >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+    return out - dst;
+}
@@ -0,0 +1,33 @@
+/*
+ * @Description: Base64 encoding into caller owned buffers, vectorized where OpenCV has SIMD.
+ * @version: 2.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 23:51:06
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 23:51:06
+ */
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+static inline size_t Base64EncodedSize(size_t size)
+{
+    return (size + 2) / 3 * 4;
+}
+
+/**
+ * @brief: Standard base64 (RFC 4648, padded, no line breaks) of size bytes.
+ * @param {char*} dst: Room for Base64EncodedSize(size) characters, not terminated.
+ * @return {size_t} Characters written.
+ */
+size_t Base64Encode(const uint8_t* src, size_t size, char* dst);
+
+// Appends to out, its capacity is reused.
+static inline void Base64Append(const uint8_t* src, size_t size, std::string& out)
+{
+    size_t pos = out.size();
+    out.resize(pos + Base64EncodedSize(size));
+    Base64Encode(src, size, &out[pos]);
+}
@@ -0,0 +1,70 @@
+/*
+ * @Description: Change detection on the results of a stream, publish on events only.
+ * @version: 2.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-18 00:24:37
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 00:24:37
+ */
+
+#include "utils.h"
+#include "EventFilter.h"
+
+uint8_t EventFilter::Update(const std::vector<DetectionRecord>& objects, int64_t now_ms)
+{
+    uint8_t events = 0;
+    const size_t known = m_tracks.size();
+    for (auto& track : m_tracks) {
+        track.matched = false;
+    }
+
+    for (const auto& object : objects) {
+        // Best free known object, objects entering in this frame can't match.
+        size_t best = known;
+        float bestIoU = m_config.matchIoU;
+        for (size_t i = 0; i < known; i++) {
+            const Track& track = m_tracks[i];
+            if (track.matched || track.model != object.model || track.label != object.label) continue;
+            float iou = calcIoU(track.last, object.bbox);
+            if (iou >= bestIoU) {
+                bestIoU = iou;
+                best = i;
+            }
+        }
+
+        if (known == best) {
+            m_tracks.push_back({object.model, object.label, object.bbox, object.bbox, 0, true});
+            events |= EVENT_ENTER;
+            continue;
+        }
+
+        Track& track = m_tracks[best];
+        track.matched = true;
+        track.last = object.bbox;
+        track.misses = 0;
+        if (calcIoU(track.reported, object.bbox) < m_config.moveIoU) {
+            track.reported = object.bbox;
+            events |= EVENT_MOVE;
+        }
+    }
+
+    // Unmatched objects leave after leaveFrames misses, order doesn't matter.
+    for (size_t i = 0; i < m_tracks.size();) {
+        Track& track = m_tracks[i];
+        if (!track.matched && ++track.misses >= m_config.leaveFrames) {
+            events |= EVENT_LEAVE;
+            track = m_tracks.back();
+            m_tracks.pop_back();
+        } else {
+            i++;
+        }
+    }
+
+    // The first frame is published too: consumers learn the state of the stream.
+    if (!events && (m_lastEmit_ms < 0 ||
+        (m_config.heartbeat_ms > 0 && now_ms - m_lastEmit_ms >= m_config.heartbeat_ms))) {
+        events = EVENT_HEARTBEAT;
+    }
+    if (events) m_lastEmit_ms = now_ms;
+    return events;
+}
@@ -0,0 +1,73 @@
+/*
+ * @Description: Change detection on the results of a stream, publish on events only.
+ * @version: 2.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-18 00:24:37
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 00:24:37
+ */
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "ResultEncoder.h"
+
+// When VideoAnalyzer publishes, mqtt-config "emit".
+typedef enum emit_mode {
+    EMIT_ALWAYS = 0,    // every frame with results (or a snapshot)
+    EMIT_EVENTS         // only when EventFilter reports a change or a heartbeat
+}emit_mode_t;
+
+static inline emit_mode_t ParseEmitMode(const std::string& name)
+{
+    return 0 == name.compare("events") ? EMIT_EVENTS : EMIT_ALWAYS;
+}
+
+struct EventFilterConfig {
+    // Minimum IoU between a detection and a known object of the same model and label
+    float matchIoU = 0.3f;
+    // A known object moved once its IoU with the position last published drops below
+    float moveIoU = 0.7f;
+    // Consecutive frames an object is missed before it leaves, absorbs detector flicker
+    int leaveFrames = 3;
+    // Publish the state anyway after this long without event, 0 never
+    int64_t heartbeat_ms = 10000;
+};
+
+/*
+ * Objects known on one stream, matched frame after frame greedily by IoU. Update()
+ * reports enter, leave and move events, so a static scene publishes nothing but
+ * heartbeats. Moves are measured against the last published position: a slow drift
+ * is reported once it adds up. Not thread safe, a stream is on one worker at a time.
+ */
+class EventFilter {
+public:
+    explicit EventFilter(const EventFilterConfig& config) : m_config(config) {}
+
+    /**
+     * @brief: Match the results of a frame with the known objects.
+     * @return {uint8_t} result_event_t bits, 0 if nothing is to be published.
+     */
+    uint8_t Update(const std::vector<DetectionRecord>& objects, int64_t now_ms);
+
+    size_t Objects() const {
+        return m_tracks.size();
+    }
+
+private:
+    struct Track {
+        uint16_t model;
+        uint16_t label;
+        // Position in the last frame, and the one last published
+        cv::Rect last;
+        cv::Rect reported;
+        int misses;
+        bool matched;
+    };
+
+    EventFilterConfig m_config;
+    std::vector<Track> m_tracks;
+    int64_t m_lastEmit_ms = -1;
+};
@@ -0,0 +1,99 @@
+/*
+ * @Description: Run one task on several persistent threads and join them.
+ * @version: 2.3
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 15:40:12
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 15:40:12
+ */
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Branch 0 runs on the calling thread, every other branch owns a thread for the
+ * whole life of the object, so a fan-out costs two condition variable round trips
+ * instead of thread creations.
+ */
+class FanOut {
+public:
+    // threadInit runs first on each branch thread, e.g. to pin it like the caller.
+    explicit FanOut(size_t branches, std::function<void()> threadInit = nullptr) :
+        m_branches(branches ? branches : 1), m_threadInit(threadInit) {
+        for (size_t i = 1; i < m_branches; i++) {
+            m_threads.emplace_back(&FanOut::Loop, this, i);
+        }
+    }
+
+    ~FanOut() {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            m_stop = true;
+        }
+        m_start.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+
+    FanOut(const FanOut&) = delete;
+    FanOut& operator=(const FanOut&) = delete;
+
+    size_t Branches() const {
+        return m_branches;
+    }
+
+    /**
+     * @brief: Call task(i) for every branch i in parallel, return when all are done.
+     */
+    void Run(const std::function<void(size_t)>& task) {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            m_task = &task;
+            m_pending = m_branches - 1;
+            m_generation++;
+        }
+        m_start.notify_all();
+
+        task(0);
+
+        std::unique_lock<std::mutex> locker(m_mutex);
+        m_done.wait(locker, [this]() { return m_pending == 0; });
+        m_task = nullptr;
+    }
+
+private:
+    void Loop(size_t branch) {
+        if (m_threadInit) m_threadInit();
+
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> locker(m_mutex);
+        for (;;) {
+            m_start.wait(locker, [this, seen]() { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+
+            // m_task stays valid until Run() sees every branch done.
+            const std::function<void(size_t)>* task = m_task;
+            locker.unlock();
+            (*task)(branch);
+            locker.lock();
+
+            if (--m_pending == 0) m_done.notify_one();
+        }
+    }
+
+    const size_t m_branches;
+    std::function<void()> m_threadInit;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(size_t)>* m_task = nullptr;
+    uint64_t m_generation = 0;
+    size_t m_pending = 0;
+    bool m_stop = false;
+};
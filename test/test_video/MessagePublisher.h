@@ -0,0 +1,131 @@
+/*
+ * @Description: Encode and send the detection messages off the inference threads.
+ * @version: 2.4
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 23:18:40
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 00:24:37
+ */
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <memory>
+#include <string>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+#include "utils.h"
+#include "RingQueue.h"
+#include "ResultEncoder.h"
+
+/*
+ * Messages come from a fixed pool: a worker takes a free one with Acquire(), fills
+ * it and Publish()es it, the publisher thread encodes it into a reused buffer, hands
+ * the payload to the sink (mosquitto_publish(), or anything in process) and returns
+ * it to the pool. With every message in flight Acquire() gives nullptr and the frame
+ * goes unreported: a slow broker costs messages, never inference time.
+ * JPEG compression of the snapshots dominates the encoding, threads > 1 spreads it
+ * over a pool with an encoder each. Messages of one camera may then go out of order,
+ * the timestamp tells. The sink is called concurrently by the pool threads.
+ */
+class MessagePublisher {
+public:
+    typedef std::function<bool(const std::string& payload)> sink_t;
+
+    MessagePublisher(size_t capacity, size_t threads, const ResultEncoder& encoder, sink_t sink) :
+        m_capacity(capacity ? capacity : 1), m_threads(threads ? threads : 1),
+        m_free(m_capacity + 1, OVERFLOW_BLOCK), m_pending(m_capacity + m_threads, OVERFLOW_BLOCK),
+        m_encoder(encoder), m_sink(sink) {
+        for (size_t i = 0; i < m_capacity; i++) {
+            m_free.product(std::make_shared<ResultMessage>());
+        }
+    }
+
+    ~MessagePublisher() {
+        Stop();
+    }
+
+    MessagePublisher(const MessagePublisher&) = delete;
+    MessagePublisher& operator=(const MessagePublisher&) = delete;
+
+    bool Start() {
+        if (!m_workers.empty()) return true;
+        for (size_t i = 0; i < m_threads; i++) {
+            m_workers.emplace_back(&MessagePublisher::Loop, this);
+        }
+        return true;
+    }
+
+    // Sends what is already queued, then joins the threads.
+    void Stop() {
+        if (m_workers.empty()) return;
+        // A null message ends one loop, the queue has room for one per thread.
+        for (size_t i = 0; i < m_workers.size(); i++) {
+            m_pending.product(nullptr);
+        }
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+        m_workers.clear();
+    }
+
+    /**
+     * @brief: A cleared message to fill, nullptr if the pool is exhausted.
+     */
+    std::shared_ptr<ResultMessage> Acquire() {
+        std::shared_ptr<ResultMessage> message;
+        if (!m_free.tryConsumption(message)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        message->Clear();
+        return message;
+    }
+
+    void Publish(std::shared_ptr<ResultMessage> message) {
+        if (!message) return;
+        // Nothing to report, straight back to the pool.
+        if (message->objects.empty() && !message->hasSnapshot && !message->events) m_free.product(message);
+        else m_pending.product(message);
+    }
+
+    uint64_t GetPublished() const {
+        return m_published.load(std::memory_order_relaxed);
+    }
+    // Messages lost to a full pool or refused by the sink
+    uint64_t GetDropped() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    void Loop() {
+        ResultEncoder encoder(m_encoder);
+        std::string payload;
+        std::shared_ptr<ResultMessage> message;
+        for (;;) {
+            m_pending.consumption(message);
+            if (!message) break;
+
+            if (!encoder.Encode(*message, payload)) LOG_WARN("Can't compress the snapshot of camera {}.", message->cameraID);
+            if (m_sink(payload)) m_published.fetch_add(1, std::memory_order_relaxed);
+            else m_dropped.fetch_add(1, std::memory_order_relaxed);
+
+            m_free.product(message);
+            message.reset();
+        }
+    }
+
+    size_t m_capacity;
+    size_t m_threads;
+    RingQueue<ResultMessage> m_free;
+    RingQueue<ResultMessage> m_pending;
+    // Prototype, every thread encodes with its own copy
+    const ResultEncoder m_encoder;
+    sink_t m_sink;
+    std::vector<std::thread> m_workers;
+
+    std::atomic<uint64_t> m_published{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
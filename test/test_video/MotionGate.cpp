@@ -0,0 +1,93 @@
+/*
+ * @Description: Block SAD motion gate on the luma of a stream, skips inference on static scenes.
+ * @version: 2.3
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-18 01:36:52
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 01:36:52
+ */
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "MotionGate.h"
+
+// acc[i] += |a[i] - b[i]|, at most 64 rows of 255 stay within uint16.
+static void AccumulateAbsDiffRow(const uint8_t* a, const uint8_t* b, uint16_t* acc, int n)
+{
+    int i = 0;
+#if CV_SIMD
+    // 1 uint8 vector of differences ---> 2 uint16 vectors added to the columns.
+    const int step = cv::v_uint8::nlanes;
+    const int half = cv::v_uint16::nlanes;
+    for (; i <= n - step; i += step) {
+        cv::v_uint16 d0, d1;
+        cv::v_expand(cv::v_absdiff(cv::vx_load(a + i), cv::vx_load(b + i)), d0, d1);
+        cv::v_store(acc + i, cv::vx_load(acc + i) + d0);
+        cv::v_store(acc + i + half, cv::vx_load(acc + i + half) + d1);
+    }
+    cv::vx_cleanup();
+#endif
+    for (; i < n; i++) {
+        acc[i] += std::abs(a[i] - b[i]);
+    }
+}
+
+MotionGate::MotionGate(const MotionGateConfig& config) : m_config(config)
+{
+    m_config.scale = std::max(1, m_config.scale);
+    m_config.block = std::min(std::max(2, m_config.block), 64);
+    m_config.minBlocks = std::max(1, m_config.minBlocks);
+    m_interval_ms = m_config.minFps > 0 ? (int64_t)(1000.0 / m_config.minFps) : 0;
+}
+
+bool MotionGate::Moved() const
+{
+    const int block = m_config.block;
+    const int width = m_current.cols;
+    const int sadLimit = (int)(m_config.threshold * block * block);
+    int changed = 0;
+
+    m_columns.resize(width);
+    // Edge pixels short of a whole block are ignored.
+    for (int y = 0; y + block <= m_current.rows; y += block) {
+        std::fill(m_columns.begin(), m_columns.end(), 0);
+        for (int r = y; r < y + block; r++) {
+            AccumulateAbsDiffRow(m_current.ptr<uint8_t>(r), m_reference.ptr<uint8_t>(r), m_columns.data(), width);
+        }
+        for (int x = 0; x + block <= width; x += block) {
+            int sad = 0;
+            for (int c = x; c < x + block; c++) sad += m_columns[c];
+            if (sad > sadLimit && ++changed >= m_config.minBlocks) return true;
+        }
+    }
+    return false;
+}
+
+bool MotionGate::Update(const cv::Mat& image, int64_t now_ms)
+{
+    if (image.empty()) return true;
+
+    cv::Size size(std::max(m_config.block, image.cols / m_config.scale),
+                  std::max(m_config.block, image.rows / m_config.scale));
+    if (CV_8UC3 == image.type()) {
+        // Downscale first, only the small frame is converted.
+        cv::resize(image, m_small, size, 0, 0, cv::INTER_AREA);
+        cv::cvtColor(m_small, m_current, cv::COLOR_RGB2GRAY);
+    } else if (size == image.size()) {
+        image.copyTo(m_current);
+    } else {
+        cv::resize(image, m_current, size, 0, 0, cv::INTER_AREA);
+    }
+
+    bool due = m_interval_ms > 0 && now_ms >= m_nextDue_ms;
+    bool open = due || m_reference.size() != m_current.size() || Moved();
+    // The buffers trade places, neither is reallocated.
+    if (open) {
+        cv::swap(m_current, m_reference);
+        m_nextDue_ms = now_ms + m_interval_ms;
+    }
+    return open;
+}
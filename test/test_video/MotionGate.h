@@ -0,0 +1,59 @@
+/*
+ * @Description: Block SAD motion gate on the luma of a stream, skips inference on static scenes.
+ * @version: 2.3
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-18 01:36:52
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 01:36:52
+ */
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+
+// pipeline-config "motion-gate" of a stream.
+struct MotionGateConfig {
+    bool enable = false;
+    // Frames are compared at 1 / scale of their size, the area average smooths the sensor noise
+    int scale = 4;
+    // Side of the compared blocks at that size, 2 - 64
+    int block = 8;
+    // Mean absolute luma difference of a changed block
+    float threshold = 10.0f;
+    // Changed blocks making a motion
+    int minBlocks = 1;
+    // Infer a static scene at least that often, 0 never
+    double minFps = 1.0;
+};
+
+/*
+ * Compares each frame with a reference, the last frame the gate let through: slow
+ * changes add up until they open it, and the results of the reference stay valid for
+ * the frames it holds back. Not thread safe, one gate per stream.
+ */
+class MotionGate {
+public:
+    explicit MotionGate(const MotionGateConfig& config);
+
+    /**
+     * @brief: Whether image needs inference: it moved against the reference, or the
+     * scene went 1 / minFps without inference. It then becomes the reference.
+     * @param {cv::Mat&} image: CV_8UC1 luma (the Y plane of a YUV frame) or CV_8UC3 RGB.
+     * @param {int64_t} now_ms: Time of the frame, not decreasing.
+     */
+    bool Update(const cv::Mat& image, int64_t now_ms);
+
+private:
+    bool Moved() const;
+
+    MotionGateConfig m_config;
+    int64_t m_interval_ms = 0;
+    int64_t m_nextDue_ms = 0;
+    cv::Mat m_small;
+    cv::Mat m_current;
+    cv::Mat m_reference;
+    // Absolute differences of a row of blocks, summed column-wise
+    mutable std::vector<uint16_t> m_columns;
+};
@@ -0,0 +1,154 @@
+/*
+ * @Description: Compact JSON and binary encoding of the detection messages.
+ * @version: 2.6
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 23:05:27
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 01:36:52
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+#include <fmt/format.h>
+
+#include "ResultEncoder.h"
+#include "Base64.h"
+
+static std::string escapeJSON(const std::string& text)
+{
+    std::string escaped;
+    for (unsigned char ch : text) {
+        switch (ch) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (ch < 0x20) escaped += fmt::format("\\u{:04x}", ch);
+                else escaped += (char)ch;
+        }
+    }
+    return escaped;
+}
+
+template<typename T>
+static void appendLE(std::string& out, T value)
+{
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::reverse(bytes, bytes + sizeof(T));
+#endif
+    out.append(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
+
+ResultEncoder::ResultEncoder(message_format_t format, const std::vector<std::string>& modelNames,
+                             const std::vector<std::vector<std::string>>& labels, int jpegQuality) : m_format(format)
+{
+    for (const auto& name : modelNames) {
+        m_modelNames.push_back(escapeJSON(name));
+    }
+    for (const auto& modelLabels : labels) {
+        std::vector<std::string> escaped;
+        for (const auto& label : modelLabels) {
+            escaped.push_back(escapeJSON(label));
+        }
+        m_labels.push_back(std::move(escaped));
+    }
+    m_jpegParams = {cv::IMWRITE_JPEG_QUALITY, std::min(std::max(jpegQuality, 1), 100)};
+}
+
+bool ResultEncoder::Encode(const ResultMessage& message, std::string& out)
+{
+    out.clear();
+    return MESSAGE_BINARY == m_format ? EncodeBinary(message, out) : EncodeJSON(message, out);
+}
+
+bool ResultEncoder::CompressSnapshot(const cv::Mat& snapshot)
+{
+    m_jpeg.clear();
+    return !snapshot.empty() && cv::imencode(".jpg", snapshot, m_jpeg, m_jpegParams) && !m_jpeg.empty();
+}
+
+bool ResultEncoder::EncodeJSON(const ResultMessage& message, std::string& out)
+{
+    static const std::string kUnknown;
+    static const char* kEvents[] = {"enter", "leave", "move", "heartbeat"};
+    auto it = std::back_inserter(out);
+    out += '{';
+    if (!message.objects.empty() || message.events) {
+        out += "\"results\":[";
+        for (size_t i = 0; i < message.objects.size(); i++) {
+            const DetectionRecord& object = message.objects[i];
+            const std::string& model = object.model < m_modelNames.size() ? m_modelNames[object.model] : kUnknown;
+            const std::string& label = (object.model < m_labels.size() && object.label < m_labels[object.model].size()) ?
+                m_labels[object.model][object.label] : kUnknown;
+            fmt::format_to(it, "{}{{\"bbox\":{{\"x\":{},\"y\":{},\"width\":{},\"height\":{}}},"
+                "\"confidence\":{},\"label\":\"{}\",\"model\":\"{}\"", i ? "," : "",
+                object.bbox.x, object.bbox.y, object.bbox.width, object.bbox.height,
+                object.confidence, label, model);
+            if (object.trackId >= 0) fmt::format_to(it, ",\"track-id\":{}", object.trackId);
+            out += '}';
+        }
+        fmt::format_to(it, "],\"timestamp\":\"{}\",\"camera-id\":{}", message.timestamp_ms, message.cameraID);
+        if (message.predicted) out += ",\"predicted\":true";
+        if (message.reused) out += ",\"reused\":true";
+        if (message.events) {
+            out += ",\"events\":[";
+            const char* separator = "";
+            for (int bit = 0; bit < 4; bit++) {
+                if (!(message.events & (1 << bit))) continue;
+                fmt::format_to(it, "{}\"{}\"", separator, kEvents[bit]);
+                separator = ",";
+            }
+            out += ']';
+        }
+    }
+
+    bool ok = true;
+    if (message.hasSnapshot) {
+        ok = CompressSnapshot(message.snapshot);
+        if (ok) {
+            out += (message.objects.empty() && !message.events) ? "\"image\":\"" : ",\"image\":\"";
+            Base64Append(m_jpeg.data(), m_jpeg.size(), out);
+            out += '"';
+        }
+    }
+    out += '}';
+    return ok;
+}
+
+bool ResultEncoder::EncodeBinary(const ResultMessage& message, std::string& out)
+{
+    bool hasImage = message.hasSnapshot && CompressSnapshot(message.snapshot);
+    size_t count = std::min<size_t>(message.objects.size(), UINT16_MAX);
+    out.reserve(20 + count * 28 + (hasImage ? 4 + m_jpeg.size() : 0));
+
+    out.append("YV5R", 4);
+    appendLE<uint8_t>(out, kBinaryVersion);
+    uint8_t flags = (hasImage ? 1 : 0) | (message.events & 0x0F) << 1 |
+                    (message.predicted ? 1 << 5 : 0) | (message.reused ? 1 << 6 : 0);
+    appendLE<uint8_t>(out, flags);
+    appendLE<uint16_t>(out, count);
+    appendLE<int32_t>(out, message.cameraID);
+    appendLE<int64_t>(out, message.timestamp_ms);
+    for (size_t i = 0; i < count; i++) {
+        const DetectionRecord& object = message.objects[i];
+        appendLE<int32_t>(out, object.bbox.x);
+        appendLE<int32_t>(out, object.bbox.y);
+        appendLE<int32_t>(out, object.bbox.width);
+        appendLE<int32_t>(out, object.bbox.height);
+        appendLE<float>(out, object.confidence);
+        appendLE<uint16_t>(out, object.model);
+        appendLE<uint16_t>(out, object.label);
+        appendLE<int32_t>(out, object.trackId);
+    }
+    if (hasImage) {
+        appendLE<uint32_t>(out, m_jpeg.size());
+        out.append(reinterpret_cast<const char*>(m_jpeg.data()), m_jpeg.size());
+    }
+    return hasImage || !message.hasSnapshot;
+}
@@ -0,0 +1,127 @@
+/*
+ * @Description: Compact JSON and binary encoding of the detection messages.
+ * @version: 2.7
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 23:05:27
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 01:36:52
+ */
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+
+// Payload of the MQTT messages, mqtt-config "message-format".
+typedef enum message_format {
+    MESSAGE_JSON = 0,   // one line JSON, same fields as before
+    MESSAGE_BINARY      // fixed layout, see ResultEncoder
+}message_format_t;
+
+static inline message_format_t ParseMessageFormat(const std::string& name)
+{
+    return 0 == name.compare("binary") ? MESSAGE_BINARY : MESSAGE_JSON;
+}
+
+// Why an event driven message is sent, bits of ResultMessage::events (see EventFilter).
+typedef enum result_event {
+    EVENT_ENTER = 1 << 0,       // an object appeared
+    EVENT_LEAVE = 1 << 1,       // a known object is gone
+    EVENT_MOVE = 1 << 2,        // a known object moved
+    EVENT_HEARTBEAT = 1 << 3    // nothing changed for "heartbeat-ms"
+}result_event_t;
+
+struct DetectionRecord {
+    cv::Rect bbox;
+    float confidence;
+    // Index in the model list of the config and in the label file of the model
+    uint16_t model;
+    uint16_t label;
+    // Id of the track of the model, -1 without tracker or while tentative
+    int32_t trackId = -1;
+};
+
+/*
+ * One frame worth of results, filled by an inference worker and encoded by the
+ * publisher. Pooled: the vector and the snapshot keep their storage between frames.
+ */
+struct ResultMessage {
+    int cameraID = 0;
+    int64_t timestamp_ms = 0;
+    std::vector<DetectionRecord> objects;
+    // RGB copy of the frame, or of its snapshot ROI scaled down to the snapshot
+    // size; it doesn't share the decoder buffer.
+    cv::Mat snapshot;
+    bool hasSnapshot = false;
+    // result_event_t bits, 0 when every frame is published
+    uint8_t events = 0;
+    // Frame skipped by the detectors of the tracked models, their objects are predicted by the trackers
+    bool predicted = false;
+    // Static frame held back by the motion gate, the objects are the last inferred ones
+    bool reused = false;
+
+    void Clear() {
+        objects.clear();
+        hasSnapshot = false;
+        events = 0;
+        predicted = false;
+        reused = false;
+    }
+};
+
+/*
+ * Writes a ResultMessage into a caller owned buffer, reusing its capacity. Not
+ * thread safe: one encoder per publishing thread, copies are independent.
+ *
+ * JSON: {"results":[{"bbox":{"x":..,"y":..,"width":..,"height":..},"confidence":..,
+ * "label":"..","model":"..","track-id":..}],"timestamp":"<ms>","camera-id":..,
+ * "predicted":true,"reused":true,"events":["enter",..],"image":"<base64 jpeg>"} without
+ * whitespace; "results", "timestamp" and "camera-id" only with objects or events,
+ * "track-id" only for tracked objects, "predicted" and "reused" only when set, "events"
+ * only with events.
+ *
+ * Binary, little endian, no padding:
+ *   header  char[4] "YV5R", u8 version (2), u8 flags (bit 0: image follows,
+ *           bits 1-4: result_event_t bits 0-3, bit 5: predicted, bit 6: reused),
+ *           u16 objects, i32 camera-id, i64 timestamp ms          20 bytes
+ *   object  i32 x, i32 y, i32 width, i32 height, f32 confidence,
+ *           u16 model, u16 label, i32 track-id (-1 untracked)     28 bytes each
+ *   image   u32 size, JPEG bytes                                  if flagged
+ * The binary format is the raw payload option: the JPEG goes out as is, a third
+ * smaller than its base64 in the JSON message and with nothing to encode.
+ * model is the index in "model-configs", label the line in its "label-path".
+ */
+class ResultEncoder {
+public:
+    // jpegQuality: 1 - 100, mqtt-config "snapshot-quality".
+    ResultEncoder(message_format_t format, const std::vector<std::string>& modelNames,
+                  const std::vector<std::vector<std::string>>& labels, int jpegQuality = 90);
+
+    message_format_t Format() const {
+        return m_format;
+    }
+
+    /**
+     * @brief: Encode message into out, previous content is replaced.
+     * @return {bool} false if the snapshot can't be compressed, out holds the message without it.
+     */
+    bool Encode(const ResultMessage& message, std::string& out);
+
+    // 2: track-id appended to the objects
+    static const uint8_t kBinaryVersion = 2;
+
+private:
+    bool EncodeJSON(const ResultMessage& message, std::string& out);
+    bool EncodeBinary(const ResultMessage& message, std::string& out);
+    bool CompressSnapshot(const cv::Mat& snapshot);
+
+    message_format_t m_format;
+    // Names written as JSON string literals, escaped once
+    std::vector<std::string> m_modelNames;
+    std::vector<std::vector<std::string>> m_labels;
+
+    std::vector<uchar> m_jpeg;
+    std::vector<int> m_jpegParams;
+};
@@ -0,0 +1,328 @@
+/*
+ * @Description: Bounded lock-free ring buffers and the frame queue built on them.
+ * @version: 2.3
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 14:32:18
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 14:32:18
+ */
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+static constexpr size_t kCacheLineSize = 64;
+
+static inline size_t RoundUpPow2(size_t n)
+{
+    size_t p = 2;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+/*
+ * Single producer single consumer ring. Each side owns one cache line holding its
+ * index and a cached copy of the other side's index, so the shared line is only
+ * touched when the cached copy says the ring looks full/empty.
+ */
+template<typename T>
+class SPSCRing {
+public:
+    static constexpr bool kMultiConsumer = false;
+
+    explicit SPSCRing(size_t capacity) :
+        m_mask(RoundUpPow2(capacity) - 1), m_slots(new T[m_mask + 1]) {}
+
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    // v is left untouched when the ring is full.
+    bool TryPush(T&& v) {
+        size_t tail = m_producer.index.load(std::memory_order_relaxed);
+        if (tail - m_producer.cache > m_mask) {
+            m_producer.cache = m_consumer.index.load(std::memory_order_acquire);
+            if (tail - m_producer.cache > m_mask) return false;
+        }
+        m_slots[tail & m_mask] = std::move(v);
+        m_producer.index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& v) {
+        size_t head = m_consumer.index.load(std::memory_order_relaxed);
+        if (head == m_consumer.cache) {
+            m_consumer.cache = m_producer.index.load(std::memory_order_acquire);
+            if (head == m_consumer.cache) return false;
+        }
+        // Moving out leaves the slot empty, a shared_ptr doesn't outlive its pop.
+        v = std::move(m_slots[head & m_mask]);
+        m_consumer.index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate while the other side runs.
+    size_t Size() const {
+        return m_producer.index.load(std::memory_order_acquire) - m_consumer.index.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const {
+        return m_mask + 1;
+    }
+
+private:
+    struct alignas(kCacheLineSize) Side {
+        std::atomic<size_t> index{0};
+        size_t cache = 0;
+    };
+
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+    Side m_producer;
+    Side m_consumer;
+};
+
+/*
+ * Multi producer multi consumer ring (Vyukov): every cell carries a sequence number
+ * telling whether it's ready for the push or the pop of a lap, producers and consumers
+ * only contend on their own index with one CAS per operation.
+ */
+template<typename T>
+class MPMCRing {
+public:
+    static constexpr bool kMultiConsumer = true;
+
+    explicit MPMCRing(size_t capacity) :
+        m_mask(RoundUpPow2(capacity) - 1), m_cells(new Cell[m_mask + 1]) {
+        for (size_t i = 0; i <= m_mask; i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCRing(const MPMCRing&) = delete;
+    MPMCRing& operator=(const MPMCRing&) = delete;
+
+    // v is left untouched when the ring is full.
+    bool TryPush(T&& v) {
+        Cell* cell;
+        size_t pos = m_enqueue.index.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0) {
+                if (m_enqueue.index.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueue.index.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(v);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& v) {
+        Cell* cell;
+        size_t pos = m_dequeue.index.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (m_dequeue.index.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeue.index.load(std::memory_order_relaxed);
+            }
+        }
+        v = std::move(cell->value);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate while other threads run.
+    size_t Size() const {
+        size_t tail = m_enqueue.index.load(std::memory_order_acquire);
+        size_t head = m_dequeue.index.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t Capacity() const {
+        return m_mask + 1;
+    }
+
+private:
+    struct alignas(kCacheLineSize) Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    struct alignas(kCacheLineSize) Index {
+        std::atomic<size_t> index{0};
+    };
+
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    Index m_enqueue;
+    Index m_dequeue;
+};
+
+// What product() does when the queue is full.
+typedef enum overflow_policy {
+    OVERFLOW_BLOCK = 0,     // wait for room, like SafetyQueue
+    OVERFLOW_DROP_NEWEST,   // discard the incoming item
+    OVERFLOW_DROP_OLDEST    // discard the oldest queued item, needs a multi consumer ring
+}overflow_policy_t;
+
+// "block", "drop-newest" or "drop-oldest", false and policy untouched if unknown.
+static inline bool ParseOverflowPolicy(const std::string& name, overflow_policy_t& policy)
+{
+    if (0 == name.compare("block")) {
+        policy = OVERFLOW_BLOCK;
+    } else if (0 == name.compare("drop-newest")) {
+        policy = OVERFLOW_DROP_NEWEST;
+    } else if (0 == name.compare("drop-oldest")) {
+        policy = OVERFLOW_DROP_OLDEST;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Productor and consumer queue on a lock-free ring, same product()/consumption()
+ * API as SafetyQueue. The mutex and condition variables are only touched when a
+ * thread has to sleep: a waiter registers itself and re-checks the ring under the
+ * lock, the other side only notifies when it sees a registered waiter.
+ * DROP_OLDEST pops from the producer side, a SPSCRing falls back to DROP_NEWEST.
+ */
+template<typename T, template<typename> class Ring = MPMCRing>
+class RingQueue {
+public:
+    RingQueue(size_t capacity = 4, overflow_policy_t policy = OVERFLOW_DROP_OLDEST) :
+        m_ring(capacity), m_policy(policy) {
+        if (OVERFLOW_DROP_OLDEST == m_policy && !Ring<std::shared_ptr<T>>::kMultiConsumer) {
+            m_policy = OVERFLOW_DROP_NEWEST;
+        }
+    }
+
+    ~RingQueue() {}
+
+    /**
+     * @brief: Non-blocking push.
+     * @return {bool} false if the queue is full, v is not consumed then.
+     */
+    bool tryProduct(const std::shared_ptr<T>& v) {
+        std::shared_ptr<T> item = v;
+        if (!m_ring.TryPush(std::move(item))) return false;
+        wake(m_popWaiters, m_notEmpty);
+        return true;
+    }
+
+    /**
+     * @brief: Non-blocking pop.
+     * @return {bool} false if the queue is empty.
+     */
+    bool tryConsumption(std::shared_ptr<T>& v) {
+        if (!m_ring.TryPop(v)) return false;
+        wake(m_pushWaiters, m_notFull);
+        return true;
+    }
+
+    /**
+     * @brief: Push following the overflow policy.
+     * @return {bool} false if an item was dropped, v or the oldest one.
+     */
+    bool product(const std::shared_ptr<T>& v) {
+        std::shared_ptr<T> item = v;
+        for (;;) {
+            if (m_ring.TryPush(std::move(item))) {
+                wake(m_popWaiters, m_notEmpty);
+                return true;
+            }
+
+            if (OVERFLOW_DROP_NEWEST == m_policy) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            if (OVERFLOW_DROP_OLDEST == m_policy) {
+                std::shared_ptr<T> oldest;
+                if (m_ring.TryPop(oldest)) m_dropped.fetch_add(1, std::memory_order_relaxed);
+                if (m_ring.TryPush(std::move(item))) {
+                    wake(m_popWaiters, m_notEmpty);
+                    return false;
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> locker(m_mutex);
+            m_pushWaiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while (!m_ring.TryPush(std::move(item))) {
+                m_notFull.wait(locker);
+            }
+            m_pushWaiters.fetch_sub(1);
+            locker.unlock();
+            wake(m_popWaiters, m_notEmpty);
+            return true;
+        }
+    }
+
+    /**
+     * @brief: Blocking pop.
+     */
+    void consumption(std::shared_ptr<T>& v) {
+        if (tryConsumption(v)) return;
+
+        std::unique_lock<std::mutex> locker(m_mutex);
+        m_popWaiters.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!m_ring.TryPop(v)) {
+            m_notEmpty.wait(locker);
+        }
+        m_popWaiters.fetch_sub(1);
+        locker.unlock();
+        wake(m_pushWaiters, m_notFull);
+    }
+
+    int queuecount() const {
+        return m_ring.Size();
+    }
+
+    unsigned int getMaxSize() const {
+        return m_ring.Capacity();
+    }
+
+    uint64_t getDropped() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    void wake(std::atomic<int>& waiters, std::condition_variable& cond) {
+        // Pairs with the fence of the waiter: either it sees our item on its
+        // re-check, or we see it registered and notify under the lock.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            cond.notify_one();
+        }
+    }
+
+    Ring<std::shared_ptr<T>> m_ring;
+    overflow_policy_t m_policy;
+
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::atomic<int> m_popWaiters{0};
+    std::atomic<int> m_pushWaiters{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
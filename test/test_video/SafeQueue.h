@@ -12,12 +12,13 @@
 #include <mutex>
 #include <condition_variable>
 #include <iostream>
+#include <memory>
 
 template<typename T>
 class SafetyQueue {
 private:
     std::list<std::shared_ptr<T>> m_queue;
-    std::mutex m_mutex;//全局互斥锁
+    mutable std::mutex m_mutex;//全局互斥锁
     std::condition_variable_any m_notEmpty;//全局条件变量（不为空）
     std::condition_variable_any m_notFull;//全局条件变量（不为满）
     unsigned int m_maxSize;//队列最大容量
@@ -38,6 +39,7 @@ public:
     }
 
     int queuecount() const {
+        std::unique_lock<std::mutex> locker(m_mutex);
         return m_queue.size();
     }
 
@@ -50,6 +52,7 @@ public:
     }
 
     unsigned int getCurrentSize() {
+        std::unique_lock<std::mutex> locker(m_mutex);
         return m_queue.size();
     }
 
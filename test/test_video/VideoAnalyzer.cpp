@@ -1,6 +1,6 @@
 /*
  * @Description: Inference decoded stream with libYOLOv5s.so.
- * @version: 2.2
+ * @version: 2.11
  * @Author: Ricardo Lu<shenglu1202@163.com>
  * @Date: 2022-10-11 11:50:40
  * @LastEditors: Ricardo Lu
@@ -62,59 +62,6 @@ static std::string base64Decode(const char* Data, int DataByte)
 }
  
  
-static std::string base64Encode(const unsigned char* Data, int DataByte)
-{
-    const char EncodeTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
-    std::string strEncode;
-    unsigned char Tmp[4] = { 0 };
-    int LineLength = 0;
-    for (int i = 0; i < (int)(DataByte / 3); i++) {
-        Tmp[1] = *Data++;
-        Tmp[2] = *Data++;
-        Tmp[3] = *Data++;
-        strEncode += EncodeTable[Tmp[1] >> 2];
-        strEncode += EncodeTable[((Tmp[1] << 4) | (Tmp[2] >> 4)) & 0x3F];
-        strEncode += EncodeTable[((Tmp[2] << 2) | (Tmp[3] >> 6)) & 0x3F];
-        strEncode += EncodeTable[Tmp[3] & 0x3F];
-        if (LineLength += 4, LineLength == 76) { strEncode += "\r\n"; LineLength = 0; }
-    }
-
-    int Mod = DataByte % 3;
-    if (Mod == 1) {
-        Tmp[1] = *Data++;
-        strEncode += EncodeTable[(Tmp[1] & 0xFC) >> 2];
-        strEncode += EncodeTable[((Tmp[1] & 0x03) << 4)];
-        strEncode += "==";
-    }
-    else if (Mod == 2) {
-        Tmp[1] = *Data++;
-        Tmp[2] = *Data++;
-        strEncode += EncodeTable[(Tmp[1] & 0xFC) >> 2];
-        strEncode += EncodeTable[((Tmp[1] & 0x03) << 4) | ((Tmp[2] & 0xF0) >> 4)];
-        strEncode += EncodeTable[((Tmp[2] & 0x0F) << 2)];
-        strEncode += "=";
-    }
- 
- 
-    return strEncode;
-}
- 
-//imgType: png bmp jpg jpeg
-static std::string Mat2Base64(const cv::Mat& img, std::string imgType)
-{
-    std::string img_data;
-    std::vector<uchar> vecImg;
-    std::vector<int> vecCompression_params;
-    vecCompression_params.push_back(cv::IMWRITE_JPEG_QUALITY);
-    vecCompression_params.push_back(90);
-    imgType = "." + imgType;
-    cv::imencode(imgType, img, vecImg, vecCompression_params);
-    img_data = base64Encode(vecImg.data(), vecImg.size());
-    return img_data;
-}
- 
- 
 static cv::Mat Base2Mat(std::string& base64_data)
 {
     cv::Mat img;
@@ -145,50 +92,242 @@ static runtime_t device2runtime(std::string&& device)
     }
 }
 
-void VideoAnalyzer::InferenceFrame()
+bool VideoAnalyzer::NextFrame(std::shared_ptr<VideoFrame>& frame, size_t& stream, bool& detect)
 {
-    std::shared_ptr<cv::Mat> image;
+    std::unique_lock<std::mutex> locker(schedMutex);
 
     while (isRunning) {
-        Json::Value root;
-        for (auto& [k, v] : detectors) {
-            std::vector<yolov5::ObjectData> results;
-            consumeQueue->consumption(image);
-            v->Detect(*image.get(), results);
-
-            for (auto& result : results) {
-                if (result.confidence >= thresholds[k][result.label]) {
-                    Json::Value object;
-                    object["bbox"]["x"] = result.bbox.x;
-                    object["bbox"]["y"] = result.bbox.y;
-                    object["bbox"]["width"] = result.bbox.width;
-                    object["bbox"]["height"] = result.bbox.height;
-                    object["confidence"] = result.confidence;
-                    object["label"] = labels[k][result.label];
-                    object["model"] = k;
-                    root["results"].append(object);
+        // Round robin from the stream after the last served one, so a busy
+        // camera can't starve the others.
+        for (size_t i = 0; i < streams.size(); i++) {
+            size_t idx = (streamCursor + i) % streams.size();
+            StreamContext& ctx = streams[idx];
+            if (ctx.busy) continue;
+
+            while (ctx.queue->tryConsumption(frame)) {
+                int64_t now = GetTimeStamp_ms();
+                // Over the frame-rate cap: drop it, its buffer goes back to the decoder.
+                if (ctx.minInterval_ms > 0 && now < ctx.nextDue_ms) {
+                    frame.reset();
+                    continue;
+                }
+
+                ctx.nextDue_ms = now + ctx.minInterval_ms;
+                detect = ctx.detectInterval_ms <= 0 || now >= ctx.nextDetect_ms;
+                if (detect) ctx.nextDetect_ms = now + ctx.detectInterval_ms;
+                ctx.busy = true;
+                streamCursor = idx + 1;
+                stream = idx;
+                lastFrame_ms = now;
+                // Back to work: raise the clocks before this frame runs.
+                if (adaptiveProfile && profileIdle) {
+                    profileIdle = false;
+                    locker.unlock();
+                    ApplyProfile();
+                }
+                return true;
+            }
+        }
+
+        if (adaptiveProfile && !profileIdle && GetTimeStamp_ms() - lastFrame_ms >= idleSwitch_ms) {
+            profileIdle = true;
+            locker.unlock();
+            ApplyProfile();
+            locker.lock();
+            continue;
+        }
+
+        // Notify() wakes us on new frames, the timeout covers capped streams
+        // whose queued frame becomes due.
+        schedCond.wait_for(locker, std::chrono::milliseconds(10));
+    }
+
+    return false;
+}
+
+void VideoAnalyzer::ReleaseStream(size_t stream)
+{
+    {
+        std::lock_guard<std::mutex> locker(schedMutex);
+        streams[stream].busy = false;
+    }
+    schedCond.notify_one();
+}
+
+// Workers switching at the same time may call this in any order, the last
+// one sees the latest wanted state so the detectors end up there.
+void VideoAnalyzer::ApplyProfile()
+{
+    std::lock_guard<std::mutex> locker(profileMutex);
+    bool idle = profileIdle;
+    if (idle == appliedIdle) return;
+    appliedIdle = idle;
+
+    performance_profile_t profile = idle ? idleProfile : busyProfile;
+    for (auto& name : modelNames) {
+        if (!detectors.at(name)->SetPerformanceProfile(profile)) {
+            LOG_WARN("Model {} failed to switch to the {} profile.", name, idle ? "idle" : "busy");
+        }
+    }
+}
+
+void VideoAnalyzer::Notify()
+{
+    std::lock_guard<std::mutex> locker(schedMutex);
+    schedCond.notify_one();
+}
+
+static bool DetectFrame(yolov5::ObjectDetection& detector, const VideoFrame& frame,
+    std::vector<yolov5::ObjectData>& results)
+{
+    // NV12/I420 frames are converted at the model size inside Detect(), frames scaled by
+    // the pipeline are only padded and normalized, their boxes mapped back to the stream size.
+    if (frame.IsLetterboxed()) {
+        if (frame.IsYUV()) return detector.Detect(frame.YUV(), frame.Letterbox(), results);
+        return detector.Detect(frame.Image(), frame.Letterbox(), results);
+    }
+    if (frame.IsYUV()) return detector.Detect(frame.YUV(), results);
+    return detector.Detect(frame.Image(), results);
+}
+
+void VideoAnalyzer::InferenceFrame(int worker)
+{
+    std::shared_ptr<VideoFrame> frame;
+    size_t stream;
+    bool detect;
+
+    std::vector<std::vector<yolov5::ObjectData>> results(modelNames.size());
+    // Swapped with the pooled message, both keep their capacity
+    std::vector<DetectionRecord> records;
+    cv::Mat yuv;
+
+    if (!SetThreadAffinity(workerAffinity)) LOG_WARN("Can't pin worker {}.", worker);
+
+    while (NextFrame(frame, stream, detect)) {
+        StreamContext& ctx = streams[stream];
+        GstClockTime pts = frame->Pts();
+        int64_t timestamp_ms = GST_CLOCK_TIME_IS_VALID(pts) ? (int64_t)GST_TIME_AS_MSECONDS(pts) : GetTimeStamp_ms();
+
+        // Frames the motion gate holds back reuse the results of the last inferred one,
+        // a static scene is still inferred at its "min-fps".
+        bool reuse = false;
+        ctx.frames++;
+        if ((detect || ctx.untracked) && ctx.motion) {
+            const cv::Mat luma = frame->IsYUV() ?
+                cv::Mat(frame->YUV().height, frame->YUV().width, CV_8UC1,
+                        (void*)frame->YUV().planes[0], frame->YUV().strides[0]) : frame->Image();
+            reuse = !ctx.motion->Update(luma, GetTimeStamp_ms());
+        }
+        if (reuse) ctx.reusedFrames++;
+
+        // Every model sees the same frame at the same time, the message is emitted
+        // once all of them are done. Frames over the detection rate only get the
+        // predicted boxes of the tracked models, models without tracker detect them.
+        if (!modelNames.empty()) {
+            fanOuts[worker]->Run([&](size_t branch) {
+                std::vector<yolov5::ObjectData>& objects = results[branch];
+                yolov5::ObjectTracker* tracker = ctx.trackers.empty() ? nullptr : ctx.trackers[branch].get();
+                objects.clear();
+                if (!detect && tracker) {
+                    tracker->Predict(timestamp_ms, objects);
+                    return;
+                }
+                if (reuse) {
+                    objects = ctx.lastResults[branch];
+                    return;
                 }
+                DetectFrame(*detectors.at(modelNames[branch]), *frame, objects);
+                const std::vector<float>& threshold = thresholds.at(modelNames[branch]);
+                objects.erase(std::remove_if(objects.begin(), objects.end(),
+                    [&threshold](const yolov5::ObjectData& object) {
+                        return object.confidence < threshold[object.label];
+                    }), objects.end());
+                if (tracker) tracker->Update(objects, timestamp_ms);
+                if (ctx.motion) ctx.lastResults[branch] = objects;
+            });
+        }
+
+        records.clear();
+        for (size_t m = 0; m < modelNames.size(); m++) {
+            for (auto& result : results[m]) {
+                records.push_back({result.bbox, result.confidence, (uint16_t)m, (uint16_t)result.label, result.trackId});
             }
         }
-        if (root.isMember("results")) {
+
+        // Event driven streams publish changes and heartbeats only, the snapshot
+        // is taken for those frames alone.
+        uint8_t events = 0;
+        bool emit = !records.empty() || mqttConfig.isSendBase64;
+        if (ctx.events) {
+            events = ctx.events->Update(records, GetTimeStamp_ms());
+            emit = 0 != events;
+        }
+
+        // Encoding and sending are left to the publisher thread.
+        std::shared_ptr<ResultMessage> message;
+        if (emit) message = publisher->Acquire();
+        if (message) {
             struct timeval tv;
             gettimeofday(&tv, NULL);
-            long ts = tv.tv_sec * 1000 + tv.tv_usec / 1000;
-            root["timestamp"] = std::to_string(ts);
+            message->timestamp_ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+            message->cameraID = ctx.cameraID;
+            message->objects.swap(records);
+            message->events = events;
+            message->predicted = !detect;
+            message->reused = reuse;
+            // The frame may wrap the decoder buffer, the message keeps a copy made
+            // at the snapshot size, compression is left to the publisher threads.
+            if (mqttConfig.isSendBase64) {
+                message->hasSnapshot = frame->CaptureRGB(mqttConfig.snapshotROI, mqttConfig.snapshotSize,
+                                                         message->snapshot, yuv);
+            }
         }
-        if (mqttConfig.isSendBase64) root["image"] = Mat2Base64(*(image.get()), "jpg");
-        // LOG_INFO("inference result: {}", root.toStyledString());
-        std::string message = root.toStyledString();
-        if (!root.isNull()) mosquitto_publish(mqttClient, nullptr, mqttConfig.topicName.data(), message.size(), message.data(), mqttConfig.QoS, false);
+        // Hand the decoder buffer back to its pool before waiting for the next one.
+        frame.reset();
+        ReleaseStream(stream);
+        publisher->Publish(std::move(message));
     }
 }
 
-void VideoAnalyzer::ParseConfig(Json::Value& root, yolov5::ObjectDetectionConfig& config)
+void VideoAnalyzer::ParseConfig(Json::Value& root, yolov5::ObjectDetectionConfig& config, int workers)
 {
     config.model_path = root["model-path"].asString();
     config.runtime = device2runtime(root["runtime"].asString());
+    // Without an explicit list every worker gets a replica on the same runtime.
+    if (root["runtimes"].isArray()) {
+        int sz = root["runtimes"].size();
+        for (int i = 0; i < sz; ++i)
+            config.runtimes.push_back(device2runtime(root["runtimes"][i].asString()));
+    } else {
+        config.runtimes.assign(workers, config.runtime);
+    }
+    config.initCacheDir = root["init-cache-dir"].asString();
+    config.balanceRuntimes = root["balance-runtimes"].asBool();
+    if (root.isMember("balance-floor-share")) config.balanceFloorShare = root["balance-floor-share"].asFloat();
+    if (root.isMember("performance-profile") &&
+        !ParsePerformanceProfile(root["performance-profile"].asString(), config.performanceProfile)) {
+        LOG_WARN("Unknown performance-profile {}, keep burst.", root["performance-profile"].asString());
+    }
+    config.executionPriority = ParseExecutionPriority(root["execution-priority"].asString());
+    config.cpuFixedPoint = root["cpu-fixed-point"].asBool();
+    if (root["cpu-affinity"].isArray()) {
+        int sz = root["cpu-affinity"].size();
+        for (int i = 0; i < sz; ++i)
+            config.cpuAffinity.push_back(root["cpu-affinity"][i].asInt());
+    }
+    config.stageProfiling = root["stage-profiling"].asBool();
+    config.profileDumpInterval_ms = root["profile-dump-interval-ms"].asInt();
+    config.profileCsv = root["profile-csv"].asString();
+    config.profileTag = root["model-name"].asString();
+    config.profilingLevel = ParseProfilingLevel(root["profiling-level"].asString());
+    config.diagLogDir = root["diag-log-dir"].asString();
+    config.bufferEncoding = (0 == root["buffer-encoding"].asString().compare("tf8")) ? USERBUFFER_TF8 : USERBUFFER_FLOAT;
     config.labels = root["labels"].asInt();
     config.grids = root["grids"].asInt();
+    config.nms.method = yolov5::ParseNMSMethod(root["nms-method"].asString());
+    config.nms.classAware = root["nms-class-aware"].asBool();
+    config.nms.maxCandidates = root["nms-max-candidates"].asInt();
+    if (root.isMember("nms-sigma")) config.nms.sigma = root["nms-sigma"].asFloat();
     if (root["input-layers"].isArray()) {
         int sz = root["input-layers"].size();
         for (int i = 0; i < sz; ++i)
@@ -216,7 +355,7 @@ VideoAnalyzer::~VideoAnalyzer()
     DeInit();
 }
 
-bool VideoAnalyzer::Init(Json::Value& model, Json::Value& mqtt)
+bool VideoAnalyzer::Init(Json::Value& model, Json::Value& mqtt, Json::Value& scheduler)
 {
     mqttConfig.brokerIP = mqtt["ip"].asString();
     mqttConfig.brokerPort = mqtt["port"].asInt();
@@ -224,11 +363,42 @@ bool VideoAnalyzer::Init(Json::Value& model, Json::Value& mqtt)
     mqttConfig.keepAlive = mqtt["keepalive"].asInt();
     mqttConfig.QoS = mqtt["QoS"].asInt();
     mqttConfig.isSendBase64 = mqtt["send-base64"].asBool();
+    mqttConfig.messageFormat = ParseMessageFormat(mqtt["message-format"].asString());
+    if (mqtt.isMember("publish-queue")) mqttConfig.publishQueue = std::max(1, mqtt["publish-queue"].asInt());
+    if (mqtt.isMember("publish-threads")) mqttConfig.publishThreads = std::max(1, mqtt["publish-threads"].asInt());
+    mqttConfig.snapshotSize = cv::Size(std::max(0, mqtt["snapshot-width"].asInt()),
+                                       std::max(0, mqtt["snapshot-height"].asInt()));
+    const Json::Value& roi = mqtt["snapshot-roi"];
+    if (roi.isArray() && 4 == roi.size()) {
+        mqttConfig.snapshotROI = cv::Rect(roi[0].asInt(), roi[1].asInt(), roi[2].asInt(), roi[3].asInt());
+    }
+    if (mqtt.isMember("snapshot-quality")) mqttConfig.snapshotQuality = mqtt["snapshot-quality"].asInt();
+    mqttConfig.emitMode = ParseEmitMode(mqtt["emit"].asString());
+    EventFilterConfig& filter = mqttConfig.eventFilter;
+    if (mqtt.isMember("match-iou")) filter.matchIoU = mqtt["match-iou"].asFloat();
+    if (mqtt.isMember("move-iou")) filter.moveIoU = mqtt["move-iou"].asFloat();
+    if (mqtt.isMember("leave-frames")) filter.leaveFrames = std::max(1, mqtt["leave-frames"].asInt());
+    if (mqtt.isMember("heartbeat-ms")) filter.heartbeat_ms = std::max(0, mqtt["heartbeat-ms"].asInt());
+
+    this->workers = std::max(1, scheduler.isMember("workers") ? scheduler["workers"].asInt() : 1);
+    if (scheduler["cpu-affinity"].isArray()) {
+        int sz = scheduler["cpu-affinity"].size();
+        for (int i = 0; i < sz; ++i)
+            this->workerAffinity.push_back(scheduler["cpu-affinity"][i].asInt());
+    }
+    // Both profiles are needed, the busy one is also the start state of the detectors.
+    if (scheduler.isMember("busy-profile") && scheduler.isMember("idle-profile")) {
+        this->adaptiveProfile = ParsePerformanceProfile(scheduler["busy-profile"].asString(), this->busyProfile) &&
+                                ParsePerformanceProfile(scheduler["idle-profile"].asString(), this->idleProfile);
+        if (!this->adaptiveProfile) LOG_WARN("Unknown busy-profile or idle-profile, adaptive profile disabled.");
+        if (scheduler.isMember("idle-ms")) this->idleSwitch_ms = scheduler["idle-ms"].asInt64();
+    }
 
     if (model.isArray()) {
         int sz = model.size();
         for (int i = 0; i < sz; ++i) {
             std::string modelName = model[i]["model-name"].asString();
+            this->modelNames.push_back(modelName);
             std::ifstream in(model[i]["label-path"].asString());
             std::string line;
             std::vector<std::string> label;
@@ -246,49 +416,144 @@ bool VideoAnalyzer::Init(Json::Value& model, Json::Value& mqtt)
             this->thresholds[modelName] = threshold;
             in.close();
 
-            std::shared_ptr<yolov5::ObjectDetection> detector = std::shared_ptr<yolov5::ObjectDetection>(new yolov5::ObjectDetection());
+            const Json::Value& tracker = model[i]["tracker"];
+            if (tracker.isObject()) {
+                yolov5::TrackerConfig trackerConfig;
+                if (tracker.isMember("match-iou")) trackerConfig.matchIoU = tracker["match-iou"].asFloat();
+                if (tracker.isMember("min-hits")) trackerConfig.minHits = std::max(1, tracker["min-hits"].asInt());
+                if (tracker.isMember("max-age-ms")) trackerConfig.maxAge_ms = tracker["max-age-ms"].asInt64();
+                if (tracker.isMember("process-noise")) trackerConfig.processNoise = tracker["process-noise"].asFloat();
+                if (tracker.isMember("measurement-noise")) trackerConfig.measurementNoise = tracker["measurement-noise"].asFloat();
+                this->trackerConfigs[modelName] = trackerConfig;
+            }
+
             yolov5::ObjectDetectionConfig config;
-            ParseConfig(model[i], config);
+            ParseConfig(model[i], config, this->workers);
+            if (this->adaptiveProfile) config.performanceProfile = this->busyProfile;
+            std::shared_ptr<yolov5::ObjectDetection> detector = std::shared_ptr<yolov5::ObjectDetection>(new yolov5::ObjectDetection());
             detector->Init(config);
             detector->SetScoreThreshold(model[i]["global-threshold"].asFloat(), 0.5);
             this->detectors[modelName] = detector;
         }
     }
     
+    // The branches running models 2..N share the CPUs of their worker.
+    for (int i = 0; i < this->workers; i++) {
+        this->fanOuts.emplace_back(new FanOut(this->modelNames.size(), [this, i]() {
+            if (!SetThreadAffinity(this->workerAffinity)) LOG_WARN("Can't pin a model branch of worker {}.", i);
+        }));
+    }
+
     mosquitto_lib_init();
     mqttClient = mosquitto_new(nullptr, true, nullptr);
     mosquitto_connect_async(mqttClient, mqttConfig.brokerIP.data(), mqttConfig.brokerPort, mqttConfig.keepAlive);
 
+    std::vector<std::vector<std::string>> modelLabels;
+    for (auto& name : this->modelNames) {
+        modelLabels.push_back(this->labels.at(name));
+    }
+    ResultEncoder encoder(mqttConfig.messageFormat, this->modelNames, modelLabels, mqttConfig.snapshotQuality);
+    this->publisher.reset(new MessagePublisher(mqttConfig.publishQueue, mqttConfig.publishThreads, encoder,
+        [this](const std::string& payload) {
+            return MOSQ_ERR_SUCCESS == mosquitto_publish(mqttClient, nullptr, mqttConfig.topicName.data(),
+                payload.size(), payload.data(), mqttConfig.QoS, false);
+        }));
+
     return true;
 }
 
 bool VideoAnalyzer::DeInit()
 {
+    {
+        std::lock_guard<std::mutex> locker(schedMutex);
+        isRunning = false;
+    }
+    schedCond.notify_all();
+    bool started = !inferThreads.empty();
+    for (auto& inferThread : inferThreads) {
+        inferThread->join();
+    }
+    inferThreads.clear();
+
+    // Flush the queued messages while the client is still connected.
+    if (publisher) publisher->Stop();
     mosquitto_disconnect(mqttClient);
     mosquitto_loop_stop(mqttClient, true);
+    if (!started) return true;
 
-    if (inferThread) {
-        isRunning = false;
-        inferThread->join();
-        inferThread = nullptr;
+    LOG_INFO("MQTT messages: {} published, {} dropped.", publisher->GetPublished(), publisher->GetDropped());
+    for (auto& ctx : streams) {
+        if (!ctx.motion) continue;
+        LOG_INFO("Camera {}: {} of {} frames static, results reused.", ctx.cameraID, ctx.reusedFrames, ctx.frames);
     }
+
+    for (auto& name : modelNames) {
+        std::vector<yolov5::ReplicaUsage> usage;
+        if (!detectors.at(name)->GetReplicaUsage(usage)) continue;
+        for (auto& replica : usage) {
+            LOG_INFO("Model {} replica {}: {} frames, {:.1f} ms per frame, utilization {:.1f}%.",
+                name, replica.name, replica.frames, replica.latency_ms, replica.utilization * 100.0);
+        }
+
+        std::vector<yolov5::StageProfile> profile;
+        if (!detectors.at(name)->GetStageProfile(profile)) continue;
+        for (auto& stage : profile) {
+            LOG_INFO("Model {} stage {}: {} samples, mean {:.2f} ms, p50 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms.",
+                name, stage.stage, stage.count, stage.mean_ms, stage.p50_ms, stage.p99_ms, stage.max_ms);
+        }
+    }
+
+    return true;
 }
 
 bool VideoAnalyzer::Start()
 {
     mosquitto_loop_start(mqttClient);
+    publisher->Start();
 
     isRunning = true;
-    if (!(inferThread = std::make_shared<std::thread>(std::bind(&VideoAnalyzer::InferenceFrame, this)))) {
-        LOG_ERROR("Failed to new a std::thread object");
-        isRunning = false;
-        return false;
+    lastFrame_ms = GetTimeStamp_ms();
+    for (int i = 0; i < workers; i++) {
+        std::shared_ptr<std::thread> inferThread;
+        if (!(inferThread = std::make_shared<std::thread>(std::bind(&VideoAnalyzer::InferenceFrame, this, i)))) {
+            LOG_ERROR("Failed to new a std::thread object");
+            DeInit();
+            return false;
+        }
+        inferThreads.push_back(inferThread);
     }
 
     return true;
 }
 
-void VideoAnalyzer::SetUserData(std::shared_ptr<SafetyQueue<cv::Mat>> user_data)
+void VideoAnalyzer::SetUserData(std::shared_ptr<RingQueue<VideoFrame>> user_data)
+{
+    AddStream(0, user_data);
+}
+
+void VideoAnalyzer::AddStream(int cameraID, std::shared_ptr<RingQueue<VideoFrame>> queue, double maxFps,
+                              double detectFps, const MotionGateConfig& motion)
 {
-    consumeQueue = user_data;
+    StreamContext ctx;
+    ctx.cameraID = cameraID;
+    ctx.queue = queue;
+    ctx.minInterval_ms = maxFps > 0 ? (int64_t)(1000.0 / maxFps) : 0;
+    if (!trackerConfigs.empty()) {
+        for (auto& name : modelNames) {
+            auto it = trackerConfigs.find(name);
+            ctx.trackers.emplace_back(trackerConfigs.end() == it ? nullptr : new yolov5::ObjectTracker(it->second));
+            if (!ctx.trackers.back()) ctx.untracked = true;
+        }
+        ctx.detectInterval_ms = detectFps > 0 ? (int64_t)(1000.0 / detectFps) : 0;
+    } else if (detectFps > 0) {
+        LOG_WARN("Camera {}: detect-fps needs a model with a tracker, ignored.", cameraID);
+    }
+    if (motion.enable) {
+        ctx.motion = std::make_shared<MotionGate>(motion);
+        ctx.lastResults.resize(modelNames.size());
+    }
+    if (EMIT_EVENTS == mqttConfig.emitMode) ctx.events = std::make_shared<EventFilter>(mqttConfig.eventFilter);
+
+    std::lock_guard<std::mutex> locker(schedMutex);
+    streams.push_back(ctx);
 }
@@ -1,6 +1,6 @@
 /*
  * @Description: Inference decoded stream with libYOLOv5s.so.
- * @version: 2.2
+ * @version: 2.9
  * @Author: Ricardo Lu<sheng.lu@thundercomm.com>
  * @Date: 2022-10-11 11:50:34
  * @LastEditors: Ricardo Lu
@@ -14,6 +14,9 @@
 #include <functional>
 #include <string>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 #include <opencv2/opencv.hpp>
 #include <jsoncpp/json/json.h>
@@ -21,8 +24,14 @@
 
 #include "YOLOv5s.h"
 #include "YOLOv5sImpl.h"
+#include "Tracker.h"
 #include "utils.h"
-#include "SafeQueue.h"
+#include "RingQueue.h"
+#include "VideoFrame.h"
+#include "FanOut.h"
+#include "MessagePublisher.h"
+#include "EventFilter.h"
+#include "MotionGate.h"
 
 struct MQTTClientConfig {
     std::string brokerIP;
@@ -31,30 +40,125 @@ struct MQTTClientConfig {
     int QoS;
     std::string topicName;
     bool isSendBase64;
+    message_format_t messageFormat = MESSAGE_JSON;
+    // Messages waiting for the publisher threads, more are dropped
+    int publishQueue = 32;
+    // Threads compressing and sending the messages
+    int publishThreads = 1;
+    // Part of the frame sent, the whole frame if empty
+    cv::Rect snapshotROI;
+    // Bounds of the sent image, scaled down with its aspect ratio kept; 0 x 0 for full size
+    cv::Size snapshotSize;
+    int snapshotQuality = 90;
+    emit_mode_t emitMode = EMIT_ALWAYS;
+    EventFilterConfig eventFilter;
+};
+
+/*
+ * One camera feeding the analyzer, scheduling state is guarded by the scheduler mutex.
+ */
+struct StreamContext {
+    int cameraID;
+    std::shared_ptr<RingQueue<VideoFrame>> queue;
+    // Minimum time between two inferred frames, 0 for no frame-rate cap
+    int64_t minInterval_ms = 0;
+    int64_t nextDue_ms = 0;
+    // A worker is on a frame of this stream, keeps results of a stream in order
+    bool busy = false;
+    // EMIT_EVENTS only, touched by the worker holding the stream
+    std::shared_ptr<EventFilter> events;
+    // Minimum time between two detected frames of the tracked models, the others are tracked only
+    int64_t detectInterval_ms = 0;
+    int64_t nextDetect_ms = 0;
+    // A model without tracker, it is detected on every frame whatever detectInterval_ms
+    bool untracked = false;
+    // One per model, null for models without "tracker"; touched by the worker holding the stream
+    std::vector<std::shared_ptr<yolov5::ObjectTracker>> trackers;
+    // "motion-gate" only, touched by the worker holding the stream: frames held back
+    // by the gate reuse lastResults, the results of the last inferred frame per model.
+    std::shared_ptr<MotionGate> motion;
+    std::vector<std::vector<yolov5::ObjectData>> lastResults;
+    uint64_t frames = 0;
+    uint64_t reusedFrames = 0;
 };
 
 class VideoAnalyzer {
 public:
     VideoAnalyzer();
     ~VideoAnalyzer();
-    bool Init(Json::Value& model, Json::Value& mqtt);
+    /**
+     * @brief: Load every model once, with one SNPE replica per worker unless the model
+     * config lists its "runtimes". Frames of all streams are shared by the workers.
+     * scheduler: "workers", their "cpu-affinity" and the adaptive profile, see
+     * "busy-profile", "idle-profile" and "idle-ms".
+     */
+    bool Init(Json::Value& model, Json::Value& mqtt, Json::Value& scheduler);
     bool DeInit();
     bool Start();
-    void SetUserData(std::shared_ptr<SafetyQueue<cv::Mat>> user_data);
+    void SetUserData(std::shared_ptr<RingQueue<VideoFrame>> user_data);
+    /**
+     * @brief: Register a camera after Init() and before Start(), maxFps <= 0 infers every
+     * frame. Frames over detectFps aren't detected by the tracked models: their results
+     * are the boxes predicted by their trackers. Models without tracker detect every
+     * frame. With motion.enable, frames
+     * without motion reuse the results of the last inferred one.
+     */
+    void AddStream(int cameraID, std::shared_ptr<RingQueue<VideoFrame>> queue, double maxFps = 0,
+                   double detectFps = 0, const MotionGateConfig& motion = MotionGateConfig());
+    /**
+     * @brief: Wake an idle worker, called by pipelines when a frame is queued.
+     */
+    void Notify();
+    /**
+     * @brief: Messages carry the full resolution frame, letterboxing pipelines must attach it.
+     */
+    bool NeedsSnapshots() const {
+        return mqttConfig.isSendBase64;
+    }
 
 private:
-    void ParseConfig(Json::Value& root, yolov5::ObjectDetectionConfig& config);
+    void ParseConfig(Json::Value& root, yolov5::ObjectDetectionConfig& config, int workers);
+    bool NextFrame(std::shared_ptr<VideoFrame>& frame, size_t& stream, bool& detect);
+    void ReleaseStream(size_t stream);
+    void ApplyProfile();
 
 private:
     bool isRunning;
-    void InferenceFrame();
-    std::shared_ptr<std::thread> inferThread;
+    void InferenceFrame(int worker);
+    std::vector<std::shared_ptr<std::thread>> inferThreads;
 
     MQTTClientConfig mqttConfig;
     struct mosquitto* mqttClient;
+    // Encodes and sends the messages, the workers only fill them
+    std::unique_ptr<MessagePublisher> publisher;
+
+    int workers = 1;
+    std::vector<int> workerAffinity;
 
+    // Adaptive accelerator profile: busyProfile as soon as frames come in,
+    // idleProfile after idleSwitch_ms without any.
+    bool adaptiveProfile = false;
+    performance_profile_t busyProfile = PROFILE_BURST;
+    performance_profile_t idleProfile = PROFILE_POWER_SAVER;
+    int64_t idleSwitch_ms = 1000;
+    int64_t lastFrame_ms = 0;
+    // Wanted state, set under schedMutex. The applied one is only touched under profileMutex.
+    std::atomic<bool> profileIdle{false};
+    bool appliedIdle = false;
+    std::mutex profileMutex;
+    // Shared by the workers, each Detect() leases a free replica. Model name as key
     std::unordered_map<std::string, std::shared_ptr<yolov5::ObjectDetection>> detectors;
+    // Model names in config order, the branch order of every fan-out
+    std::vector<std::string> modelNames;
+    // One branch per model and worker, a frame runs all models concurrently
+    std::vector<std::unique_ptr<FanOut>> fanOuts;
     std::unordered_map<std::string, std::vector<std::string>> labels;
     std::unordered_map<std::string, std::vector<float>> thresholds;
-    std::shared_ptr<SafetyQueue<cv::Mat>> consumeQueue;
+    // Models with a "tracker", every stream gets its own trackers
+    std::unordered_map<std::string, yolov5::TrackerConfig> trackerConfigs;
+
+    std::vector<StreamContext> streams;
+    size_t streamCursor = 0;
+    std::mutex schedMutex;
+    std::condition_variable schedCond;
 };
\ No newline at end of file
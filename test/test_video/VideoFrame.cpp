@@ -0,0 +1,173 @@
+/*
+ * @Description: Decoded frame handle sharing the appsink buffer without copy.
+ * @version: 2.5
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 14:05:36
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 23:51:06
+ */
+
+#include <gst/video/video.h>
+
+#include "Logger.h"
+#include "VideoFrame.h"
+
+VideoFrame::VideoFrame(GstSample* sample) : m_sample(sample)
+{
+}
+
+VideoFrame::~VideoFrame()
+{
+    m_image.release();
+    if (m_mapped) {
+        gst_buffer_unmap(m_buffer, &m_map);
+    }
+    if (m_sample) {
+        gst_sample_unref(m_sample);
+    }
+}
+
+std::shared_ptr<VideoFrame> VideoFrame::Wrap(GstSample* sample)
+{
+    GstVideoInfo info;
+    GstVideoMeta* meta = NULL;
+    GstCaps* caps = NULL;
+    gsize offset = 0;
+    gint stride = 0;
+
+    if (!sample) {
+        return nullptr;
+    }
+
+    // From here on the destructor releases the sample on every error path.
+    std::shared_ptr<VideoFrame> frame(new VideoFrame(sample));
+
+    if (!(frame->m_buffer = gst_sample_get_buffer(sample))) {
+        LOG_ERROR("Can't get buffer from sample.");
+        return nullptr;
+    }
+
+    if (!(caps = gst_sample_get_caps(sample)) || !gst_video_info_from_caps(&info, caps)) {
+        LOG_ERROR("Can't get video info from sample.");
+        return nullptr;
+    }
+
+    switch (GST_VIDEO_INFO_FORMAT(&info)) {
+    case GST_VIDEO_FORMAT_RGB:
+    case GST_VIDEO_FORMAT_BGR:
+    case GST_VIDEO_FORMAT_NV12:
+    case GST_VIDEO_FORMAT_I420:
+        break;
+    default:
+        LOG_ERROR("Unsupported frame format: {}", GST_VIDEO_INFO_NAME(&info));
+        return nullptr;
+    }
+
+    if (!gst_buffer_map(frame->m_buffer, &frame->m_map, GST_MAP_READ)) {
+        LOG_ERROR("Can't map buffer of sample.");
+        return nullptr;
+    }
+    frame->m_mapped = true;
+
+    int width = GST_VIDEO_INFO_WIDTH(&info);
+    int height = GST_VIDEO_INFO_HEIGHT(&info);
+    // Hardware converters may pad rows and planes, the meta describes the real layout.
+    meta = gst_buffer_get_video_meta(frame->m_buffer);
+    for (guint i = 0; i < GST_VIDEO_INFO_N_PLANES(&info); i++) {
+        if (meta) {
+            offset = meta->offset[i];
+            stride = meta->stride[i];
+        } else {
+            offset = GST_VIDEO_INFO_PLANE_OFFSET(&info, i);
+            stride = GST_VIDEO_INFO_PLANE_STRIDE(&info, i);
+        }
+
+        // Chroma planes of 4:2:0 have half the rows.
+        int rows = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT(info.finfo, i, height);
+        if (offset + (gsize)stride * rows > frame->m_map.size) {
+            LOG_ERROR("Buffer size {} is too small for {}x{} plane {} stride {}",
+                frame->m_map.size, width, height, i, stride);
+            return nullptr;
+        }
+
+        if (GST_VIDEO_INFO_IS_RGB(&info)) {
+            frame->m_image = cv::Mat(height, width, CV_8UC3, frame->m_map.data + offset, stride);
+        } else {
+            frame->m_yuv.planes[i] = frame->m_map.data + offset;
+            frame->m_yuv.strides[i] = stride;
+        }
+    }
+
+    if (GST_VIDEO_INFO_IS_YUV(&info)) {
+        frame->m_yuv.format = GST_VIDEO_INFO_FORMAT(&info) == GST_VIDEO_FORMAT_NV12 ?
+            PIXEL_FORMAT_NV12 : PIXEL_FORMAT_I420;
+        frame->m_yuv.width = width;
+        frame->m_yuv.height = height;
+    }
+    return frame;
+}
+
+bool VideoFrame::ToRGB(cv::Mat& rgb) const
+{
+    if (IsLetterboxed()) {
+        std::shared_ptr<VideoFrame> full = Snapshot();
+        return full && full->ToRGB(rgb);
+    }
+
+    if (!IsYUV()) {
+        rgb = m_image;
+        return !rgb.empty();
+    }
+
+    cv::Mat yuv;
+    if (!yolov5::ResizeYUVToRGB(m_yuv, m_yuv.width, m_yuv.height, yuv, rgb)) {
+        return false;
+    }
+    // Odd sizes come back one column/row larger.
+    rgb = rgb(cv::Rect(0, 0, m_yuv.width, m_yuv.height));
+    return true;
+}
+
+bool VideoFrame::CaptureRGB(const cv::Rect& roi, const cv::Size& maxSize, cv::Mat& rgb, cv::Mat& yuv) const
+{
+    if (IsLetterboxed()) {
+        std::shared_ptr<VideoFrame> full = Snapshot();
+        return full && full->CaptureRGB(roi, maxSize, rgb, yuv);
+    }
+
+    const cv::Rect frameRect = IsYUV() ? cv::Rect(0, 0, m_yuv.width, m_yuv.height) :
+                                         cv::Rect(0, 0, m_image.cols, m_image.rows);
+    cv::Rect area = roi.empty() ? frameRect : (roi & frameRect);
+    if (area.empty()) return false;
+
+    cv::Size size = area.size();
+    if (maxSize.width > 0 && maxSize.height > 0 &&
+        (size.width > maxSize.width || size.height > maxSize.height)) {
+        double scale = std::min((double)maxSize.width / size.width, (double)maxSize.height / size.height);
+        size.width = std::max(1, (int)(size.width * scale));
+        size.height = std::max(1, (int)(size.height * scale));
+    }
+
+    if (!IsYUV()) {
+        cv::Mat src = m_image(area);
+        if (size == area.size()) src.copyTo(rgb);
+        else cv::resize(src, rgb, size, 0, 0, cv::INTER_AREA);
+        return true;
+    }
+
+    // Even corners and size keep the crop on the chroma grid and the result exact,
+    // a view with the odd column/row cut would reallocate rgb on every call.
+    area.x &= ~1;
+    area.y &= ~1;
+    if (size == area.size()) {
+        area.width &= ~1;
+        area.height &= ~1;
+        size = area.size();
+    } else {
+        size.width &= ~1;
+        size.height &= ~1;
+    }
+    if (size.width < 2 || size.height < 2) return false;
+
+    return yolov5::ResizeYUVToRGB(yolov5::CropYUV(m_yuv, area), size.width, size.height, yuv, rgb);
+}
@@ -0,0 +1,113 @@
+/*
+ * @Description: Decoded frame handle sharing the appsink buffer without copy.
+ * @version: 2.5
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 14:05:36
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 23:51:06
+ */
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include <opencv2/opencv.hpp>
+#include <gst/gst.h>
+
+#include "ImageProcess.h"
+
+/*
+ * Holds a reference of the GstSample and keeps its buffer mapped, Image() wraps
+ * the mapped memory in place. The buffer goes back to the upstream pool when the
+ * last shared_ptr is released, so consumers should not hold frames longer than needed.
+ * The mapping is read only, never write into Image().
+ * RGB/BGR frames come as Image(), NV12/I420 ones as YUV() planes and Image() is empty.
+ * Frames letterboxed by the pipeline carry their geometry and, when snapshots are on,
+ * the full resolution frame of the same PTS (see VideoPipelineConfig::modelWidth).
+ */
+class VideoFrame {
+public:
+    /**
+     * @brief: Take over the reference of sample and map its buffer.
+     * @return {std::shared_ptr<VideoFrame>} nullptr if the sample can't be mapped,
+     * the sample is released in that case too.
+     */
+    static std::shared_ptr<VideoFrame> Wrap(GstSample* sample);
+
+    ~VideoFrame();
+    VideoFrame(const VideoFrame&) = delete;
+    VideoFrame& operator=(const VideoFrame&) = delete;
+
+    const cv::Mat& Image() const {
+        return m_image;
+    }
+
+    bool IsYUV() const {
+        return !m_yuv.empty();
+    }
+
+    const yolov5::YUVImage& YUV() const {
+        return m_yuv;
+    }
+
+    void SetLetterbox(const yolov5::LetterboxInfo& letterbox) {
+        m_letterbox = letterbox;
+        m_isLetterboxed = true;
+    }
+
+    bool IsLetterboxed() const {
+        return m_isLetterboxed;
+    }
+
+    // Position of the full resolution frame inside this one
+    const yolov5::LetterboxInfo& Letterbox() const {
+        return m_letterbox;
+    }
+
+    // Called from the streaming thread while a worker may already hold the frame.
+    void AttachSnapshot(std::shared_ptr<VideoFrame> full) {
+        std::lock_guard<std::mutex> locker(m_snapshotMutex);
+        m_snapshot = std::move(full);
+    }
+
+    std::shared_ptr<VideoFrame> Snapshot() const {
+        std::lock_guard<std::mutex> locker(m_snapshotMutex);
+        return m_snapshot;
+    }
+
+    /**
+     * @brief: Full resolution RGB copy of a YUV frame, Image() itself for RGB ones.
+     * A letterboxed frame converts its attached snapshot, false without one.
+     * Costly, for snapshots only.
+     */
+    bool ToRGB(cv::Mat& rgb) const;
+
+    /**
+     * @brief: Owned RGB copy of roi (the whole frame if empty, clipped to it) scaled
+     * down to fit maxSize with its aspect ratio kept (no scaling if empty). YUV frames
+     * are converted at the output size, so a small snapshot costs a small conversion.
+     * A letterboxed frame captures from its attached snapshot, false without one.
+     * @param {cv::Mat&} rgb: Result, its storage is reused when the size doesn't change.
+     * @param {cv::Mat&} yuv: Reused working buffer.
+     */
+    bool CaptureRGB(const cv::Rect& roi, const cv::Size& maxSize, cv::Mat& rgb, cv::Mat& yuv) const;
+
+    GstClockTime Pts() const {
+        return m_buffer ? GST_BUFFER_PTS(m_buffer) : GST_CLOCK_TIME_NONE;
+    }
+
+private:
+    explicit VideoFrame(GstSample* sample);
+
+    GstSample* m_sample = NULL;
+    GstBuffer* m_buffer = NULL;
+    GstMapInfo m_map;
+    bool m_mapped = false;
+    cv::Mat m_image;
+    yolov5::YUVImage m_yuv;
+
+    bool m_isLetterboxed = false;
+    yolov5::LetterboxInfo m_letterbox;
+    mutable std::mutex m_snapshotMutex;
+    std::shared_ptr<VideoFrame> m_snapshot;
+};
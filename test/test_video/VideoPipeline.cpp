@@ -1,6 +1,6 @@
 /*
  * @Description: Decode stream pipeline.
- * @version: 2.2
+ * @version: 2.4
  * @Author: Ricardo Lu<shenglu1202@163.com>
  * @Date: 2022-10-11 10:46:02
  * @LastEditors: Ricardo Lu
@@ -19,69 +19,68 @@ static GstFlowReturn cb_appsink_new_sample(
     GstElement* appsink,
     gpointer user_data)
 {
-    const GstStructure* info = NULL;
-    GstBuffer* buffer = NULL;
-    GstMapInfo map;
     GstSample* sample = NULL;
-    GstCaps* caps = NULL;
-    int sample_width = 0;
-    int sample_height = 0;
 
     VideoPipeline* vp = static_cast<VideoPipeline*>(user_data);
 
     if (!vp->dump) {
-        GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(vp->pipeline), GST_DEBUG_GRAPH_SHOW_ALL, "video-pipeline");
+        GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(vp->pipeline), GST_DEBUG_GRAPH_SHOW_ALL, GST_OBJECT_NAME(vp->pipeline));
         vp->dump = true;
     }
 
     g_signal_emit_by_name(appsink, "pull-sample", &sample);
     if (!sample) {
         return GST_FLOW_OK;
-    } else {
-        buffer = gst_sample_get_buffer(sample);
-        if (buffer == NULL) {
-            LOG_ERROR("Can't get buffer from sample.");
-            goto err;
-        }
-        gst_buffer_map(buffer, &map, GST_MAP_READ);
+    }
 
-        caps = gst_sample_get_caps(sample);
-        if (caps == NULL) {
-            LOG_ERROR("Can't get caps from sample.");
-            goto err;
+    // appsink algorithm productor queue produce: the frame owns the sample
+    // and shares the decoded buffer in place, no deep copy.
+    std::shared_ptr<VideoFrame> frame = VideoFrame::Wrap(sample);
+    if (frame) {
+        if (vp->IsLetterboxing()) {
+            frame->SetLetterbox(vp->letterbox);
+            vp->PairFrame(frame);
         }
+        vp->productQueue->product(frame);
+        if (vp->onFrame) vp->onFrame();
+    }
 
-        info = gst_caps_get_structure(caps, 0);
-        if (info == NULL) {
-            LOG_ERROR("Can't get info from sample.");
-            goto err;
-        }
+    return GST_FLOW_OK;
+}
 
-        // ---- Read frame and convert to opencv format ---------------
-        // convert gstreamer data to OpenCV Mat, you could actually
-        // resolve height / width from caps...
-        gst_structure_get_int(info, "width", &sample_width);
-        gst_structure_get_int(info, "height", &sample_height);
-
-        // appsink algorithm productor queue produce
-        {
-            // init a tmpMat with gst buffer address: deep copy
-            cv::Mat tmpMat(sample_height, sample_width, CV_8UC3, (unsigned char*)map.data, cv::Mat::AUTO_STEP);
-            tmpMat = tmpMat.clone();
-            vp->productQueue->product(std::make_shared<cv::Mat>(tmpMat));
-        }
-    }
+static GstFlowReturn cb_snapsink_new_sample(
+    GstElement* snapsink,
+    gpointer user_data)
+{
+    GstSample* sample = NULL;
+
+    VideoPipeline* vp = static_cast<VideoPipeline*>(user_data);
 
-err:
-    if (buffer) {
-        gst_buffer_unmap(buffer, &map);
+    g_signal_emit_by_name(snapsink, "pull-sample", &sample);
+    if (!sample) {
+        return GST_FLOW_OK;
     }
-    if (sample) {
-        gst_sample_unref(sample);
+
+    std::shared_ptr<VideoFrame> full = VideoFrame::Wrap(sample);
+    if (full) {
+        vp->PairSnapshot(full);
     }
+
     return GST_FLOW_OK;
 }
 
+static GstCaps* make_caps(const VideoPipelineConfig& config, int width, int height, bool gbm)
+{
+    GstCaps* caps = gst_caps_new_simple("video/x-raw",
+        "format", G_TYPE_STRING, config.convertFormat.empty() ? "RGB" : config.convertFormat.c_str(),
+        "width", G_TYPE_INT, width,
+        "height", G_TYPE_INT, height, NULL);
+    if (gbm && 0 == config.converter.compare("qtivtransform")) {
+        gst_caps_set_features(caps, 0, gst_caps_features_new("memory:GBM", NULL));
+    }
+    return caps;
+}
+
 VideoPipeline::VideoPipeline(const VideoPipelineConfig& config)
 {
     this->config = config;
@@ -164,8 +163,10 @@ bool VideoPipeline::Create(void)
     GstCapsFeatures* feature;
     gchar* capstr;
 
-    if (!(pipeline = gst_pipeline_new("video-pipeline"))) {
-        LOG_ERROR("Failed to create pipeline named video-pipeline");
+    // Several cameras run in one process, name each pipeline after its camera.
+    std::string name = "video-pipeline-" + std::to_string(config.cameraID);
+    if (!(pipeline = gst_pipeline_new(name.c_str()))) {
+        LOG_ERROR("Failed to create pipeline named {}", name);
         goto exit;
     }
     gst_pipeline_set_auto_flush_bus(GST_PIPELINE(pipeline), true);
@@ -189,8 +190,8 @@ bool VideoPipeline::Create(void)
     }
     gst_bin_add_many(GST_BIN(pipeline), queue, NULL);
 
-    if (!(converter = gst_element_factory_make("qtivtransform", "videocvt"))) {
-        LOG_ERROR("Failed to create element qtivtransform named videocvt");
+    if (!(converter = gst_element_factory_make(config.converter.c_str(), "videocvt"))) {
+        LOG_ERROR("Failed to create element {} named videocvt", config.converter);
         goto exit;
     }
     gst_bin_add_many(GST_BIN(pipeline), converter, NULL);
@@ -199,11 +200,22 @@ bool VideoPipeline::Create(void)
         LOG_ERROR("Failed to create element capsfilter named convFilter");
         goto exit;
     }
-    caps = gst_caps_new_simple("video/x-raw",
-        "format", G_TYPE_STRING, "RGB",
-        "width", G_TYPE_INT, config.streamWidth,
-        "height", G_TYPE_INT, config.streamHeight, NULL);
-    gst_caps_set_features(caps, 0, gst_caps_features_new("memory:GBM", NULL));
+    if (IsLetterboxing()) {
+        // Scaled to fit the model input without borders: Detect() pads with the gray of
+        // yolov5 like any frame. The geometry is the one of the stream size frames, so
+        // boxes map back to snapshots.
+        letterbox = yolov5::CalcLetterbox(config.streamWidth, config.streamHeight,
+            config.modelWidth, config.modelHeight);
+        if (0 == config.convertFormat.compare("NV12") || 0 == config.convertFormat.compare("I420")) {
+            // Chroma is subsampled 2x2, the 1 pixel lost is within the box precision.
+            letterbox.scaledWidth &= ~1;
+            letterbox.scaledHeight &= ~1;
+        }
+        caps = make_caps(config, letterbox.scaledWidth, letterbox.scaledHeight, config.scaler.empty());
+        gst_caps_set_simple(caps, "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1, NULL);
+    } else {
+        caps = make_caps(config, config.streamWidth, config.streamHeight, true);
+    }
     capstr = gst_caps_to_string (caps);
     LOG_INFO("capfilter: {}", capstr);
     g_object_set(G_OBJECT(convFilter), "caps", caps, NULL);
@@ -221,8 +233,73 @@ bool VideoPipeline::Create(void)
     g_signal_connect(appsink, "new-sample", G_CALLBACK(cb_appsink_new_sample), static_cast<void*>(this));
     gst_bin_add_many(GST_BIN(pipeline), appsink, NULL);
 
-    if (!gst_element_link_many(queue, converter, convFilter, appsink, NULL)) {
-        LOG_ERROR("Failed to link uridecodebin->queue->qtivtransform->capfilter->appsink");
+    if (!IsLetterboxing()) {
+        if (!gst_element_link_many(queue, converter, convFilter, appsink, NULL)) {
+            LOG_ERROR("Failed to link uridecodebin->queue->qtivtransform->capfilter->appsink");
+            goto exit;
+        }
+        return true;
+    }
+
+    if (!(splitter = gst_element_factory_make("tee", "splitter"))) {
+        LOG_ERROR("Failed to create element tee named splitter");
+        goto exit;
+    }
+    if (!(inferQueue = gst_element_factory_make("queue", "inferQueue"))) {
+        LOG_ERROR("Failed to create element queue named inferQueue");
+        goto exit;
+    }
+    gst_bin_add_many(GST_BIN(pipeline), splitter, inferQueue, NULL);
+
+    if (!config.scaler.empty()) {
+        if (!(scaler = gst_element_factory_make(config.scaler.c_str(), "scaler"))) {
+            LOG_ERROR("Failed to create element {} named scaler", config.scaler);
+            goto exit;
+        }
+        gst_bin_add_many(GST_BIN(pipeline), scaler, NULL);
+    }
+
+    // Snapshot branch: dropped at the valve, before any conversion, unless enabled.
+    if (!(snapQueue = gst_element_factory_make("queue", "snapQueue"))) {
+        LOG_ERROR("Failed to create element queue named snapQueue");
+        goto exit;
+    }
+    g_object_set(G_OBJECT(snapQueue), "leaky", 2, "max-size-buffers", 1, NULL);
+    if (!(valve = gst_element_factory_make("valve", "valve"))) {
+        LOG_ERROR("Failed to create element valve named valve");
+        goto exit;
+    }
+    g_object_set(G_OBJECT(valve), "drop", !snapshots, NULL);
+    if (!(snapConverter = gst_element_factory_make(config.converter.c_str(), "snapcvt"))) {
+        LOG_ERROR("Failed to create element {} named snapcvt", config.converter);
+        goto exit;
+    }
+    if (!(snapFilter = gst_element_factory_make("capsfilter", "snapFilter"))) {
+        LOG_ERROR("Failed to create element capsfilter named snapFilter");
+        goto exit;
+    }
+    caps = make_caps(config, config.streamWidth, config.streamHeight, true);
+    g_object_set(G_OBJECT(snapFilter), "caps", caps, NULL);
+    gst_caps_unref(caps);
+    if (!(snapsink = gst_element_factory_make("appsink", "snapsink"))) {
+        LOG_ERROR("Failed to create element appsink named snapsink");
+        goto exit;
+    }
+    // No preroll: the valve may never let a buffer through.
+    g_object_set(snapsink, "emit-signals", true, "drop", TRUE, "max-buffers", 1,
+        "sync", config.isSync, "async", FALSE, NULL);
+    g_signal_connect(snapsink, "new-sample", G_CALLBACK(cb_snapsink_new_sample), static_cast<void*>(this));
+    gst_bin_add_many(GST_BIN(pipeline), snapQueue, valve, snapConverter, snapFilter, snapsink, NULL);
+
+    if (!gst_element_link_many(queue, splitter, inferQueue, converter, NULL) ||
+        (scaler && !gst_element_link_many(converter, scaler, convFilter, appsink, NULL)) ||
+        (!scaler && !gst_element_link_many(converter, convFilter, appsink, NULL))) {
+        LOG_ERROR("Failed to link queue->tee->queue->{}->{}->capfilter->appsink",
+            config.converter, config.scaler);
+        goto exit;
+    }
+    if (!gst_element_link_many(splitter, snapQueue, valve, snapConverter, snapFilter, snapsink, NULL)) {
+        LOG_ERROR("Failed to link tee->queue->valve->{}->capfilter->snapsink", config.converter);
         goto exit;
     }
 
@@ -319,7 +396,60 @@ void VideoPipeline::Destroy(void)
     }
 }
 
-void VideoPipeline::SetUserData(std::shared_ptr<SafetyQueue<cv::Mat>> user_data)
+void VideoPipeline::SetSnapshots(bool enable)
+{
+    snapshots = enable;
+    if (valve) {
+        g_object_set(G_OBJECT(valve), "drop", !enable, NULL);
+    }
+    if (!enable) {
+        std::lock_guard<std::mutex> locker(snapMutex);
+        awaiting.clear();
+        pendingSnapshot.reset();
+    }
+}
+
+void VideoPipeline::PairFrame(std::shared_ptr<VideoFrame> frame)
+{
+    if (!snapshots) return;
+
+    std::lock_guard<std::mutex> locker(snapMutex);
+    if (pendingSnapshot && pendingSnapshot->Pts() == frame->Pts()) {
+        frame->AttachSnapshot(std::move(pendingSnapshot));
+        pendingSnapshot.reset();
+        return;
+    }
+
+    // Twins come within a few frames, older ones lost theirs in a leaky queue.
+    awaiting.push_back(frame);
+    while (awaiting.size() > 8) awaiting.pop_front();
+}
+
+void VideoPipeline::PairSnapshot(std::shared_ptr<VideoFrame> full)
+{
+    std::lock_guard<std::mutex> locker(snapMutex);
+    while (!awaiting.empty()) {
+        std::shared_ptr<VideoFrame> frame = awaiting.front().lock();
+        if (frame && frame->Pts() == full->Pts()) {
+            frame->AttachSnapshot(std::move(full));
+            awaiting.pop_front();
+            return;
+        }
+        // Gone, or older than this snapshot: it will never get one.
+        if (!frame || frame->Pts() < full->Pts()) {
+            awaiting.pop_front();
+            continue;
+        }
+        break;
+    }
+
+    // Ahead of its letterboxed frame, only the latest one is kept.
+    pendingSnapshot = std::move(full);
+}
+
+void VideoPipeline::SetUserData(std::shared_ptr<RingQueue<VideoFrame>> user_data,
+    std::function<void()> notify)
 {
     productQueue = user_data;
+    onFrame = notify;
 }
\ No newline at end of file
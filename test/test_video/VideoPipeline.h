@@ -1,6 +1,6 @@
 /*
  * @Description: Decode stream pipeline.
- * @version: 2.2
+ * @version: 2.4
  * @Author: Ricardo Lu<shenglu1202@163.com>
  * @Date: 2022-10-11 10:46:12
  * @LastEditors: Ricardo Lu
@@ -10,16 +10,27 @@
 
 #include <iostream>
 #include <string>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <deque>
 
 #include <opencv2/opencv.hpp>
 #include <gst/gst.h>
 
-#include "SafeQueue.h"
+#include "RingQueue.h"
+#include "VideoFrame.h"
 
 /*
  * 
  * gst-launch-1.0 uridecodebin uri="" ! qtivtransform ! video/x-raw,format=RGB,width=1920,height=1080 ! appsink drop=true sync=false
- * 
+ *
+ * With modelWidth/modelHeight, inference frames are scaled to fit the model input in the
+ * pipeline (the gray padding is added by Detect()) and the full resolution branch only runs for snapshots:
+ * gst-launch-1.0 uridecodebin uri="" ! queue ! tee name=t \
+ *     t. ! queue ! videoconvert ! videoscale ! video/x-raw,format=RGB,width=640,height=360,pixel-aspect-ratio=1/1 ! appsink \
+ *     t. ! queue leaky=downstream max-size-buffers=1 ! valve drop=true ! videoconvert ! video/x-raw,format=RGB,width=1920,height=1080 ! appsink async=false
+ *
  */
 
 class VideoPipelineConfig {
@@ -31,6 +42,14 @@ public:
     int streamFramerateN;
     int streamFramerateD;
     std::string convertFormat;
+    // qtivtransform on the device, videoconvert for offline testing on a host
+    std::string converter = "qtivtransform";
+    // > 0: the appsink gets frames scaled to fit modelWidth x modelHeight keeping the aspect
+    // ratio, the stream size frames are only produced for snapshots, see VideoPipeline::SetSnapshots().
+    int modelWidth = 0;
+    int modelHeight = 0;
+    // Scales the inference frames, empty if the converter scales
+    std::string scaler = "videoscale";
     bool isDropBuffer;
     bool isSync;
 };
@@ -42,7 +61,19 @@ public:
     bool Create   (void);
     bool Start    (void);
     void Destroy  (void);
-    void SetUserData(std::shared_ptr<SafetyQueue<cv::Mat>> user_data);
+    void SetUserData(std::shared_ptr<RingQueue<VideoFrame>> user_data,
+        std::function<void()> notify = nullptr);
+    /**
+     * @brief: Attach the full resolution frame to each letterboxed one, off by default.
+     * Frames are always full resolution without modelWidth/modelHeight.
+     */
+    void SetSnapshots(bool enable);
+    bool IsLetterboxing() const {
+        return config.modelWidth > 0 && config.modelHeight > 0;
+    }
+    // Pair frames of the two branches by PTS
+    void PairFrame(std::shared_ptr<VideoFrame> frame);
+    void PairSnapshot(std::shared_ptr<VideoFrame> full);
 
     VideoPipelineConfig config;
     GstElement* pipeline;
@@ -54,6 +85,25 @@ public:
     GstElement* appsink;
     uint32_t    bus_watch_id;
 
+    // Letterbox mode only
+    GstElement* splitter = NULL;
+    GstElement* inferQueue = NULL;
+    GstElement* scaler = NULL;
+    GstElement* snapQueue = NULL;
+    GstElement* valve = NULL;
+    GstElement* snapConverter = NULL;
+    GstElement* snapFilter = NULL;
+    GstElement* snapsink = NULL;
+    yolov5::LetterboxInfo letterbox;
+    bool snapshots = false;
+    std::mutex snapMutex;
+    // Letterboxed frames still waiting for their full resolution one, oldest first
+    std::deque<std::weak_ptr<VideoFrame>> awaiting;
+    // Full resolution frame ahead of its letterboxed one
+    std::shared_ptr<VideoFrame> pendingSnapshot;
+
     bool dump;
-    std::shared_ptr<SafetyQueue<cv::Mat>> productQueue;
+    std::shared_ptr<RingQueue<VideoFrame>> productQueue;
+    // Called after a frame is queued
+    std::function<void()> onFrame;
 };
\ No newline at end of file
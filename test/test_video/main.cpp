@@ -1,6 +1,6 @@
 /*
  * @Description: Test program of yolov5s. 
- * @version: 2.2
+ * @version: 2.5
  * @Author: Ricardo Lu<shenglu1202@163.com>
  * @Date: 2022-05-18 16:51:10
  * @LastEditors: Ricardo Lu
@@ -49,19 +49,15 @@ int main(int argc, char* argv[])
     std::ifstream in(FLAGS_config_path, std::ios::binary);
     reader.parse(in, root);
 
-    VideoPipelineConfig m_vpConfig;
-    m_vpConfig.url = root["pipeline-config"]["camera-url"].asString();
-    m_vpConfig.cameraID = root["pipeline-config"]["camera-id"].asInt();
-    m_vpConfig.streamWidth = root["pipeline-config"]["stream-width"].asInt();
-    m_vpConfig.streamHeight = root["pipeline-config"]["stream-height"].asInt();
-    m_vpConfig.streamFramerateN = root["pipeline-config"]["fps-n"].asInt();
-    m_vpConfig.streamFramerateD = root["pipeline-config"]["fps-d"].asInt();
-    m_vpConfig.convertFormat = root["pipeline-config"]["output-format"].asString();
-    m_vpConfig.isDropBuffer = true;
-    m_vpConfig.isSync = false;
-    VideoPipeline* m_vp;
-    VideoAnalyzer* m_va;
-    std::shared_ptr<SafetyQueue<cv::Mat>> imageQueue = std::make_shared<SafetyQueue<cv::Mat>>();
+    // "pipeline-configs" lists the cameras, a single "pipeline-config" object is still accepted.
+    Json::Value pipelineConfigs = root["pipeline-configs"];
+    if (!pipelineConfigs.isArray()) {
+        pipelineConfigs = Json::Value(Json::arrayValue);
+        pipelineConfigs.append(root["pipeline-config"]);
+    }
+
+    std::vector<VideoPipeline*> m_vps;
+    VideoAnalyzer* m_va = NULL;
 
     gst_init(&argc, &argv);
 
@@ -70,31 +66,81 @@ int main(int argc, char* argv[])
         goto exit;
     }
 
-    m_vp = new VideoPipeline(m_vpConfig);
-
-    if (!m_vp->Create()) {
-        LOG_ERROR("Pipeline Create failed: lack of elements");
-        goto exit;
-    }
-    m_vp->SetUserData(imageQueue);
-    m_vp->Start();
-
     m_va = new VideoAnalyzer();
-    if (!m_va->Init(root["model-configs"], root["mqtt-config"])) {
+    if (!m_va->Init(root["model-configs"], root["mqtt-config"], root["scheduler-config"])) {
         LOG_ERROR("VideoAnalyzer Init failed!");
         goto exit;
     }
-    m_va->SetUserData(imageQueue);
+
+    for (Json::Value::ArrayIndex i = 0; i < pipelineConfigs.size(); i++) {
+        Json::Value& pc = pipelineConfigs[i];
+        VideoPipelineConfig m_vpConfig;
+        m_vpConfig.url = pc["camera-url"].asString();
+        m_vpConfig.cameraID = pc.isMember("camera-id") ? pc["camera-id"].asInt() : (int)i;
+        m_vpConfig.streamWidth = pc["stream-width"].asInt();
+        m_vpConfig.streamHeight = pc["stream-height"].asInt();
+        m_vpConfig.streamFramerateN = pc["fps-n"].asInt();
+        m_vpConfig.streamFramerateD = pc["fps-d"].asInt();
+        m_vpConfig.convertFormat = pc["output-format"].asString();
+        if (pc.isMember("converter")) m_vpConfig.converter = pc["converter"].asString();
+        // Letterbox to the model input in the pipeline, see VideoPipelineConfig.
+        m_vpConfig.modelWidth = pc["model-width"].asInt();
+        m_vpConfig.modelHeight = pc["model-height"].asInt();
+        if (pc.isMember("scaler")) m_vpConfig.scaler = pc["scaler"].asString();
+        m_vpConfig.isDropBuffer = true;
+        m_vpConfig.isSync = false;
+
+        // Queued frames hold decoder pool buffers, keep the queue short. The default
+        // drop-oldest policy never stalls the streaming thread on a slow model.
+        int queueSize = pc.isMember("queue-size") ? pc["queue-size"].asInt() : 4;
+        overflow_policy_t policy = OVERFLOW_DROP_OLDEST;
+        if (pc.isMember("overflow-policy") && !ParseOverflowPolicy(pc["overflow-policy"].asString(), policy)) {
+            LOG_WARN("Unknown overflow-policy \"{}\" of camera {}, use drop-oldest.",
+                pc["overflow-policy"].asString(), m_vpConfig.cameraID);
+        }
+        std::shared_ptr<RingQueue<VideoFrame>> imageQueue = std::make_shared<RingQueue<VideoFrame>>(queueSize, policy);
+
+        VideoPipeline* m_vp = new VideoPipeline(m_vpConfig);
+        m_vps.push_back(m_vp);
+        if (!m_vp->Create()) {
+            LOG_ERROR("Pipeline {} Create failed: lack of elements", m_vpConfig.cameraID);
+            goto exit;
+        }
+        m_vp->SetSnapshots(m_va->NeedsSnapshots());
+
+        // Infer on motion only, the static frames in between reuse the last results.
+        MotionGateConfig motion;
+        const Json::Value& gate = pc["motion-gate"];
+        if (gate.isObject()) {
+            motion.enable = true;
+            if (gate.isMember("scale")) motion.scale = gate["scale"].asInt();
+            if (gate.isMember("block")) motion.block = gate["block"].asInt();
+            if (gate.isMember("threshold")) motion.threshold = gate["threshold"].asFloat();
+            if (gate.isMember("min-blocks")) motion.minBlocks = gate["min-blocks"].asInt();
+            if (gate.isMember("min-fps")) motion.minFps = gate["min-fps"].asDouble();
+        }
+        m_va->AddStream(m_vpConfig.cameraID, imageQueue, pc["max-fps"].asDouble(), pc["detect-fps"].asDouble(), motion);
+        m_vp->SetUserData(imageQueue, [m_va]() { m_va->Notify(); });
+    }
+
     m_va->Start();
+    for (auto m_vp : m_vps) {
+        m_vp->Start();
+    }
 
     g_main_loop_run(g_main_loop);
 
 exit:
     if (g_main_loop) g_main_loop_unref(g_main_loop);
 
-    if (m_vp) {
+    for (auto m_vp : m_vps) {
         delete m_vp;
-        m_vp = NULL;
+    }
+    m_vps.clear();
+
+    if (m_va) {
+        delete m_va;
+        m_va = NULL;
     }
 
     google::ShutDownCommandLineFlags();
@@ -10,7 +10,13 @@
 
 #include <algorithm>
 #include <functional>
+#include <string>
+#include <vector>
 #include <math.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include <opencv2/opencv.hpp>
 
@@ -38,6 +44,103 @@ typedef enum runtime {
     AIP
 }runtime_t;
 
+// Element encoding of SNPE user buffers.
+typedef enum userbuffer_encoding {
+    USERBUFFER_FLOAT = 0,
+    USERBUFFER_TF8
+}userbuffer_encoding_t;
+
+// Pixel layout of a frame handed to the detector.
+typedef enum pixel_format {
+    PIXEL_FORMAT_RGB = 0,
+    // Y plane, then one interleaved UV plane at half resolution
+    PIXEL_FORMAT_NV12,
+    // Y plane, then U and V planes at half resolution
+    PIXEL_FORMAT_I420
+}pixel_format_t;
+
+// Power/performance mode of the accelerator, from the fastest to the most frugal.
+typedef enum performance_profile {
+    PROFILE_BURST = 0,
+    PROFILE_HIGH_PERFORMANCE,
+    PROFILE_SUSTAINED_HIGH_PERFORMANCE,
+    PROFILE_BALANCED,
+    PROFILE_LOW_BALANCED,
+    PROFILE_DEFAULT,
+    PROFILE_HIGH_POWER_SAVER,
+    PROFILE_POWER_SAVER,
+    PROFILE_LOW_POWER_SAVER,
+    PROFILE_EXTREME_POWER_SAVER
+}performance_profile_t;
+
+// Execution priority of a network against the others sharing the accelerator.
+typedef enum execution_priority {
+    PRIORITY_NORMAL = 0,
+    PRIORITY_HIGH,
+    PRIORITY_LOW
+}execution_priority_t;
+
+// SNPE profiling of the built network, the events go to its diagnostic log.
+typedef enum profiling_level {
+    PROFILING_OFF = 0,
+    PROFILING_BASIC,
+    PROFILING_MODERATE,
+    PROFILING_DETAILED
+}profiling_level_t;
+
+// "burst", "sustained_high_performance", "power_saver"..., case insensitive, '-' or '_'.
+static bool ParsePerformanceProfile(std::string name, performance_profile_t& profile)
+{
+    static const char* names[] = {
+        "burst", "high_performance", "sustained_high_performance", "balanced", "low_balanced",
+        "default", "high_power_saver", "power_saver", "low_power_saver", "extreme_power_saver"
+    };
+    std::transform(name.begin(), name.end(), name.begin(),
+        [](unsigned char ch){ return '-' == ch ? '_' : tolower(ch); });
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (0 == name.compare(names[i])) {
+            profile = static_cast<performance_profile_t>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static execution_priority_t ParseExecutionPriority(std::string name)
+{
+    std::transform(name.begin(), name.end(), name.begin(),
+        [](unsigned char ch){ return tolower(ch); });
+    if (0 == name.compare("high")) return PRIORITY_HIGH;
+    if (0 == name.compare("low")) return PRIORITY_LOW;
+    return PRIORITY_NORMAL;
+}
+
+static profiling_level_t ParseProfilingLevel(std::string name)
+{
+    std::transform(name.begin(), name.end(), name.begin(),
+        [](unsigned char ch){ return tolower(ch); });
+    if (0 == name.compare("basic")) return PROFILING_BASIC;
+    if (0 == name.compare("moderate")) return PROFILING_MODERATE;
+    if (0 == name.compare("detailed")) return PROFILING_DETAILED;
+    return PROFILING_OFF;
+}
+
+// Pin the calling thread to cpus, nothing to do for an empty list.
+static bool SetThreadAffinity(const std::vector<int>& cpus)
+{
+    if (cpus.empty()) return true;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    return false;
+#endif
+}
+
 static float calcIoU(const cv::Rect& a, const cv::Rect& b) {
     float xOverlap = std::max(
         0.,
@@ -59,3 +162,10 @@ static int64_t GetTimeStamp_ms()
     std::time_t timestamp =  tp.time_since_epoch().count();
     return timestamp;
 }
+
+// Monotonic, for durations only.
+static int64_t GetTimeStamp_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
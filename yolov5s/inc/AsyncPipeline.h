@@ -0,0 +1,159 @@
+/*
+ * @Description: Three stage pipeline running jobs over a fixed number of slots.
+ * @version: 2.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 16:10:44
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 16:10:44
+ */
+
+#ifndef __ASYNC_PIPELINE_H__
+#define __ASYNC_PIPELINE_H__
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <utility>
+
+namespace yolov5 {
+
+/**
+ * @brief: Job queue between two stages, Pop() returns false once closed and drained.
+ * Push() blocks while capacity items are queued, 0 for unbounded.
+ */
+template<typename T>
+class StageQueue {
+public:
+    explicit StageQueue(size_t capacity = 0) : m_capacity(capacity) {}
+
+    void Push(T&& item) {
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            m_notFull.wait(locker, [this]() { return !m_capacity || m_items.size() < m_capacity; });
+            m_items.push_back(std::move(item));
+        }
+        m_notEmpty.notify_one();
+    }
+
+    bool Pop(T& item) {
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            m_notEmpty.wait(locker, [this]() { return m_closed || !m_items.empty(); });
+            if (m_items.empty()) return false;
+            item = std::move(m_items.front());
+            m_items.pop_front();
+        }
+        m_notFull.notify_one();
+        return true;
+    }
+
+    void Close() {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            m_closed = true;
+        }
+        m_notEmpty.notify_all();
+    }
+
+private:
+    const size_t m_capacity;
+    std::deque<T> m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    bool m_closed = false;
+};
+
+/**
+ * @brief: Pre -> Exec -> Post, each stage on its own thread. A job owns one of
+ * the slots (e.g. a SNPE buffer set) from Pre until Post is done, so with 3 slots
+ * frame N+1 is prepared while N executes and N-1 is post processed, and throughput
+ * tends to the slowest stage instead of the sum of them.
+ * A stage returning false skips the next stages, Post is always called so it can
+ * complete the job either way.
+ */
+template<typename Job>
+class AsyncPipeline {
+public:
+    typedef std::function<bool(Job& job, size_t slot)> stage_t;
+    typedef std::function<void(Job& job, size_t slot, bool ok)> finish_t;
+
+    // threadInit runs first on each stage thread, e.g. to pin it.
+    AsyncPipeline(size_t slots, stage_t pre, stage_t exec, finish_t post,
+                  std::function<void()> threadInit = nullptr) :
+        m_pre(pre), m_exec(exec), m_post(post), m_threadInit(threadInit), m_submitted(slots ? slots : 1) {
+        for (size_t i = 0; i < (slots ? slots : 1); i++) m_freeSlots.Push(std::move(i));
+        m_threads[0] = std::thread(&AsyncPipeline::PreLoop, this);
+        m_threads[1] = std::thread(&AsyncPipeline::ExecLoop, this);
+        m_threads[2] = std::thread(&AsyncPipeline::PostLoop, this);
+    }
+
+    // Jobs already submitted are completed before the threads exit.
+    ~AsyncPipeline() {
+        m_submitted.Close();
+        for (auto& t : m_threads) t.join();
+    }
+
+    AsyncPipeline(const AsyncPipeline&) = delete;
+    AsyncPipeline& operator=(const AsyncPipeline&) = delete;
+
+    // Blocks while as many jobs as slots are already waiting for Pre.
+    void Submit(Job job) {
+        m_submitted.Push(std::move(job));
+    }
+
+private:
+    struct Entry {
+        Job job;
+        size_t slot;
+        bool ok;
+    };
+
+    void PreLoop() {
+        if (m_threadInit) m_threadInit();
+        Job job;
+        while (m_submitted.Pop(job)) {
+            size_t slot = 0;
+            m_freeSlots.Pop(slot);
+            bool ok = m_pre(job, slot);
+            m_prepared.Push(Entry{std::move(job), slot, ok});
+        }
+        m_prepared.Close();
+    }
+
+    void ExecLoop() {
+        if (m_threadInit) m_threadInit();
+        Entry entry;
+        while (m_prepared.Pop(entry)) {
+            if (entry.ok) entry.ok = m_exec(entry.job, entry.slot);
+            m_executed.Push(std::move(entry));
+        }
+        m_executed.Close();
+    }
+
+    void PostLoop() {
+        if (m_threadInit) m_threadInit();
+        Entry entry;
+        while (m_executed.Pop(entry)) {
+            m_post(entry.job, entry.slot, entry.ok);
+            m_freeSlots.Push(std::move(entry.slot));
+        }
+    }
+
+    stage_t m_pre;
+    stage_t m_exec;
+    finish_t m_post;
+    std::function<void()> m_threadInit;
+
+    StageQueue<Job> m_submitted;
+    StageQueue<size_t> m_freeSlots;
+    StageQueue<Entry> m_prepared;
+    StageQueue<Entry> m_executed;
+    std::thread m_threads[3];
+};
+
+} // namespace yolov5
+
+#endif // __ASYNC_PIPELINE_H__
@@ -0,0 +1,214 @@
+/*
+ * @Description: Image pre-process kernels writing straight into model input tensors.
+ * @version: 2.5
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 09:12:40
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 09:12:40
+ */
+
+#ifndef __IMAGE_PROCESS_H__
+#define __IMAGE_PROCESS_H__
+
+#include <vector>
+#include <cstdint>
+
+#include <opencv2/opencv.hpp>
+
+#include "utils.h"
+
+namespace yolov5 {
+
+/**
+ * @brief: Geometry of a frame letterboxed into the model input.
+ */
+struct LetterboxInfo {
+    float scale = 1.0f;
+    int xOffset = 0;
+    int yOffset = 0;
+    int scaledWidth = 0;
+    int scaledHeight = 0;
+
+    bool operator==(const LetterboxInfo& other) const {
+        return xOffset == other.xOffset && yOffset == other.yOffset &&
+               scaledWidth == other.scaledWidth && scaledHeight == other.scaledHeight;
+    }
+
+    bool operator!=(const LetterboxInfo& other) const {
+        return !(*this == other);
+    }
+};
+
+/**
+ * @brief: Planar YUV 4:2:0 frame, the planes stay owned by the caller.
+ */
+struct YUVImage {
+    // PIXEL_FORMAT_NV12 or PIXEL_FORMAT_I420
+    pixel_format_t format = PIXEL_FORMAT_NV12;
+    int width = 0;
+    int height = 0;
+    // NV12: Y, UV. I420: Y, U, V.
+    const uint8_t* planes[3] = {nullptr, nullptr, nullptr};
+    // Bytes per row of each plane
+    int strides[3] = {0, 0, 0};
+
+    bool empty() const {
+        return width <= 0 || height <= 0 || nullptr == planes[0] || nullptr == planes[1] ||
+               (PIXEL_FORMAT_I420 == format && nullptr == planes[2]);
+    }
+};
+
+/**
+ * @brief: Region of a YUV frame without copy, its corners are rounded down to even
+ * pixels to stay on the chroma grid.
+ */
+YUVImage CropYUV(const YUVImage& image, const cv::Rect& roi);
+
+/**
+ * @brief: Downscale the planes of image to width x height, then convert to RGB there.
+ * Only the model resolution is ever converted, the full frame is read once.
+ * @param {cv::Mat&} yuv: Reused working buffer.
+ * @param {cv::Mat&} rgb: CV_8UC3 width x height result, width and height are rounded up to even.
+ */
+bool ResizeYUVToRGB(const YUVImage& image, int width, int height, cv::Mat& yuv, cv::Mat& rgb);
+
+/**
+ * @brief: Calculate the letterbox geometry of an imgWidth x imgHeight frame.
+ */
+LetterboxInfo CalcLetterbox(int imgWidth, int imgHeight, int inputWidth, int inputHeight);
+
+/**
+ * @brief: Convert a row of uint8 values to float and multiply them by scale.
+ */
+void NormalizeRow(const uint8_t* src, float* dst, int n, float scale);
+
+/**
+ * @brief: Build the table mapping a uint8 pixel to the TF8 quantized value of pixel / 255.
+ */
+void BuildQuantizeTable(uint64_t stepExactly0, float stepSize, uint8_t table[256]);
+
+/**
+ * @brief: Map a row of uint8 pixels through a quantize table.
+ */
+void QuantizeRow(const uint8_t* src, uint8_t* dst, int n, const uint8_t table[256]);
+
+/**
+ * @brief: Convert a row of planar/semi-planar BT.601 YUV to RGB, same coefficients
+ * as cv::COLOR_YUV2RGB_NV12. uvStep: 2 for interleaved UV, 1 for separate U and V.
+ */
+void YUVToRGBRow(const uint8_t* y, const uint8_t* u, const uint8_t* v, int uvStep, uint8_t* rgb, int n);
+
+/**
+ * @brief: Row by row bilinear resize of uint8 images, the sampling and 11 bits weights
+ * of cv::resize(INTER_LINEAR), both passes vectorized. Its tables and row buffer are
+ * reused, so frames of an unchanged size don't allocate.
+ */
+class BilinearResizer {
+public:
+    /**
+     * @brief: Set up srcWidth x srcHeight -> dstWidth x dstHeight, cheap if unchanged.
+     */
+    void Prepare(int srcWidth, int srcHeight, int channels, int dstWidth, int dstHeight);
+
+    /**
+     * @brief: Output row y, dstWidth * channels values.
+     * @param {uint8_t*} src: Source image, stride bytes per row.
+     */
+    void Row(const uint8_t* src, size_t stride, int y, uint8_t* dst);
+
+private:
+    struct Axis {
+        // Source index of the two taps, and their weights summing to 2048
+        std::vector<int> index0;
+        std::vector<int> index1;
+        std::vector<int16_t> weight0;
+        std::vector<int16_t> weight1;
+    };
+
+    static void BuildAxis(int srcSize, int dstSize, Axis& axis);
+    template<int CN>
+    void RowCN(const uint8_t* src, size_t stride, int y, uint8_t* dst);
+
+    int m_srcWidth = 0;
+    int m_srcHeight = 0;
+    int m_channels = 0;
+    int m_dstWidth = 0;
+    int m_dstHeight = 0;
+    Axis m_y;
+    // Left source pixel of every output pixel, and the weights of it and its right neighbour
+    std::vector<int> m_tap;
+    std::vector<int16_t> m_tapWeights;
+    // Vertically blended source row, one plane per channel, 7 fraction bits
+    std::vector<int16_t> m_column;
+    int m_planeStride = 0;
+};
+
+/**
+ * @brief: Letterbox + normalize a RGB frame into a HxWx3 float tensor.
+ * The padding border is only rewritten when the letterbox geometry changes,
+ * so every instance must be bound to one tensor(or one batch slot of it).
+ */
+class LetterboxNormalizer {
+public:
+    /**
+     * @brief: Write image into tensor, resized with the aspect ratio kept and normalized to [0, 1].
+     * @param {cv::Mat&} image: CV_8UC3 frame.
+     * @param {float*} tensor: inputHeight x inputWidth x 3 float tensor.
+     * @param {LetterboxInfo&} info: Geometry used for this frame, needed to map boxes back.
+     * @return {bool} true if successfully, false if failed.
+     */
+    bool Run(const cv::Mat& image, float* tensor, int inputWidth, int inputHeight, LetterboxInfo& info);
+
+    /**
+     * @brief: TF8 variant of Run(), pixels are written as quantized by table(see BuildQuantizeTable).
+     */
+    bool Run(const cv::Mat& image, uint8_t* tensor, int inputWidth, int inputHeight,
+             const uint8_t table[256], LetterboxInfo& info);
+
+    /**
+     * @brief: NV12/I420 variants, the planes are resized and converted row by row at
+     * the letterbox size instead of a full resolution RGB copy.
+     */
+    bool Run(const YUVImage& image, float* tensor, int inputWidth, int inputHeight, LetterboxInfo& info);
+    bool Run(const YUVImage& image, uint8_t* tensor, int inputWidth, int inputHeight,
+             const uint8_t table[256], LetterboxInfo& info);
+
+    /**
+     * @brief: Force the padding border to be rewritten on the next Run().
+     */
+    void Reset() {
+        m_borderValid = false;
+    }
+
+private:
+    // Geometry of a imgWidth x imgHeight frame and the padding border, false if it doesn't fit.
+    template<typename T>
+    bool Prepare(int imgWidth, int imgHeight, T* tensor, int inputWidth, int inputHeight,
+                 T padValue, LetterboxInfo& info);
+
+    template<typename T, typename RowFunc>
+    bool Letterbox(const cv::Mat& image, T* tensor, int inputWidth, int inputHeight,
+                   T padValue, LetterboxInfo& info, RowFunc rowFunc);
+
+    template<typename T, typename RowFunc>
+    bool Letterbox(const YUVImage& image, T* tensor, int inputWidth, int inputHeight,
+                   T padValue, LetterboxInfo& info, RowFunc rowFunc);
+
+    template<typename T>
+    void FillBorder(T* tensor, int inputWidth, int inputHeight, T padValue, const LetterboxInfo& info);
+
+    // Scratch kept across frames: a steady stream of frames doesn't allocate.
+    BilinearResizer m_resizer;
+    BilinearResizer m_chromaResizer;
+    BilinearResizer m_chromaResizer2;
+    std::vector<uint8_t> m_row;
+    std::vector<uint8_t> m_rowY;
+    std::vector<uint8_t> m_rowU;
+    std::vector<uint8_t> m_rowV;
+    LetterboxInfo m_last;
+    bool m_borderValid = false;
+};
+
+} // namespace yolov5
+
+#endif // __IMAGE_PROCESS_H__
@@ -0,0 +1,121 @@
+/*
+ * @Description: Non-maximum suppression engine on SoA boxes.
+ * @version: 2.3
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 13:20:05
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 13:20:05
+ */
+
+#ifndef __NMS_H__
+#define __NMS_H__
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace yolov5 {
+
+// Suppression algorithm.
+typedef enum nms_method {
+    NMS_HARD = 0,       // greedy, the classic one
+    NMS_FAST,           // suppressed by any higher score box, no sequential dependency
+    NMS_SOFT_LINEAR,    // scores decayed by (1 - IoU)
+    NMS_SOFT_GAUSSIAN   // scores decayed by exp(-IoU^2 / sigma)
+}nms_method_t;
+
+/**
+ * @brief: Parse "hard", "fast", "soft-linear" or "soft-gaussian", NMS_HARD if unknown.
+ */
+nms_method_t ParseNMSMethod(const std::string& name);
+
+/**
+ * @brief: NMS config info.
+ */
+struct NMSConfig {
+    nms_method_t method = NMS_HARD;
+    // Only suppress boxes sharing the same label.
+    bool classAware = false;
+    // Keep the top maxCandidates boxes by score before suppression, 0 to disable.
+    int maxCandidates = 0;
+    float iouThresh = 0.5f;
+    // Gaussian Soft-NMS sigma.
+    float sigma = 0.5f;
+    // Soft-NMS drops boxes whose decayed score falls below it.
+    float scoreThresh = 0.001f;
+};
+
+/**
+ * @brief: Boxes in SoA layout, (x1, y1) top-left and (x2, y2) bottom-right corner.
+ */
+struct BoxSet {
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<float> x2;
+    std::vector<float> y2;
+    std::vector<float> scores;
+    std::vector<int> labels;
+
+    size_t size() const {
+        return scores.size();
+    }
+
+    void clear() {
+        x1.clear(); y1.clear(); x2.clear(); y2.clear();
+        scores.clear(); labels.clear();
+    }
+
+    void reserve(size_t n) {
+        x1.reserve(n); y1.reserve(n); x2.reserve(n); y2.reserve(n);
+        scores.reserve(n); labels.reserve(n);
+    }
+
+    void push_back(float left, float top, float right, float bottom, float score, int label) {
+        x1.push_back(left); y1.push_back(top); x2.push_back(right); y2.push_back(bottom);
+        scores.push_back(score); labels.push_back(label);
+    }
+};
+
+/**
+ * @brief: NMS engine, owns its scratch buffers so steady state runs don't allocate.
+ * IoU follows calcIoU() in utils.h: pixel inclusive, (w + 1) * (h + 1) areas.
+ */
+class NMS {
+public:
+    /**
+     * @brief: Run suppression on boxes.
+     * @param {BoxSet&} boxes: Input boxes in any order.
+     * @param {std::vector<int>&} keep: Indexes of the kept boxes, by descending score.
+     * @param {std::vector<float>&} scores: Final score of each kept box, decayed by Soft-NMS.
+     */
+    void Run(const BoxSet& boxes, const NMSConfig& config, std::vector<int>& keep, std::vector<float>& scores);
+
+    /**
+     * @brief: Size the scratch buffers for n boxes of up to labels labels ahead of the
+     * first Run(). Only the grid cells still grow, up to their high-water mark.
+     */
+    void Reserve(size_t n, int labels);
+
+private:
+    // Boxes of one group gathered in score order, so every pass reads them contiguously.
+    void Gather(const BoxSet& boxes, const int* order, size_t n);
+    void Hard(const NMSConfig& config, std::vector<int>& keep, std::vector<float>& scores);
+    void Fast(const NMSConfig& config, std::vector<int>& keep, std::vector<float>& scores);
+    void Soft(const NMSConfig& config, std::vector<int>& keep, std::vector<float>& scores);
+
+    std::vector<int> m_order;
+    std::vector<int> m_groupStart;
+
+    // Gathered group
+    std::vector<int> m_index;
+    std::vector<float> m_x1, m_y1, m_x2, m_y2, m_area, m_score;
+
+    // Kept boxes of the hard NMS, and the grid binning them
+    std::vector<float> m_kx1, m_ky1, m_kx2, m_ky2, m_karea;
+    std::vector<std::vector<int>> m_cells;
+    std::vector<int> m_visited;
+};
+
+} // namespace yolov5
+
+#endif // __NMS_H__
@@ -0,0 +1,105 @@
+/*
+ * @Description: SORT style multi-object tracker on the results of ObjectDetection.
+ * @version: 1.0
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-18 00:58:13
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 00:58:13
+ */
+
+#ifndef __TRACKER_H__
+#define __TRACKER_H__
+
+#include <vector>
+#include <cstdint>
+
+#include "YOLOv5s.h"
+
+namespace yolov5 {
+
+/**
+ * @brief: Tracker config info.
+ */
+struct TrackerConfig {
+    // Minimum IoU between a predicted track and a detection of the same label.
+    float matchIoU = 0.3f;
+    // Consecutive matched frames before a track gets its id, filters one frame false positives.
+    int minHits = 3;
+    // A track without detection is kept, and predicted, that long.
+    int64_t maxAge_ms = 1000;
+    // Std of the box acceleration, in box heights per s^2.
+    float processNoise = 1.0f;
+    // Std of the detected box coordinates, in box heights.
+    float measurementNoise = 0.05f;
+};
+
+/**
+ * @brief: Tracks the objects of one stream: a constant velocity Kalman filter per
+ * track on box center and size, matched to the detections greedily by descending IoU.
+ * Timestamps drive the filter, so frames may come at any rate and skipped frames can
+ * be filled by Predict(). Not thread safe, one tracker per stream and model.
+ * Steady state calls don't allocate.
+ */
+class ObjectTracker {
+public:
+    explicit ObjectTracker(const TrackerConfig& config) : m_config(config) {}
+
+    /**
+     * @brief: Match the detections of a frame to the tracks, then set their trackId:
+     * the id of a confirmed track, -1 for objects still tentative. Boxes stay the
+     * detected ones.
+     * @param {int64_t} timestamp_ms: Capture time of the frame, not decreasing.
+     */
+    void Update(std::vector<ObjectData>& objects, int64_t timestamp_ms);
+
+    /**
+     * @brief: Append the predicted box of every confirmed track at timestamp_ms, for
+     * frames not sent to the detector. confidence is the last detected one.
+     */
+    void Predict(int64_t timestamp_ms, std::vector<ObjectData>& objects);
+
+    size_t Tracks() const {
+        return m_tracks.size();
+    }
+
+private:
+    // Position and velocity of one box coordinate, P its covariance.
+    struct Axis {
+        float x, v;
+        float p00, p01, p11;
+    };
+
+    struct Track {
+        // Center x, center y, width, height
+        Axis axes[4];
+        int64_t timestamp_ms;
+        int64_t updated_ms;
+        int label;
+        float confidence;
+        int hits;
+        int id;
+    };
+
+    void Advance(Track& track, int64_t timestamp_ms) const;
+    void Correct(Track& track, const cv::Rect& bbox) const;
+    static cv::Rect ToRect(const Track& track);
+
+    struct Candidate {
+        float iou;
+        int track;
+        int object;
+    };
+
+    TrackerConfig m_config;
+    std::vector<Track> m_tracks;
+    int m_nextId = 0;
+
+    // Scratch of Update()
+    std::vector<Candidate> m_candidates;
+    std::vector<int> m_trackMatch;
+    std::vector<int> m_objectMatch;
+};
+
+} // namespace yolov5
+
+#endif // __TRACKER_H__
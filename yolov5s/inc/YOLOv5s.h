@@ -1,6 +1,6 @@
 /*
  * @Description: Abstraction of yolov5s object detection algorithm inference APIs.
- * @version: 2.1
+ * @version: 2.6
  * @Author: Ricardo Lu<shenglu1202@163.com>
  * @Date: 2022-05-17 20:26:39
  * @LastEditors: Ricardo Lu
@@ -14,10 +14,13 @@
 #include <string>
 #include <functional>
 #include <memory>
+#include <future>
 
 #include <opencv2/opencv.hpp>
 
 #include "utils.h"
+#include "NMS.h"
+#include "ImageProcess.h"
 
 namespace yolov5
 {
@@ -34,6 +37,8 @@ struct ObjectData {
     int label = -1;
     // Time cost of detecting this frame
     int64_t time_cost = 0;
+    // Set by ObjectTracker, -1 for untracked objects
+    int trackId = -1;
 };
 
 /**
@@ -42,11 +47,80 @@ struct ObjectData {
 struct ObjectDetectionConfig {
     std::string model_path;
     runtime_t runtime;
+    // One SNPE replica per entry built from the same model, e.g. {DSP, GPU} lets
+    // Detect() calls from several threads run on both. Empty for one replica on runtime.
+    std::vector<runtime_t> runtimes;
+    // Send each Detect() to the replica expected to finish it first (frames queued x
+    // moving average latency) instead of the first free one, see snpetask::RuntimeBalancer.
+    bool balanceRuntimes = false;
+    // When balanced, an idle replica unpicked for 1 / balanceFloorShare frames gets one,
+    // which keeps the latency of a slow runtime measured. 0 to disable.
+    float balanceFloorShare = 0.0f;
     int labels = 85;
     int grids = 25200;
+    // Accelerator profile at start, SetPerformanceProfile() switches it later. Constant
+    // BURST throttles fanless boxes, SUSTAINED_HIGH_PERFORMANCE holds its clocks.
+    performance_profile_t performanceProfile = PROFILE_BURST;
+    execution_priority_t executionPriority = PRIORITY_NORMAL;
+    // Run the CPU runtime and CPU fallback layers in 8 bit fixed point.
+    bool cpuFixedPoint = false;
+    // CPUs of the DetectAsync() stage threads, empty for no pinning.
+    std::vector<int> cpuAffinity;
+    // Prepared networks are saved here and reused by the next start, empty to disable.
+    std::string initCacheDir;
+    // Frames inferred by one execute(), see ObjectDetection::DetectBatch().
+    int batchSize = 1;
+    // Frames in flight of ObjectDetection::DetectAsync(), each one owns a SNPE
+    // buffer set of every replica. 0 disables the async pipeline, 3 overlaps all the stages.
+    int asyncDepth = 0;
     std::vector<std::string> inputLayers;
     std::vector<std::string> outputLayers;
     std::vector<std::string> outputTensors;
+    // USERBUFFER_TF8 feeds/reads uint8 quantized tensors, fastest on DSP/AIP runtimes.
+    userbuffer_encoding_t bufferEncoding = USERBUFFER_FLOAT;
+    // Suppression method, nms.iouThresh is overridden by SetScoreThreshold().
+    NMSConfig nms;
+    // In process latency histograms of every stage (lease wait, pre-process, execute per
+    // replica, post-process, NMS), see ObjectDetection::GetStageProfile(). Two clock reads per stage.
+    bool stageProfiling = false;
+    // Log the histograms of the last interval and append them to profileCsv, 0 to disable.
+    int profileDumpInterval_ms = 0;
+    std::string profileCsv;
+    // Tag of the dumped rows, the model file name if empty.
+    std::string profileTag;
+    // SNPE profiling: its per layer and per transfer events only go to the diagnostic
+    // log in diagLogDir (one sub directory per replica), read it with snpe-diagview.
+    profiling_level_t profilingLevel = PROFILING_OFF;
+    std::string diagLogDir;
+};
+
+/**
+ * @brief: Usage of one SNPE replica, see ObjectDetection::GetReplicaUsage().
+ */
+struct ReplicaUsage {
+    // Runtime and index in ObjectDetectionConfig::runtimes, e.g. "DSP#0"
+    std::string name;
+    uint64_t frames = 0;
+    double busy_ms = 0.0;
+    // Busy time over wall time since Init(), [0.0f, 1.0f]
+    double utilization = 0.0;
+    // Time a frame holds the replica, moving average if balanced
+    double latency_ms = 0.0;
+};
+
+/**
+ * @brief: Timings of one stage, see ObjectDetection::GetStageProfile().
+ */
+struct StageProfile {
+    // e.g. "preprocess", "DSP#0.execute", "postprocess.nms"
+    std::string stage;
+    uint64_t count = 0;
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p90_ms = 0.0;
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
 };
 
 /**
@@ -130,7 +204,10 @@ public:
     bool RegisterPreProcess(post_process_t func);
 
     /**
-     * @brief: Core method of object detection.
+     * @brief: Core method of object detection. Thread safe: concurrent calls run on the
+     * free SNPE replicas (see ObjectDetectionConfig::runtimes) and wait when all are busy.
+     * Results are appended: reuse one cleared vector per caller and, past the first
+     * frames, a call doesn't allocate (see benchmark/perf BM_Detect allocs_per_frame).
      * @Author: Ricardo Lu
      * @param {cv::Mat&} image: A RGB format image needs to be detected.
      * @param {std::vector<std::vector<ts::ObjectData> >&} results: Detection results vector for each image.
@@ -138,6 +215,80 @@ public:
      */
     bool Detect(const cv::Mat& image, std::vector<ObjectData>& results);
 
+    /**
+     * @brief: Detect on a NV12/I420 frame, e.g. the decoder output, without a full resolution
+     * RGB copy: the planes are downscaled first and converted at the model size only.
+     * A custom pre-process (see RegisterPreProcess()) takes cv::Mat only and fails here.
+     * @Author: Ricardo Lu
+     * @param {YUVImage&} image: Planes of the frame, valid until Detect() returns.
+     * @param {std::vector<ObjectData>&} results: Detection results in frame coordinates.
+     * @return {bool} true if detect successfullly, false if failed.
+     */
+    bool Detect(const YUVImage& image, std::vector<ObjectData>& results);
+
+    /**
+     * @brief: Detect on a frame scaled upstream to fit the model input (e.g. by the decoder
+     * pipeline), so no resize happens here. It is padded here with the same gray as Detect().
+     * Needs no ROI (see SetROI()), the frame coordinates are gone.
+     * @Author: Ricardo Lu
+     * @param {cv::Mat&} image: RGB frame of letterbox.scaledWidth x letterbox.scaledHeight, not padded.
+     * @param {LetterboxInfo&} letterbox: CalcLetterbox() of the original frame to the model input,
+     * its scale maps the boxes back.
+     * @param {std::vector<ObjectData>&} results: Detection results in original frame coordinates.
+     * @return {bool} true if detect successfullly, false if failed.
+     */
+    bool Detect(const cv::Mat& image, const LetterboxInfo& letterbox, std::vector<ObjectData>& results);
+    bool Detect(const YUVImage& image, const LetterboxInfo& letterbox, std::vector<ObjectData>& results);
+
+    /**
+     * @brief: Detect a group of frames, batchSize of them(see ObjectDetectionConfig) per inference.
+     * @Author: Ricardo Lu
+     * @param {std::vector<cv::Mat>&} images: RGB format images need to be detected.
+     * @param {std::vector<std::vector<ObjectData> >&} results: Detection results vector for each image.
+     * @return {bool} true if every image was detected, false if any failed(its results stay empty).
+     */
+    bool DetectBatch(const std::vector<cv::Mat>& images, std::vector<std::vector<ObjectData>>& results);
+
+    /**
+     * @brief: Queue a frame into the pre-process -> execute -> post-process pipeline,
+     * so the CPU prepares the next frames while the accelerator runs. Needs asyncDepth > 0
+     * (see ObjectDetectionConfig), it runs Detect() in place otherwise. Frames execute
+     * on the first replica.
+     * @Author: Ricardo Lu
+     * @param {cv::Mat&} image: RGB format image, its pixels must stay valid until the future is ready.
+     * @return {std::future<std::vector<ObjectData>>} Results in submission order,
+     * holds a std::runtime_error if the frame failed.
+     */
+    std::future<std::vector<ObjectData>> DetectAsync(const cv::Mat& image);
+
+    /**
+     * @brief: Switch the accelerator profile of every replica without rebuilding them,
+     * e.g. BURST while frames queue up and POWER_SAVER when idle. Each replica switches
+     * between two frames.
+     * @Author: Ricardo Lu
+     * @param {performance_profile_t} profile: New profile.
+     * @return {bool} true if all the replicas switched, false if any failed.
+     */
+    bool SetPerformanceProfile(performance_profile_t profile);
+
+    /**
+     * @brief: Per replica usage, to check whether every runtime is kept busy.
+     * @Author: Ricardo Lu
+     * @param {std::vector<ReplicaUsage>&} usage: One entry per built replica.
+     * @return {bool} true if initialized, false if not.
+     */
+    bool GetReplicaUsage(std::vector<ReplicaUsage>& usage);
+
+    /**
+     * @brief: Latency histograms of the stages since Init() or the last reset, needs
+     * stageProfiling (see ObjectDetectionConfig).
+     * @Author: Ricardo Lu
+     * @param {std::vector<StageProfile>&} profile: One entry per stage, sorted by name.
+     * @param {bool} reset: Start new histograms after reading them.
+     * @return {bool} true if profiling is enabled, false if not.
+     */
+    bool GetStageProfile(std::vector<StageProfile>& profile, bool reset = false);
+
     /**
      * @brief: Check object detection instance initialization state.
      * @Author: Ricardo Lu
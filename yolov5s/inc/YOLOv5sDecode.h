@@ -0,0 +1,54 @@
+/*
+ * @Description: Decoder of yolov5s output layers.
+ * @version: 2.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 11:03:27
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 11:03:27
+ */
+
+#ifndef __YOLOV5S_DECODE_H__
+#define __YOLOV5S_DECODE_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace yolov5 {
+
+/**
+ * @brief: Anchor which passed the objectness threshold, in model input coordinates.
+ */
+struct Candidate {
+    // Center, width and height of the bounding box
+    float cx;
+    float cy;
+    float width;
+    float height;
+    // objectness * class probability
+    float score;
+    // Index of the most probable class
+    int label;
+};
+
+/**
+ * @brief: Decode one output layer [height, width, 3 * (5 + classes)] of yolov5s.
+ * Objectness is checked first and anchors not above objThresh are skipped
+ * without decoding box or classes, survivors whose score is above confThresh
+ * are appended to candidates.
+ * @param {int} layer: 0/1/2 for the stride 8/16/32 layer.
+ * @return {size_t} Number of candidates appended.
+ */
+size_t DecodeLayer(const float* data, int height, int width, int channel, int layer,
+                   float objThresh, float confThresh, std::vector<Candidate>& candidates);
+
+/**
+ * @brief: TF8 variant of DecodeLayer(), table maps a quantized value to float.
+ */
+size_t DecodeLayer(const uint8_t* data, int height, int width, int channel, int layer,
+                   const float table[256], float objThresh, float confThresh,
+                   std::vector<Candidate>& candidates);
+
+} // namespace yolov5
+
+#endif // __YOLOV5S_DECODE_H__
@@ -1,6 +1,6 @@
 /*
  * @Description: Object detection algorithm handler.
- * @version: 2.1
+ * @version: 2.3
  * @Author: Ricardo Lu<shenglu1202@163.com>
  * @Date: 2022-05-17 20:27:51
  * @LastEditors: Ricardo Lu
@@ -19,16 +19,73 @@
 #endif
 #include <memory>
 
-#include "SNPETask.h"
+#include "SNPETaskPool.h"
 #include "YOLOv5s.h"
+#include "ImageProcess.h"
+#include "YOLOv5sDecode.h"
+#include "NMS.h"
+#include "AsyncPipeline.h"
 
 namespace yolov5 {
 
+/**
+ * @brief: Frame travelling through the DetectAsync() pipeline.
+ */
+struct AsyncJob {
+    cv::Mat image;
+    int64_t time = 0;
+    std::promise<std::vector<ObjectData>> promise;
+};
+
+/**
+ * @brief: Scratch state of one SNPE replica, only touched under its lease.
+ */
+struct ReplicaContext {
+    // Tensors of the replica resolved at Initialize(), indexed by buffer set
+    struct Tensors {
+        snpetask::TensorHandle input;
+        snpetask::TensorHandle outputs[3];
+    };
+    std::vector<Tensors> tensors;
+
+    // Indexed by set * batch + slot
+    std::vector<LetterboxNormalizer> letterboxes;
+    std::vector<LetterboxInfo> letterboxInfos;
+
+    std::vector<Candidate> candidates;
+    // Decoded boxes in frame coordinates, before NMS
+    std::vector<ObjectData> objects;
+    NMS nms;
+    BoxSet boxes;
+    std::vector<int> keep;
+    std::vector<float> keepScores;
+
+    // Worst case of a frame: every grid cell a candidate. Detect() never allocates after it.
+    void Reserve(size_t grids, int labels) {
+        candidates.reserve(grids);
+        objects.reserve(grids);
+        boxes.reserve(grids);
+        keep.reserve(grids);
+        keepScores.reserve(grids);
+        nms.Reserve(grids, labels);
+    }
+};
+
 class ObjectDetectionImpl {
 public:
     ObjectDetectionImpl();
     ~ObjectDetectionImpl();
     bool Detect(const cv::Mat& image, std::vector<ObjectData>& results);
+    bool Detect(const YUVImage& image, std::vector<ObjectData>& results);
+    bool Detect(const cv::Mat& image, const LetterboxInfo& letterbox, std::vector<ObjectData>& results);
+    bool Detect(const YUVImage& image, const LetterboxInfo& letterbox, std::vector<ObjectData>& results);
+    bool DetectBatch(const std::vector<cv::Mat>& images, std::vector<std::vector<ObjectData>>& results);
+    std::future<std::vector<ObjectData>> DetectAsync(const cv::Mat& image);
+    bool GetReplicaUsage(std::vector<ReplicaUsage>& usage);
+    bool GetStageProfile(std::vector<StageProfile>& profile, bool reset);
+    bool SetPerformanceProfile(performance_profile_t profile) {
+        return m_pool->setPerformanceProfile(profile);
+    }
     bool Initialize(const ObjectDetectionConfig& config);
     bool DeInitialize();
 
@@ -60,67 +117,55 @@ public:
         return m_isInit;
     }
 
-    static std::vector<ObjectData> nms(std::vector<ObjectData> winList, const float& nms_thresh) {
-        if (winList.empty()) {
-            return winList;
-        }
-
-        std::sort(winList.begin(), winList.end(), [] (const ObjectData& left, const ObjectData& right) {
-            if (left.confidence > right.confidence) {
-                return true;
-            } else {
-                return false;
-            }
-        });
-
-        std::vector<bool> flag(winList.size(), false);
-        for (int i = 0; i < winList.size(); i++) {
-            if (flag[i]) {
-                continue;
-            }
-
-            for (int j = i + 1; j < winList.size(); j++) {
-                if (calcIoU(winList[i].bbox, winList[j].bbox) > nms_thresh) {
-                    flag[j] = true;
-                }
-            }
-        }
-
-        std::vector<ObjectData> ret;
-        for (int i = 0; i < winList.size(); i++) {
-            if (!flag[i])
-                ret.push_back(winList[i]);
-        }
-
-        return ret;
-    }
-
 private:
     bool m_isInit = false;
     bool m_isRegisteredPreProcess = false;
     bool m_isRegisteredPostProcess = false;
 
-    bool PreProcess(const cv::Mat& frame);
-    bool PostProcess(std::vector<ObjectData>& results, int64_t time);
+    // Image: cv::Mat (RGB) or YUVImage. letterbox: geometry of a frame letterboxed
+    // upstream, nullptr for a frame at its own resolution.
+    template<typename Image>
+    bool DetectFrame(const Image& image, std::vector<ObjectData>& results,
+                     const LetterboxInfo* letterbox = nullptr);
+
+    // Resolve the input and output tensors of every buffer set of task into ctx.
+    bool ResolveTensors(snpetask::SNPETask& task, size_t bufferSets, ReplicaContext& ctx);
+
+    // slot: batch slot in the input/output tensors, set: SNPE buffer set of the
+    // replica ctx was resolved from.
+    template<typename Image>
+    bool PreProcess(ReplicaContext& ctx, const Image& frame, size_t slot = 0, size_t set = 0);
+    bool PostProcess(ReplicaContext& ctx, std::vector<ObjectData>& results,
+                     int64_t time, size_t slot = 0, size_t set = 0);
 
     pre_process_t m_preProcess;
     post_process_t m_postProcess;
 
-    std::unique_ptr<snpetask::SNPETask> m_task;
+    std::unique_ptr<snpetask::SNPETaskPool> m_pool;
+    // nullptr unless stageProfiling
+    std::shared_ptr<snpetask::StageProfiler> m_profiler;
+    // One per replica of m_pool
+    std::vector<std::unique_ptr<ReplicaContext>> m_contexts;
     std::vector<std::string> m_inputLayers;
     std::vector<std::string> m_outputLayers;
     std::vector<std::string> m_outputTensors;
 
     int m_labels;
     int m_grids;
-    float* m_output;
+    int m_batchSize = 1;
+    NMSConfig m_nmsConfig;
 
     cv::Rect m_roi = {0, 0, 0, 0};
     uint32_t m_minBoxBorder = 16;
     float m_nmsThresh = 0.5f;
     float m_confThresh = 0.5f;
-    float m_scale;
-    int m_xOffset, m_yOffset;
+
+    // Every replica is built from the same container, so they share the input quantization.
+    uint8_t m_quantizeTable[256];
+
+    // DetectAsync() runs on buffer sets 1..asyncDepth of the first replica, set 0 stays for Detect().
+    std::unique_ptr<ReplicaContext> m_asyncContext;
+    std::unique_ptr<AsyncPipeline<std::shared_ptr<AsyncJob>>> m_async;
 };
 
 } // namespace yolov5
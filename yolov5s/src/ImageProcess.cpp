@@ -0,0 +1,534 @@
+/*
+ * @Description: Implementation of image pre-process kernels.
+ * @version: 2.5
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 09:12:40
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 09:12:40
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "ImageProcess.h"
+#include "utils.h"
+
+namespace yolov5 {
+
+// Gray(128, 128, 128) padding used by the letterbox of yolov5.
+static constexpr float kPadValue = 128.0f / 255.0f;
+
+LetterboxInfo CalcLetterbox(int imgWidth, int imgHeight, int inputWidth, int inputHeight)
+{
+    LetterboxInfo info;
+    info.scale = std::min(inputHeight / (float)imgHeight, inputWidth / (float)imgWidth);
+    info.scaledWidth = imgWidth * info.scale;
+    info.scaledHeight = imgHeight * info.scale;
+    info.xOffset = (inputWidth - info.scaledWidth) / 2;
+    info.yOffset = (inputHeight - info.scaledHeight) / 2;
+    return info;
+}
+
+void NormalizeRow(const uint8_t* src, float* dst, int n, float scale)
+{
+    int i = 0;
+#if CV_SIMD
+    // 1 uint8 vector ---> 4 float vectors, converted and scaled in registers.
+    const int step = cv::v_uint8::nlanes;
+    const int fstep = cv::v_float32::nlanes;
+    const cv::v_float32 vscale = cv::vx_setall_f32(scale);
+    for (; i <= n - step; i += step) {
+        cv::v_uint16 w0, w1;
+        cv::v_uint32 d0, d1, d2, d3;
+        cv::v_expand(cv::vx_load(src + i), w0, w1);
+        cv::v_expand(w0, d0, d1);
+        cv::v_expand(w1, d2, d3);
+        cv::v_store(dst + i,             cv::v_cvt_f32(cv::v_reinterpret_as_s32(d0)) * vscale);
+        cv::v_store(dst + i + fstep,     cv::v_cvt_f32(cv::v_reinterpret_as_s32(d1)) * vscale);
+        cv::v_store(dst + i + fstep * 2, cv::v_cvt_f32(cv::v_reinterpret_as_s32(d2)) * vscale);
+        cv::v_store(dst + i + fstep * 3, cv::v_cvt_f32(cv::v_reinterpret_as_s32(d3)) * vscale);
+    }
+    cv::vx_cleanup();
+#endif
+    for (; i < n; i++) {
+        dst[i] = src[i] * scale;
+    }
+}
+
+void BuildQuantizeTable(uint64_t stepExactly0, float stepSize, uint8_t table[256])
+{
+    for (int i = 0; i < 256; i++) {
+        float q = std::round(i / 255.0f / stepSize) + stepExactly0;
+        table[i] = (uint8_t)std::min(255.0f, std::max(0.0f, q));
+    }
+}
+
+void QuantizeRow(const uint8_t* src, uint8_t* dst, int n, const uint8_t table[256])
+{
+    for (int i = 0; i < n; i++) {
+        dst[i] = table[src[i]];
+    }
+}
+
+// Fixed point of cv::resize(INTER_LINEAR): 11 bits per axis. The vertical pass keeps
+// 7 of them: 255 << 7 still fits an int16, so both passes run as int16 dot products.
+static constexpr int kResizeBits = 11;
+static constexpr int kResizeScale = 1 << kResizeBits;
+static constexpr int kColumnBits = 7;
+static constexpr int kColumnShift = kResizeBits - kColumnBits;
+static constexpr int kRowShift = kResizeBits + kColumnBits;
+
+void BilinearResizer::BuildAxis(int srcSize, int dstSize, Axis& axis)
+{
+    axis.index0.resize(dstSize);
+    axis.index1.resize(dstSize);
+    axis.weight0.resize(dstSize);
+    axis.weight1.resize(dstSize);
+
+    const double scale = (double)srcSize / dstSize;
+    for (int d = 0; d < dstSize; d++) {
+        // Pixel centers aligned, clamped at both edges.
+        double f = (d + 0.5) * scale - 0.5;
+        int s = (int)std::floor(f);
+        f -= s;
+        if (s < 0) {
+            s = 0;
+            f = 0.0;
+        }
+        if (s >= srcSize - 1) {
+            s = srcSize - 1;
+            f = 0.0;
+        }
+        int16_t w1 = (int16_t)std::lround(f * kResizeScale);
+        axis.index0[d] = s;
+        axis.index1[d] = std::min(s + 1, srcSize - 1);
+        axis.weight0[d] = kResizeScale - w1;
+        axis.weight1[d] = w1;
+    }
+}
+
+void BilinearResizer::Prepare(int srcWidth, int srcHeight, int channels, int dstWidth, int dstHeight)
+{
+    if (srcWidth == m_srcWidth && srcHeight == m_srcHeight && channels == m_channels &&
+        dstWidth == m_dstWidth && dstHeight == m_dstHeight) {
+        return;
+    }
+
+    m_srcWidth = srcWidth;
+    m_srcHeight = srcHeight;
+    m_channels = channels;
+    m_dstWidth = dstWidth;
+    m_dstHeight = dstHeight;
+    Axis x;
+    BuildAxis(srcWidth, dstWidth, x);
+    BuildAxis(srcHeight, dstHeight, m_y);
+
+    // The right tap is always the next source pixel, clamped edges weigh it 0.
+    m_tap.resize(dstWidth);
+    m_tapWeights.resize((size_t)dstWidth * 2);
+    for (int d = 0; d < dstWidth; d++) {
+        m_tap[d] = x.index0[d];
+        m_tapWeights[d * 2] = x.weight0[d];
+        m_tapWeights[d * 2 + 1] = x.index1[d] == x.index0[d] ? 0 : x.weight1[d];
+    }
+    // One plane per channel, each one value longer for the right tap of the last pixel.
+    m_planeStride = srcWidth + 1;
+    m_column.assign((size_t)m_planeStride * channels, 0);
+}
+
+// (a * w0 + b * w1) >> shift, rounded, of 2 * v_int16::nlanes values.
+#if CV_SIMD
+static inline void BlendStore(const cv::v_uint8& a, const cv::v_uint8& b, const cv::v_int16& vw,
+    const cv::v_int32& vround, int16_t* dst)
+{
+    cv::v_uint16 a0, a1, b0, b1;
+    cv::v_expand(a, a0, a1);
+    cv::v_expand(b, b0, b1);
+    cv::v_int16 p0, p1, p2, p3;
+    cv::v_zip(cv::v_reinterpret_as_s16(a0), cv::v_reinterpret_as_s16(b0), p0, p1);
+    cv::v_zip(cv::v_reinterpret_as_s16(a1), cv::v_reinterpret_as_s16(b1), p2, p3);
+    cv::v_store(dst, cv::v_pack((cv::v_dotprod(p0, vw) + vround) >> kColumnShift,
+                                (cv::v_dotprod(p1, vw) + vround) >> kColumnShift));
+    cv::v_store(dst + cv::v_int16::nlanes, cv::v_pack((cv::v_dotprod(p2, vw) + vround) >> kColumnShift,
+                                                      (cv::v_dotprod(p3, vw) + vround) >> kColumnShift));
+}
+#endif
+
+// Plane c of column gets (r0 * w0 + r1 * w1) >> kColumnShift of channel c, rounded.
+template<int CN>
+static void VerticalRow(const uint8_t* r0, const uint8_t* r1, int w0, int w1, int width,
+    int16_t* column, int planeStride)
+{
+    int x = 0;
+#if CV_SIMD
+    // Rows interleaved into int16 pairs: one dot product blends a value.
+    const int step = cv::v_uint8::nlanes;
+    const cv::v_int16 vw = cv::v_reinterpret_as_s16(cv::vx_setall_s32((w1 << 16) | (w0 & 0xffff)));
+    const cv::v_int32 vround = cv::vx_setall_s32(1 << (kColumnShift - 1));
+    for (; x <= width - step; x += step) {
+        cv::v_uint8 a[CN], b[CN];
+        if constexpr (1 == CN) {
+            a[0] = cv::vx_load(r0 + x);
+            b[0] = cv::vx_load(r1 + x);
+        } else if constexpr (2 == CN) {
+            cv::v_load_deinterleave(r0 + x * CN, a[0], a[1]);
+            cv::v_load_deinterleave(r1 + x * CN, b[0], b[1]);
+        } else {
+            cv::v_load_deinterleave(r0 + x * CN, a[0], a[1], a[2]);
+            cv::v_load_deinterleave(r1 + x * CN, b[0], b[1], b[2]);
+        }
+        for (int c = 0; c < CN; c++) {
+            BlendStore(a[c], b[c], vw, vround, column + c * planeStride + x);
+        }
+    }
+    cv::vx_cleanup();
+#endif
+    for (; x < width; x++) {
+        for (int c = 0; c < CN; c++) {
+            column[c * planeStride + x] = (int16_t)((r0[x * CN + c] * w0 + r1[x * CN + c] * w1 +
+                                                     (1 << (kColumnShift - 1))) >> kColumnShift);
+        }
+    }
+}
+
+// Channel c of dst gets (plane[tap] * w0 + plane[tap + 1] * w1) >> kRowShift of plane c, rounded.
+template<int CN>
+static void HorizontalRow(const int16_t* column, int planeStride, const int* tap, const int16_t* weights,
+    int width, uint8_t* dst)
+{
+    int x = 0;
+#if CV_SIMD
+    // Both taps of a pixel are a gathered int16 pair, blended by one dot product.
+    const int step = cv::v_uint8::nlanes;
+    const int pairs = cv::v_int32::nlanes;
+    const cv::v_int32 vround = cv::vx_setall_s32(1 << (kRowShift - 1));
+    for (; x <= width - step; x += step) {
+        cv::v_int16 vw[4];
+        for (int k = 0; k < 4; k++) vw[k] = cv::vx_load(weights + (x + k * pairs) * 2);
+        cv::v_uint8 out[CN];
+        for (int c = 0; c < CN; c++) {
+            const int16_t* plane = column + c * planeStride;
+            cv::v_int32 s[4];
+            for (int k = 0; k < 4; k++) {
+                s[k] = (cv::v_dotprod(cv::vx_lut_pairs(plane, tap + x + k * pairs), vw[k]) + vround) >> kRowShift;
+            }
+            out[c] = cv::v_pack_u(cv::v_pack(s[0], s[1]), cv::v_pack(s[2], s[3]));
+        }
+        if constexpr (1 == CN) {
+            cv::v_store(dst + x, out[0]);
+        } else if constexpr (2 == CN) {
+            cv::v_store_interleave(dst + x * CN, out[0], out[1]);
+        } else {
+            cv::v_store_interleave(dst + x * CN, out[0], out[1], out[2]);
+        }
+    }
+    cv::vx_cleanup();
+#endif
+    for (; x < width; x++) {
+        const int w0 = weights[x * 2];
+        const int w1 = weights[x * 2 + 1];
+        for (int c = 0; c < CN; c++) {
+            const int16_t* p = column + c * planeStride + tap[x];
+            dst[x * CN + c] = (uint8_t)((p[0] * w0 + p[1] * w1 + (1 << (kRowShift - 1))) >> kRowShift);
+        }
+    }
+}
+
+template<int CN>
+void BilinearResizer::RowCN(const uint8_t* src, size_t stride, int y, uint8_t* dst)
+{
+    const uint8_t* r0 = src + (size_t)m_y.index0[y] * stride;
+    const uint8_t* r1 = src + (size_t)m_y.index1[y] * stride;
+    VerticalRow<CN>(r0, r1, m_y.weight0[y], m_y.weight1[y], m_srcWidth, m_column.data(), m_planeStride);
+    HorizontalRow<CN>(m_column.data(), m_planeStride, m_tap.data(), m_tapWeights.data(), m_dstWidth, dst);
+}
+
+void BilinearResizer::Row(const uint8_t* src, size_t stride, int y, uint8_t* dst)
+{
+    // Vertical blend of the two source rows first, contiguous, into one plane per
+    // channel. Then the gathering pass over the blended planes.
+    switch (m_channels) {
+    case 1:
+        RowCN<1>(src, stride, y, dst);
+        break;
+    case 2:
+        RowCN<2>(src, stride, y, dst);
+        break;
+    default:
+        RowCN<3>(src, stride, y, dst);
+        break;
+    }
+}
+
+void YUVToRGBRow(const uint8_t* y, const uint8_t* u, const uint8_t* v, int uvStep, uint8_t* rgb, int n)
+{
+    // BT.601 limited range in 20 bits fixed point, the coefficients of OpenCV.
+    static constexpr int kShift = 20;
+    static constexpr int kCY = 1220542;
+    static constexpr int kCUB = 2116026;
+    static constexpr int kCUG = -409993;
+    static constexpr int kCVG = -852492;
+    static constexpr int kCVR = 1673527;
+    static constexpr int kRound = 1 << (kShift - 1);
+
+    for (int i = 0; i < n; i++) {
+        int luma = std::max(0, y[i] - 16) * kCY;
+        int cu = u[i * uvStep] - 128;
+        int cv = v[i * uvStep] - 128;
+        int r = (luma + kRound + kCVR * cv) >> kShift;
+        int g = (luma + kRound + kCVG * cv + kCUG * cu) >> kShift;
+        int b = (luma + kRound + kCUB * cu) >> kShift;
+        rgb[i * 3] = (uint8_t)std::min(255, std::max(0, r));
+        rgb[i * 3 + 1] = (uint8_t)std::min(255, std::max(0, g));
+        rgb[i * 3 + 2] = (uint8_t)std::min(255, std::max(0, b));
+    }
+}
+
+YUVImage CropYUV(const YUVImage& image, const cv::Rect& roi)
+{
+    YUVImage crop = image;
+    int x0 = std::max(0, roi.x) & ~1;
+    int y0 = std::max(0, roi.y) & ~1;
+    int x1 = std::min(image.width, roi.x + roi.width);
+    int y1 = std::min(image.height, roi.y + roi.height);
+    crop.width = std::max(0, x1 - x0);
+    crop.height = std::max(0, y1 - y0);
+    if (0 == crop.width || 0 == crop.height) return crop;
+
+    crop.planes[0] = image.planes[0] + (size_t)y0 * image.strides[0] + x0;
+    if (PIXEL_FORMAT_NV12 == image.format) {
+        // Interleaved UV: x0 / 2 chroma pixels of 2 bytes each.
+        crop.planes[1] = image.planes[1] + (size_t)(y0 / 2) * image.strides[1] + x0;
+    } else {
+        crop.planes[1] = image.planes[1] + (size_t)(y0 / 2) * image.strides[1] + x0 / 2;
+        crop.planes[2] = image.planes[2] + (size_t)(y0 / 2) * image.strides[2] + x0 / 2;
+    }
+    return crop;
+}
+
+bool ResizeYUVToRGB(const YUVImage& image, int width, int height, cv::Mat& yuv, cv::Mat& rgb)
+{
+    if (image.empty() || width <= 0 || height <= 0) {
+        LOG_ERROR("Invalid image!");
+        return false;
+    }
+    if (PIXEL_FORMAT_NV12 != image.format && PIXEL_FORMAT_I420 != image.format) {
+        LOG_ERROR("Unsupported pixel format: {}", (int)image.format);
+        return false;
+    }
+
+    // 4:2:0 needs even sizes, the extra column/row is cut by the caller.
+    const int w = (width + 1) & ~1;
+    const int h = (height + 1) & ~1;
+    const int cw = (image.width + 1) / 2;
+    const int ch = (image.height + 1) / 2;
+
+    // One contiguous small frame laid out as cv::cvtColor() expects it, the planes
+    // are resized straight into their place (resize() keeps a matching dst buffer).
+    yuv.create(h * 3 / 2, w, CV_8UC1);
+    uint8_t* chroma = yuv.ptr<uint8_t>(h);
+
+    cv::Mat srcY(image.height, image.width, CV_8UC1, (void*)image.planes[0], image.strides[0]);
+    cv::Mat dstY(h, w, CV_8UC1, yuv.data, yuv.step);
+    cv::resize(srcY, dstY, dstY.size(), 0, 0, cv::INTER_LINEAR);
+
+    if (PIXEL_FORMAT_NV12 == image.format) {
+        cv::Mat srcUV(ch, cw, CV_8UC2, (void*)image.planes[1], image.strides[1]);
+        cv::Mat dstUV(h / 2, w / 2, CV_8UC2, chroma);
+        cv::resize(srcUV, dstUV, dstUV.size(), 0, 0, cv::INTER_LINEAR);
+        cv::cvtColor(yuv, rgb, cv::COLOR_YUV2RGB_NV12);
+    } else {
+        const size_t chromaSize = (size_t)(w / 2) * (h / 2);
+        cv::Mat srcU(ch, cw, CV_8UC1, (void*)image.planes[1], image.strides[1]);
+        cv::Mat srcV(ch, cw, CV_8UC1, (void*)image.planes[2], image.strides[2]);
+        cv::Mat dstU(h / 2, w / 2, CV_8UC1, chroma);
+        cv::Mat dstV(h / 2, w / 2, CV_8UC1, chroma + chromaSize);
+        cv::resize(srcU, dstU, dstU.size(), 0, 0, cv::INTER_LINEAR);
+        cv::resize(srcV, dstV, dstV.size(), 0, 0, cv::INTER_LINEAR);
+        cv::cvtColor(yuv, rgb, cv::COLOR_YUV2RGB_I420);
+    }
+
+    return true;
+}
+
+template<typename T>
+void LetterboxNormalizer::FillBorder(T* tensor, int inputWidth, int inputHeight,
+    T padValue, const LetterboxInfo& info)
+{
+    const size_t rowSize = (size_t)inputWidth * 3;
+    const int bottom = info.yOffset + info.scaledHeight;
+
+    std::fill(tensor, tensor + info.yOffset * rowSize, padValue);
+    std::fill(tensor + bottom * rowSize, tensor + inputHeight * rowSize, padValue);
+
+    const int right = info.xOffset + info.scaledWidth;
+    for (int y = info.yOffset; y < bottom; y++) {
+        T* row = tensor + y * rowSize;
+        std::fill(row, row + info.xOffset * 3, padValue);
+        std::fill(row + right * 3, row + rowSize, padValue);
+    }
+}
+
+template<typename T>
+bool LetterboxNormalizer::Prepare(int imgWidth, int imgHeight, T* tensor, int inputWidth, int inputHeight,
+    T padValue, LetterboxInfo& info)
+{
+    info = CalcLetterbox(imgWidth, imgHeight, inputWidth, inputHeight);
+    if (info.scaledWidth <= 0 || info.scaledHeight <= 0) {
+        LOG_ERROR("Invalid letterbox size: {}x{}", info.scaledWidth, info.scaledHeight);
+        return false;
+    }
+
+    // The padding border is constant as long as the geometry is, skip it.
+    if (!m_borderValid || info != m_last) {
+        FillBorder(tensor, inputWidth, inputHeight, padValue, info);
+        m_last = info;
+        m_borderValid = true;
+    }
+    return true;
+}
+
+template<typename T, typename RowFunc>
+bool LetterboxNormalizer::Letterbox(const cv::Mat& image, T* tensor, int inputWidth, int inputHeight,
+    T padValue, LetterboxInfo& info, RowFunc rowFunc)
+{
+    if (image.empty() || image.type() != CV_8UC3) {
+        LOG_ERROR("Invalid image!");
+        return false;
+    }
+
+    if (!Prepare(image.cols, image.rows, tensor, inputWidth, inputHeight, padValue, info)) {
+        return false;
+    }
+
+    // Resize one row at a time into a reused buffer, then convert it
+    // directly into its place inside the tensor.
+    const bool resize = image.cols != info.scaledWidth || image.rows != info.scaledHeight;
+    if (resize) {
+        m_resizer.Prepare(image.cols, image.rows, 3, info.scaledWidth, info.scaledHeight);
+        m_row.resize((size_t)info.scaledWidth * 3);
+    }
+
+    for (int y = 0; y < info.scaledHeight; y++) {
+        const uint8_t* src = image.ptr<uint8_t>(resize ? 0 : y);
+        if (resize) {
+            m_resizer.Row(src, image.step, y, m_row.data());
+            src = m_row.data();
+        }
+        T* dst = tensor + ((size_t)(info.yOffset + y) * inputWidth + info.xOffset) * 3;
+        rowFunc(src, dst, info.scaledWidth * 3);
+    }
+
+    return true;
+}
+
+template<typename T, typename RowFunc>
+bool LetterboxNormalizer::Letterbox(const YUVImage& image, T* tensor, int inputWidth, int inputHeight,
+    T padValue, LetterboxInfo& info, RowFunc rowFunc)
+{
+    if (image.empty()) {
+        LOG_ERROR("Invalid image!");
+        return false;
+    }
+    if (PIXEL_FORMAT_NV12 != image.format && PIXEL_FORMAT_I420 != image.format) {
+        LOG_ERROR("Unsupported pixel format: {}", (int)image.format);
+        return false;
+    }
+
+    if (!Prepare(image.width, image.height, tensor, inputWidth, inputHeight, padValue, info)) {
+        return false;
+    }
+
+    // Luma and chroma are resized straight to the letterbox size, chroma bilinearly
+    // upsampled on the way, then every row is converted to RGB.
+    const bool nv12 = PIXEL_FORMAT_NV12 == image.format;
+    const int width = info.scaledWidth;
+    const int chromaWidth = (image.width + 1) / 2;
+    const int chromaHeight = (image.height + 1) / 2;
+    m_resizer.Prepare(image.width, image.height, 1, width, info.scaledHeight);
+    m_chromaResizer.Prepare(chromaWidth, chromaHeight, nv12 ? 2 : 1, width, info.scaledHeight);
+    if (!nv12) m_chromaResizer2.Prepare(chromaWidth, chromaHeight, 1, width, info.scaledHeight);
+    m_rowY.resize(width);
+    m_rowU.resize((size_t)width * (nv12 ? 2 : 1));
+    m_rowV.resize(width);
+    m_row.resize((size_t)width * 3);
+
+    for (int y = 0; y < info.scaledHeight; y++) {
+        m_resizer.Row(image.planes[0], image.strides[0], y, m_rowY.data());
+        m_chromaResizer.Row(image.planes[1], image.strides[1], y, m_rowU.data());
+        if (nv12) {
+            YUVToRGBRow(m_rowY.data(), m_rowU.data(), m_rowU.data() + 1, 2, m_row.data(), width);
+        } else {
+            m_chromaResizer2.Row(image.planes[2], image.strides[2], y, m_rowV.data());
+            YUVToRGBRow(m_rowY.data(), m_rowU.data(), m_rowV.data(), 1, m_row.data(), width);
+        }
+        T* dst = tensor + ((size_t)(info.yOffset + y) * inputWidth + info.xOffset) * 3;
+        rowFunc(m_row.data(), dst, width * 3);
+    }
+
+    return true;
+}
+
+static bool IsIdentity(const uint8_t table[256])
+{
+    for (int i = 0; i < 256; i++) {
+        if (table[i] != i) return false;
+    }
+    return true;
+}
+
+bool LetterboxNormalizer::Run(const cv::Mat& image, float* tensor,
+    int inputWidth, int inputHeight, LetterboxInfo& info)
+{
+    return Letterbox(image, tensor, inputWidth, inputHeight, kPadValue, info,
+        [](const uint8_t* src, float* dst, int n) {
+            NormalizeRow(src, dst, n, 1.0f / 255.0f);
+        });
+}
+
+bool LetterboxNormalizer::Run(const cv::Mat& image, uint8_t* tensor,
+    int inputWidth, int inputHeight, const uint8_t table[256], LetterboxInfo& info)
+{
+    // The common stepSize = 1/255, stepExactly0 = 0 encoding is the raw pixel.
+    if (IsIdentity(table)) {
+        return Letterbox(image, tensor, inputWidth, inputHeight, table[128], info,
+            [](const uint8_t* src, uint8_t* dst, int n) {
+                memcpy(dst, src, n);
+            });
+    }
+
+    return Letterbox(image, tensor, inputWidth, inputHeight, table[128], info,
+        [table](const uint8_t* src, uint8_t* dst, int n) {
+            QuantizeRow(src, dst, n, table);
+        });
+}
+
+bool LetterboxNormalizer::Run(const YUVImage& image, float* tensor,
+    int inputWidth, int inputHeight, LetterboxInfo& info)
+{
+    return Letterbox(image, tensor, inputWidth, inputHeight, kPadValue, info,
+        [](const uint8_t* src, float* dst, int n) {
+            NormalizeRow(src, dst, n, 1.0f / 255.0f);
+        });
+}
+
+bool LetterboxNormalizer::Run(const YUVImage& image, uint8_t* tensor,
+    int inputWidth, int inputHeight, const uint8_t table[256], LetterboxInfo& info)
+{
+    if (IsIdentity(table)) {
+        return Letterbox(image, tensor, inputWidth, inputHeight, table[128], info,
+            [](const uint8_t* src, uint8_t* dst, int n) {
+                memcpy(dst, src, n);
+            });
+    }
+
+    return Letterbox(image, tensor, inputWidth, inputHeight, table[128], info,
+        [table](const uint8_t* src, uint8_t* dst, int n) {
+            QuantizeRow(src, dst, n, table);
+        });
+}
+
+} // namespace yolov5
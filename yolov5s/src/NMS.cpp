@@ -0,0 +1,287 @@
+/*
+ * @Description: Implementation of the non-maximum suppression engine.
+ * @version: 2.3
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 13:20:05
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 13:20:05
+ */
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include "NMS.h"
+
+namespace yolov5 {
+
+// Hard NMS switches from a linear scan of the kept boxes to grid binning above it.
+static constexpr size_t kGridMinBoxes = 128;
+static constexpr int kGridSize = 16;
+
+nms_method_t ParseNMSMethod(const std::string& name)
+{
+    if (0 == name.compare("fast")) {
+        return NMS_FAST;
+    } else if (0 == name.compare("soft-linear")) {
+        return NMS_SOFT_LINEAR;
+    } else if (0 == name.compare("soft-gaussian")) {
+        return NMS_SOFT_GAUSSIAN;
+    } else {
+        return NMS_HARD;
+    }
+}
+
+// Overlap test of box b against n boxes without division: IoU > t <=> inter > t * union.
+// Branch free, so the compiler vectorizes it.
+static int AnyOverlap(float x1, float y1, float x2, float y2, float area,
+    const float* bx1, const float* by1, const float* bx2, const float* by2, const float* barea,
+    size_t n, float thresh)
+{
+    int hit = 0;
+    for (size_t j = 0; j < n; j++) {
+        float w = std::max(0.0f, std::min(x2, bx2[j]) - std::max(x1, bx1[j]) + 1.0f);
+        float h = std::max(0.0f, std::min(y2, by2[j]) - std::max(y1, by1[j]) + 1.0f);
+        float inter = w * h;
+        hit |= inter > thresh * (area + barea[j] - inter);
+    }
+    return hit;
+}
+
+void NMS::Gather(const BoxSet& boxes, const int* order, size_t n)
+{
+    m_index.assign(order, order + n);
+    m_x1.resize(n); m_y1.resize(n); m_x2.resize(n); m_y2.resize(n);
+    m_area.resize(n); m_score.resize(n);
+
+    for (size_t i = 0; i < n; i++) {
+        int idx = order[i];
+        m_x1[i] = boxes.x1[idx];
+        m_y1[i] = boxes.y1[idx];
+        m_x2[i] = boxes.x2[idx];
+        m_y2[i] = boxes.y2[idx];
+        m_area[i] = (m_x2[i] - m_x1[i] + 1.0f) * (m_y2[i] - m_y1[i] + 1.0f);
+        m_score[i] = boxes.scores[idx];
+    }
+}
+
+void NMS::Hard(const NMSConfig& config, std::vector<int>& keep, std::vector<float>& scores)
+{
+    const size_t n = m_index.size();
+    m_kx1.clear(); m_ky1.clear(); m_kx2.clear(); m_ky2.clear(); m_karea.clear();
+
+    // Grid binning: a box is only compared with the kept boxes sharing a cell with it.
+    // Ranges are widened by 1 pixel because IoU is pixel inclusive.
+    const bool useGrid = n >= kGridMinBoxes;
+    float minX = 0.0f, minY = 0.0f, cellW = 1.0f, cellH = 1.0f;
+    if (useGrid) {
+        minX = *std::min_element(m_x1.begin(), m_x1.end());
+        minY = *std::min_element(m_y1.begin(), m_y1.end());
+        float maxX = *std::max_element(m_x2.begin(), m_x2.end()) + 1.0f;
+        float maxY = *std::max_element(m_y2.begin(), m_y2.end()) + 1.0f;
+        cellW = std::max(1.0f, (maxX - minX) / kGridSize);
+        cellH = std::max(1.0f, (maxY - minY) / kGridSize);
+        m_cells.resize(kGridSize * kGridSize);
+        for (auto& cell : m_cells) cell.clear();
+        m_visited.assign(n, -1);
+    }
+
+    auto cellRange = [&](size_t i, int& cx0, int& cy0, int& cx1, int& cy1) {
+        cx0 = std::min(kGridSize - 1, std::max(0, (int)((m_x1[i] - minX) / cellW)));
+        cy0 = std::min(kGridSize - 1, std::max(0, (int)((m_y1[i] - minY) / cellH)));
+        cx1 = std::min(kGridSize - 1, std::max(0, (int)((m_x2[i] + 1.0f - minX) / cellW)));
+        cy1 = std::min(kGridSize - 1, std::max(0, (int)((m_y2[i] + 1.0f - minY) / cellH)));
+    };
+
+    for (size_t i = 0; i < n; i++) {
+        int suppressed = 0;
+        int cx0, cy0, cx1, cy1;
+
+        if (!useGrid) {
+            suppressed = AnyOverlap(m_x1[i], m_y1[i], m_x2[i], m_y2[i], m_area[i],
+                m_kx1.data(), m_ky1.data(), m_kx2.data(), m_ky2.data(), m_karea.data(),
+                m_kx1.size(), config.iouThresh);
+        } else {
+            cellRange(i, cx0, cy0, cx1, cy1);
+            for (int cy = cy0; cy <= cy1 && !suppressed; cy++) {
+                for (int cx = cx0; cx <= cx1 && !suppressed; cx++) {
+                    for (int k : m_cells[cy * kGridSize + cx]) {
+                        if (m_visited[k] == (int)i) continue;
+                        m_visited[k] = i;
+                        if (AnyOverlap(m_x1[i], m_y1[i], m_x2[i], m_y2[i], m_area[i],
+                            &m_kx1[k], &m_ky1[k], &m_kx2[k], &m_ky2[k], &m_karea[k], 1, config.iouThresh)) {
+                            suppressed = 1;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (suppressed) continue;
+
+        int k = m_kx1.size();
+        m_kx1.push_back(m_x1[i]); m_ky1.push_back(m_y1[i]);
+        m_kx2.push_back(m_x2[i]); m_ky2.push_back(m_y2[i]);
+        m_karea.push_back(m_area[i]);
+        keep.push_back(m_index[i]);
+        scores.push_back(m_score[i]);
+
+        if (useGrid) {
+            for (int cy = cy0; cy <= cy1; cy++) {
+                for (int cx = cx0; cx <= cx1; cx++) {
+                    m_cells[cy * kGridSize + cx].push_back(k);
+                }
+            }
+        }
+    }
+}
+
+void NMS::Fast(const NMSConfig& config, std::vector<int>& keep, std::vector<float>& scores)
+{
+    // A box is dropped if any higher score box overlaps it, suppressed or not:
+    // every row of the IoU upper triangle is independent and vectorized.
+    const size_t n = m_index.size();
+    for (size_t j = 0; j < n; j++) {
+        if (AnyOverlap(m_x1[j], m_y1[j], m_x2[j], m_y2[j], m_area[j],
+            m_x1.data(), m_y1.data(), m_x2.data(), m_y2.data(), m_area.data(), j, config.iouThresh)) {
+            continue;
+        }
+        keep.push_back(m_index[j]);
+        scores.push_back(m_score[j]);
+    }
+}
+
+void NMS::Soft(const NMSConfig& config, std::vector<int>& keep, std::vector<float>& scores)
+{
+    const size_t n = m_index.size();
+    const bool gaussian = NMS_SOFT_GAUSSIAN == config.method;
+
+    for (size_t pos = 0; pos < n; pos++) {
+        // Scores change after every pick, select the current best.
+        size_t best = pos;
+        for (size_t j = pos + 1; j < n; j++) {
+            if (m_score[j] > m_score[best]) best = j;
+        }
+        if (m_score[best] < config.scoreThresh) break;
+
+        std::swap(m_index[pos], m_index[best]);
+        std::swap(m_x1[pos], m_x1[best]);
+        std::swap(m_y1[pos], m_y1[best]);
+        std::swap(m_x2[pos], m_x2[best]);
+        std::swap(m_y2[pos], m_y2[best]);
+        std::swap(m_area[pos], m_area[best]);
+        std::swap(m_score[pos], m_score[best]);
+
+        keep.push_back(m_index[pos]);
+        scores.push_back(m_score[pos]);
+
+        for (size_t j = pos + 1; j < n; j++) {
+            float w = std::max(0.0f, std::min(m_x2[pos], m_x2[j]) - std::max(m_x1[pos], m_x1[j]) + 1.0f);
+            float h = std::max(0.0f, std::min(m_y2[pos], m_y2[j]) - std::max(m_y1[pos], m_y1[j]) + 1.0f);
+            float inter = w * h;
+            float iou = inter / (m_area[pos] + m_area[j] - inter);
+            if (gaussian) {
+                m_score[j] *= std::exp(-iou * iou / config.sigma);
+            } else if (iou > config.iouThresh) {
+                m_score[j] *= 1.0f - iou;
+            }
+        }
+    }
+}
+
+void NMS::Reserve(size_t n, int labels)
+{
+    m_order.reserve(n);
+    m_index.reserve(n);
+    m_groupStart.reserve(labels + 1);
+    m_x1.reserve(n); m_y1.reserve(n); m_x2.reserve(n); m_y2.reserve(n);
+    m_area.reserve(n); m_score.reserve(n);
+    m_kx1.reserve(n); m_ky1.reserve(n); m_kx2.reserve(n); m_ky2.reserve(n);
+    m_karea.reserve(n);
+    m_cells.resize(kGridSize * kGridSize);
+    m_visited.reserve(std::max(n, (size_t)labels));
+}
+
+void NMS::Run(const BoxSet& boxes, const NMSConfig& config, std::vector<int>& keep, std::vector<float>& scores)
+{
+    keep.clear();
+    scores.clear();
+
+    const size_t n = boxes.size();
+    if (n == 0) return;
+
+    // Sort by descending score, index as tie breaker to stay deterministic,
+    // and cut to the top maxCandidates.
+    auto byScore = [&boxes](int a, int b) {
+        return boxes.scores[a] > boxes.scores[b] || (boxes.scores[a] == boxes.scores[b] && a < b);
+    };
+    m_order.resize(n);
+    std::iota(m_order.begin(), m_order.end(), 0);
+    size_t count = n;
+    if (config.maxCandidates > 0 && n > (size_t)config.maxCandidates) {
+        count = config.maxCandidates;
+        std::partial_sort(m_order.begin(), m_order.begin() + count, m_order.end(), byScore);
+        m_order.resize(count);
+    } else {
+        std::sort(m_order.begin(), m_order.end(), byScore);
+    }
+
+    // Class aware: counting sort by label keeps the score order inside each label.
+    int groups = 1;
+    m_groupStart.assign(2, 0);
+    m_groupStart[1] = count;
+    if (config.classAware) {
+        int maxLabel = 0;
+        for (int idx : m_order) maxLabel = std::max(maxLabel, boxes.labels[idx]);
+        groups = maxLabel + 1;
+        m_groupStart.assign(groups + 1, 0);
+        for (int idx : m_order) m_groupStart[std::max(0, boxes.labels[idx]) + 1]++;
+        for (int g = 0; g < groups; g++) m_groupStart[g + 1] += m_groupStart[g];
+
+        m_index.resize(count);
+        m_visited.assign(m_groupStart.begin(), m_groupStart.end() - 1);
+        for (int idx : m_order) m_index[m_visited[std::max(0, boxes.labels[idx])]++] = idx;
+        m_order.swap(m_index);
+    }
+
+    for (int g = 0; g < groups; g++) {
+        size_t start = m_groupStart[g];
+        size_t len = m_groupStart[g + 1] - start;
+        if (len == 0) continue;
+
+        Gather(boxes, m_order.data() + start, len);
+        switch (config.method) {
+            case NMS_FAST:
+                Fast(config, keep, scores);
+                break;
+            case NMS_SOFT_LINEAR:
+            case NMS_SOFT_GAUSSIAN:
+                Soft(config, keep, scores);
+                break;
+            case NMS_HARD:
+            default:
+                Hard(config, keep, scores);
+                break;
+        }
+    }
+
+    // Merge the per-label results back into one descending score list.
+    if (groups > 1 || NMS_SOFT_LINEAR == config.method || NMS_SOFT_GAUSSIAN == config.method) {
+        m_order.resize(keep.size());
+        std::iota(m_order.begin(), m_order.end(), 0);
+        std::sort(m_order.begin(), m_order.end(), [&](int a, int b) {
+            return scores[a] > scores[b] || (scores[a] == scores[b] && keep[a] < keep[b]);
+        });
+        m_index.resize(keep.size());
+        m_score.resize(keep.size());
+        for (size_t i = 0; i < m_order.size(); i++) {
+            m_index[i] = keep[m_order[i]];
+            m_score[i] = scores[m_order[i]];
+        }
+        keep.assign(m_index.begin(), m_index.end());
+        scores.assign(m_score.begin(), m_score.end());
+    }
+}
+
+} // namespace yolov5
@@ -0,0 +1,156 @@
+/*
+ * @Description: Implementation of the SORT style multi-object tracker.
+ * @version: 1.0
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-18 00:58:13
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-18 00:58:13
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "Tracker.h"
+
+namespace yolov5 {
+
+void ObjectTracker::Advance(Track& track, int64_t timestamp_ms) const
+{
+    float dt = std::max<int64_t>(0, timestamp_ms - track.timestamp_ms) / 1000.0f;
+    track.timestamp_ms = std::max(track.timestamp_ms, timestamp_ms);
+    if (dt <= 0.0f) return;
+
+    // x' = x + v * dt, white noise acceleration q: Q = q * [dt^3/3 dt^2/2; dt^2/2 dt].
+    // The noise of every axis scales with the box height, as in DeepSORT.
+    float sigma = m_config.processNoise * std::max(track.axes[3].x, 1.0f);
+    float q = sigma * sigma;
+    for (Axis& a : track.axes) {
+        a.x += a.v * dt;
+        a.p00 += dt * (2.0f * a.p01 + dt * a.p11) + q * dt * dt * dt / 3.0f;
+        a.p01 += dt * a.p11 + q * dt * dt / 2.0f;
+        a.p11 += q * dt;
+    }
+}
+
+void ObjectTracker::Correct(Track& track, const cv::Rect& bbox) const
+{
+    const float z[4] = {bbox.x + bbox.width / 2.0f, bbox.y + bbox.height / 2.0f,
+                        (float)bbox.width, (float)bbox.height};
+    float sigma = m_config.measurementNoise * std::max((float)bbox.height, 1.0f);
+    float r = sigma * sigma;
+    // Position measured only: K = P H' / (H P H' + r), H = [1 0].
+    for (int i = 0; i < 4; i++) {
+        Axis& a = track.axes[i];
+        float s = a.p00 + r;
+        float k0 = a.p00 / s;
+        float k1 = a.p01 / s;
+        float y = z[i] - a.x;
+        a.x += k0 * y;
+        a.v += k1 * y;
+        a.p11 -= k1 * a.p01;
+        a.p01 -= k0 * a.p01;
+        a.p00 -= k0 * a.p00;
+    }
+}
+
+cv::Rect ObjectTracker::ToRect(const Track& track)
+{
+    float w = std::max(track.axes[2].x, 1.0f);
+    float h = std::max(track.axes[3].x, 1.0f);
+    return cv::Rect(std::lround(track.axes[0].x - w / 2.0f), std::lround(track.axes[1].x - h / 2.0f),
+                    std::lround(w), std::lround(h));
+}
+
+void ObjectTracker::Update(std::vector<ObjectData>& objects, int64_t timestamp_ms)
+{
+    for (Track& track : m_tracks) {
+        Advance(track, timestamp_ms);
+    }
+
+    // Every pair above the threshold, best first: a greedy assignment, which SORT
+    // matches with the Hungarian one as long as the objects are not crowded.
+    m_candidates.clear();
+    for (size_t t = 0; t < m_tracks.size(); t++) {
+        cv::Rect predicted = ToRect(m_tracks[t]);
+        for (size_t o = 0; o < objects.size(); o++) {
+            if (objects[o].label != m_tracks[t].label) continue;
+            float iou = calcIoU(predicted, objects[o].bbox);
+            if (iou >= m_config.matchIoU) m_candidates.push_back({iou, (int)t, (int)o});
+        }
+    }
+    std::sort(m_candidates.begin(), m_candidates.end(),
+        [](const Candidate& a, const Candidate& b) { return a.iou > b.iou; });
+
+    m_trackMatch.assign(m_tracks.size(), -1);
+    m_objectMatch.assign(objects.size(), -1);
+    for (const Candidate& c : m_candidates) {
+        if (m_trackMatch[c.track] >= 0 || m_objectMatch[c.object] >= 0) continue;
+        m_trackMatch[c.track] = c.object;
+        m_objectMatch[c.object] = c.track;
+    }
+
+    for (size_t t = 0; t < m_tracks.size(); t++) {
+        int o = m_trackMatch[t];
+        if (o < 0) continue;
+        Track& track = m_tracks[t];
+        Correct(track, objects[o].bbox);
+        track.updated_ms = track.timestamp_ms;
+        track.confidence = objects[o].confidence;
+        if (++track.hits >= m_config.minHits && track.id < 0) track.id = m_nextId++;
+        objects[o].trackId = track.id;
+    }
+
+    // Lost tracks: tentative ones at once, confirmed ones after maxAge_ms. Swap
+    // removal, the match of the moved track moves with it.
+    for (size_t t = 0; t < m_tracks.size();) {
+        Track& track = m_tracks[t];
+        bool lost = m_trackMatch[t] < 0 && (track.id < 0 || timestamp_ms - track.updated_ms > m_config.maxAge_ms);
+        if (lost) {
+            m_trackMatch[t] = m_trackMatch[m_tracks.size() - 1];
+            track = m_tracks.back();
+            m_tracks.pop_back();
+        } else {
+            t++;
+        }
+    }
+
+    // New tentative tracks from the unmatched detections.
+    for (size_t o = 0; o < objects.size(); o++) {
+        if (m_objectMatch[o] >= 0) continue;
+        const cv::Rect& bbox = objects[o].bbox;
+        float h = std::max((float)bbox.height, 1.0f);
+        float position = 2.0f * m_config.measurementNoise * h;
+        Track track;
+        const float z[4] = {bbox.x + bbox.width / 2.0f, bbox.y + bbox.height / 2.0f,
+                            (float)bbox.width, (float)bbox.height};
+        for (int i = 0; i < 4; i++) {
+            // Unknown velocity: up to about one box height per second.
+            track.axes[i] = {z[i], 0.0f, position * position, 0.0f, h * h};
+        }
+        track.timestamp_ms = timestamp_ms;
+        track.updated_ms = timestamp_ms;
+        track.label = objects[o].label;
+        track.confidence = objects[o].confidence;
+        track.hits = 1;
+        track.id = m_config.minHits <= 1 ? m_nextId++ : -1;
+        objects[o].trackId = track.id;
+        m_tracks.push_back(track);
+    }
+}
+
+void ObjectTracker::Predict(int64_t timestamp_ms, std::vector<ObjectData>& objects)
+{
+    for (Track& track : m_tracks) {
+        Advance(track, timestamp_ms);
+        if (track.id < 0 || timestamp_ms - track.updated_ms > m_config.maxAge_ms) continue;
+
+        ObjectData object;
+        object.bbox = ToRect(track);
+        object.confidence = track.confidence;
+        object.label = track.label;
+        object.trackId = track.id;
+        objects.push_back(object);
+    }
+}
+
+} // namespace yolov5
@@ -7,6 +7,7 @@
  * @LastEditTime: 2022-07-12 08:24:29
  */
 
+#include <stdexcept>
 #if defined(WIN32) || defined(_WIN32)
 #include <time.h>
 #else
@@ -66,6 +67,91 @@ bool ObjectDetection::Detect(const cv::Mat& image, std::vector<ObjectData>& resu
     }
 }
 
+bool ObjectDetection::Detect(const YUVImage& image, std::vector<ObjectData>& results)
+{
+    if (nullptr != impl && IsInitialized()) {
+        return static_cast<ObjectDetectionImpl*>(impl)->Detect(image, results);
+    } else {
+        LOG_ERROR("ObjectDetection::Detect failed caused by incompleted initialization!");
+        return false;
+    }
+}
+
+bool ObjectDetection::Detect(const cv::Mat& image, const LetterboxInfo& letterbox,
+    std::vector<ObjectData>& results)
+{
+    if (nullptr != impl && IsInitialized()) {
+        return static_cast<ObjectDetectionImpl*>(impl)->Detect(image, letterbox, results);
+    } else {
+        LOG_ERROR("ObjectDetection::Detect failed caused by incompleted initialization!");
+        return false;
+    }
+}
+
+bool ObjectDetection::Detect(const YUVImage& image, const LetterboxInfo& letterbox,
+    std::vector<ObjectData>& results)
+{
+    if (nullptr != impl && IsInitialized()) {
+        return static_cast<ObjectDetectionImpl*>(impl)->Detect(image, letterbox, results);
+    } else {
+        LOG_ERROR("ObjectDetection::Detect failed caused by incompleted initialization!");
+        return false;
+    }
+}
+
+bool ObjectDetection::DetectBatch(const std::vector<cv::Mat>& images,
+    std::vector<std::vector<ObjectData>>& results)
+{
+    if (nullptr != impl && IsInitialized()) {
+        return static_cast<ObjectDetectionImpl*>(impl)->DetectBatch(images, results);
+    } else {
+        LOG_ERROR("ObjectDetection::DetectBatch failed caused by incompleted initialization!");
+        return false;
+    }
+}
+
+std::future<std::vector<ObjectData>> ObjectDetection::DetectAsync(const cv::Mat& image)
+{
+    if (nullptr != impl && IsInitialized()) {
+        return static_cast<ObjectDetectionImpl*>(impl)->DetectAsync(image);
+    } else {
+        LOG_ERROR("ObjectDetection::DetectAsync failed caused by incompleted initialization!");
+        std::promise<std::vector<ObjectData>> promise;
+        promise.set_exception(std::make_exception_ptr(std::runtime_error("ObjectDetection is not initialized")));
+        return promise.get_future();
+    }
+}
+
+bool ObjectDetection::SetPerformanceProfile(performance_profile_t profile)
+{
+    if (nullptr != impl && IsInitialized()) {
+        return static_cast<ObjectDetectionImpl*>(impl)->SetPerformanceProfile(profile);
+    } else {
+        LOG_ERROR("ObjectDetection::SetPerformanceProfile failed caused by incompleted initialization!");
+        return false;
+    }
+}
+
+bool ObjectDetection::GetReplicaUsage(std::vector<ReplicaUsage>& usage)
+{
+    if (nullptr != impl && IsInitialized()) {
+        return static_cast<ObjectDetectionImpl*>(impl)->GetReplicaUsage(usage);
+    } else {
+        LOG_ERROR("ObjectDetection::GetReplicaUsage failed caused by incompleted initialization!");
+        return false;
+    }
+}
+
+bool ObjectDetection::GetStageProfile(std::vector<StageProfile>& profile, bool reset)
+{
+    if (nullptr != impl && IsInitialized()) {
+        return static_cast<ObjectDetectionImpl*>(impl)->GetStageProfile(profile, reset);
+    } else {
+        LOG_ERROR("ObjectDetection::GetStageProfile failed caused by incompleted initialization!");
+        return false;
+    }
+}
+
 bool ObjectDetection::SetScoreThreshold(const float& conf_thresh, const float& nms_thresh)
 {
     if (nullptr != impl) {
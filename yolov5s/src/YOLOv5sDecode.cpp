@@ -0,0 +1,93 @@
+/*
+ * @Description: Implementation of yolov5s output layers decoder.
+ * @version: 2.2
+ * @Author: Ricardo Lu<shenglu1202@163.com>
+ * @Date: 2026-10-17 11:03:27
+ * @LastEditors: Ricardo Lu
+ * @LastEditTime: 2026-10-17 11:03:27
+ */
+
+#include "YOLOv5sDecode.h"
+
+namespace yolov5 {
+
+static const float kStrides[3] = {8, 16, 32};
+static const float kAnchorGrid[][6] = {
+    {10, 13, 16, 30, 33, 23},       // 8*8
+    {30, 61, 62, 45, 59, 119},      // 16*16
+    {116, 90, 156, 198, 373, 326},  // 32*32
+};
+
+// T is the element type of the output layer, isObject() tests the raw objectness
+// and dequant() maps a raw value to float. Class probabilities are compared raw,
+// the quantization of TF8 is monotonic so the argmax doesn't change.
+template<typename T, typename IsObject, typename Dequant>
+static size_t Decode(const T* data, int height, int width, int channel, int layer,
+    IsObject isObject, Dequant dequant, float confThresh, std::vector<Candidate>& candidates)
+{
+    const int step = channel / 3;   // 85 ----> [x, y, w, h, objectness, prob0, prob1,..., prob79]
+    const float stride = kStrides[layer];
+    const T* anchor = data;
+    size_t count = 0;
+
+    for (int j = 0; j < height; j++) {      // 80/40/20
+        for (int k = 0; k < width; k++) {   // 80/40/20
+            for (int l = 0; l < 3; l++, anchor += step) {
+                // Most anchors stop here, neither box nor classes are touched.
+                if (!isObject(anchor[4])) continue;
+
+                int maxIdx = 5;
+                for (int m = 6; m < step; m++) {
+                    if (anchor[m] > anchor[maxIdx]) maxIdx = m;
+                }
+
+                float score = dequant(anchor[4]) * dequant(anchor[maxIdx]);
+                if (score <= confThresh) continue;
+
+                float w = dequant(anchor[2]);
+                float h = dequant(anchor[3]);
+                Candidate candidate;
+                candidate.cx = (dequant(anchor[0]) * 2 - 0.5f + k) * stride;
+                candidate.cy = (dequant(anchor[1]) * 2 - 0.5f + j) * stride;
+                candidate.width = w * w * 4 * kAnchorGrid[layer][l * 2];
+                candidate.height = h * h * 4 * kAnchorGrid[layer][l * 2 + 1];
+                candidate.score = score;
+                candidate.label = maxIdx - 5;
+                candidates.push_back(candidate);
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+size_t DecodeLayer(const float* data, int height, int width, int channel, int layer,
+    float objThresh, float confThresh, std::vector<Candidate>& candidates)
+{
+    return Decode(data, height, width, channel, layer,
+        [objThresh](float value) { return value > objThresh; },
+        [](float value) { return value; },
+        confThresh, candidates);
+}
+
+size_t DecodeLayer(const uint8_t* data, int height, int width, int channel, int layer,
+    const float table[256], float objThresh, float confThresh, std::vector<Candidate>& candidates)
+{
+    // Turn the threshold into the smallest passing quantized value once,
+    // so the objectness test is a plain byte compare.
+    int minObject = 256;
+    for (int i = 0; i < 256; i++) {
+        if (table[i] > objThresh) {
+            minObject = i;
+            break;
+        }
+    }
+
+    return Decode(data, height, width, channel, layer,
+        [minObject](uint8_t value) { return value >= minObject; },
+        [table](uint8_t value) { return table[value]; },
+        confThresh, candidates);
+}
+
+} // namespace yolov5
@@ -1,6 +1,6 @@
 /*
  * @Description: Implementation of object detection algorithm handler.
- * @version: 2.1
+ * @version: 2.6
  * @Author: Ricardo Lu<shenglu1202@163.com>
  * @Date: 2022-05-17 20:28:01
  * @LastEditors: Ricardo Lu
@@ -9,6 +9,9 @@
 
 #include <math.h>
 #include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include <type_traits>
 
 #include <opencv2/opencv.hpp>
 
@@ -16,7 +19,7 @@
 
 namespace yolov5 {
 
-ObjectDetectionImpl::ObjectDetectionImpl() : m_task(nullptr) {
+ObjectDetectionImpl::ObjectDetectionImpl() : m_pool(nullptr) {
 
 }
 
@@ -26,22 +29,109 @@ ObjectDetectionImpl::~ObjectDetectionImpl() {
 
 bool ObjectDetectionImpl::Initialize(const ObjectDetectionConfig& config)
 {
-    m_task = std::move(std::unique_ptr<snpetask::SNPETask>(new snpetask::SNPETask()));
+    m_pool = std::move(std::unique_ptr<snpetask::SNPETaskPool>(new snpetask::SNPETaskPool()));
 
     m_inputLayers = config.inputLayers;
     m_outputLayers = config.outputLayers;
     m_outputTensors = config.outputTensors;
     m_labels = config.labels;
     m_grids = config.grids;
+    m_batchSize = std::max(1, config.batchSize);
+    m_nmsConfig = config.nms;
+
+    // Set 0 serves Detect(), the async frames take the next ones of replica 0 only.
+    size_t bufferSets = 1 + std::max(0, config.asyncDepth);
+
+    m_pool->setOutputLayers(m_outputLayers);
+    m_pool->setBatchSize(m_batchSize);
+    m_pool->setBufferSets(bufferSets);
+    m_pool->setInitCacheDir(config.initCacheDir);
+    m_pool->setPerformanceProfile(config.performanceProfile);
+    m_pool->setExecutionPriority(config.executionPriority);
+    m_pool->setCpuFixedPointMode(config.cpuFixedPoint);
+    m_pool->setProfilingLevel(config.profilingLevel);
+    m_pool->setDiagLogDir(config.diagLogDir);
+    if (config.stageProfiling) {
+        m_profiler = std::make_shared<snpetask::StageProfiler>();
+        std::string tag = config.profileTag.empty() ?
+            std::filesystem::path(config.model_path).stem().string() : config.profileTag;
+        m_profiler->setDump(tag, config.profileCsv, config.profileDumpInterval_ms);
+        m_pool->setProfiler(m_profiler);
+    }
 
-    m_task->setOutputLayers(m_outputLayers);
+    std::vector<runtime_t> runtimes = config.runtimes;
+    if (runtimes.empty()) runtimes.push_back(config.runtime);
 
-    if (!m_task->init(config.model_path, config.runtime)) {
+    if (!m_pool->init(config.model_path, runtimes, config.bufferEncoding)) {
         LOG_ERROR("Can't init snpetask instance.");
         return false;
     }
 
-    m_output = new float[m_grids * m_labels];
+    if (config.balanceRuntimes && m_pool->Size() > 1) {
+        snpetask::BalancerConfig balancer;
+        balancer.floorShare = config.balanceFloorShare;
+        m_pool->SetBalancer(balancer);
+    }
+
+    if (m_outputTensors.size() != 3) {
+        LOG_ERROR("Expect 3 output tensors, got {}.", m_outputTensors.size());
+        return false;
+    }
+
+    // One letterbox per batch slot of buffer set 0: each one caches the padding of its own slot.
+    m_contexts.clear();
+    for (size_t i = 0; i < m_pool->Size(); i++) {
+        std::unique_ptr<ReplicaContext> ctx(new ReplicaContext());
+        if (!ResolveTensors(m_pool->At(i), 1, *ctx)) return false;
+        ctx->letterboxes = std::vector<LetterboxNormalizer>(m_batchSize);
+        ctx->letterboxInfos = std::vector<LetterboxInfo>(m_batchSize);
+        ctx->Reserve(m_grids, m_labels);
+        m_contexts.push_back(std::move(ctx));
+    }
+
+    // TF8 input: quantized by a table while letterboxing.
+    const snpetask::TensorHandle& input = m_contexts[0]->tensors[0].input;
+    if (USERBUFFER_TF8 == input.desc->encoding) {
+        BuildQuantizeTable(input.quant->stepExactly0, input.quant->stepSize, m_quantizeTable);
+    }
+
+    // Async frames use batch slot 0 of their buffer set.
+    if (config.asyncDepth > 0) {
+        m_asyncContext.reset(new ReplicaContext());
+        if (!ResolveTensors(m_pool->At(0), bufferSets, *m_asyncContext)) return false;
+        m_asyncContext->letterboxes = std::vector<LetterboxNormalizer>(m_batchSize * bufferSets);
+        m_asyncContext->letterboxInfos = std::vector<LetterboxInfo>(m_batchSize * bufferSets);
+        m_asyncContext->Reserve(m_grids, m_labels);
+
+        m_async.reset(new AsyncPipeline<std::shared_ptr<AsyncJob>>(config.asyncDepth,
+            [this](std::shared_ptr<AsyncJob>& job, size_t slot) {
+                snpetask::ScopedStage stage(m_profiler.get(), "preprocess");
+                return PreProcess(*m_asyncContext, m_roi.empty() ? job->image : job->image(m_roi), 0, slot + 1);
+            },
+            [this](std::shared_ptr<AsyncJob>& job, size_t slot) {
+                // Only the execution needs the replica to itself. The lease is shorter
+                // than a Detect() one, so it stays out of the balancer latency.
+                auto lease = m_pool->Acquire(0, false);
+                int64_t start = GetTimeStamp_ms();
+                bool ok = lease->execute(slot + 1);
+                job->time = GetTimeStamp_ms() - start;
+                return ok;
+            },
+            [this](std::shared_ptr<AsyncJob>& job, size_t slot, bool ok) {
+                std::vector<ObjectData> results;
+                if (ok && PostProcess(*m_asyncContext, results, job->time, 0, slot + 1)) {
+                    job->promise.set_value(std::move(results));
+                } else {
+                    LOG_ERROR("DetectAsync failed on buffer set {}.", slot + 1);
+                    job->promise.set_exception(std::make_exception_ptr(std::runtime_error("DetectAsync failed")));
+                }
+                job->image.release();
+                if (m_profiler) m_profiler->tick();
+            },
+            [cpus = config.cpuAffinity]() {
+                if (!SetThreadAffinity(cpus)) LOG_WARN("Can't pin DetectAsync thread.");
+            }));
+    }
 
     m_isInit = true;
     return true;
@@ -49,182 +139,373 @@ bool ObjectDetectionImpl::Initialize(const ObjectDetectionConfig& config)
 
 bool ObjectDetectionImpl::DeInitialize()
 {
-    if (m_task) {
-        m_task->deInit();
-        m_task.reset(nullptr);
-    }
+    // Drains the frames in flight before their buffers go away.
+    m_async.reset();
+    m_asyncContext.reset();
 
-    if (m_output) {
-        delete[] m_output;
-        m_output = nullptr;
+    if (m_pool) {
+        m_pool->deInit();
+        m_pool.reset(nullptr);
     }
+    m_contexts.clear();
+    m_profiler.reset();
 
     m_isInit = false;
     return true;
 }
 
-bool ObjectDetectionImpl::PreProcess(const cv::Mat& image)
+static cv::Mat CropROI(const cv::Mat& image, const cv::Rect& roi)
 {
-    auto inputShape = m_task->getInputShape(m_inputLayers[0]);
+    return image(roi);
+}
 
-    size_t batch = inputShape[0];
-    size_t inputHeight = inputShape[1];
-    size_t inputWidth = inputShape[2];
-    size_t channel = inputShape[3];
+// The ROI origin goes down to even pixels, boxes can be off by one at frame resolution.
+static YUVImage CropROI(const YUVImage& image, const cv::Rect& roi)
+{
+    return CropYUV(image, roi);
+}
 
-    if (m_task->getInputTensor(m_inputLayers[0]) == nullptr) {
-        LOG_ERROR("Empty input tensor");
-        return false;
+bool ObjectDetectionImpl::ResolveTensors(snpetask::SNPETask& task, size_t bufferSets, ReplicaContext& ctx)
+{
+    ctx.tensors = std::vector<ReplicaContext::Tensors>(bufferSets);
+    for (size_t set = 0; set < bufferSets; set++) {
+        ReplicaContext::Tensors& tensors = ctx.tensors[set];
+        tensors.input = task.getInputHandle(m_inputLayers[0], set);
+        if (!tensors.input || tensors.input.desc->rank() != 4) {
+            LOG_ERROR("Expect a NHWC input tensor {}.", m_inputLayers[0]);
+            return false;
+        }
+        for (size_t i = 0; i < 3; i++) {
+            tensors.outputs[i] = task.getOutputHandle(m_outputTensors[i], set);
+            if (!tensors.outputs[i] || tensors.outputs[i].desc->rank() != 4) {
+                LOG_ERROR("Expect a NHWC output tensor {}.", m_outputTensors[i]);
+                return false;
+            }
+        }
     }
+    return true;
+}
 
-    cv::Mat input(inputHeight, inputWidth, CV_32FC3, m_task->getInputTensor(m_inputLayers[0]));
+template<typename Image>
+bool ObjectDetectionImpl::PreProcess(ReplicaContext& ctx, const Image& image, size_t slot, size_t set)
+{
+    if (set >= ctx.tensors.size()) {
+        LOG_ERROR("Invalid buffer set {}", set);
+        return false;
+    }
+    const snpetask::TensorHandle& input = ctx.tensors[set].input;
+    const snpetask::TensorDesc& desc = *input.desc;
+    size_t batch = desc.batch();
 
-    if (image.empty()) {
-        LOG_ERROR("Invalid image!");
+    if (slot >= batch || set * batch + slot >= ctx.letterboxes.size()) {
+        LOG_ERROR("Invalid batch slot {} of batch {}, buffer set {}", slot, batch, set);
         return false;
     }
+    LetterboxNormalizer& letterbox = ctx.letterboxes[set * batch + slot];
+    LetterboxInfo& letterboxInfo = ctx.letterboxInfos[set * batch + slot];
 
-    int imgWidth = image.cols;
-    int imgHeight = image.rows;
+    if (USERBUFFER_TF8 == desc.encoding) {
+        return letterbox.Run(image, input.slot<uint8_t>(slot), desc.width(), desc.height(),
+                             m_quantizeTable, letterboxInfo);
+    }
 
-    m_scale = std::min(inputHeight /(float)imgHeight, inputWidth / (float)imgWidth);
-    int scaledWidth = imgWidth * m_scale;
-    int scaledHeight = imgHeight * m_scale;
-    m_xOffset = (inputWidth - scaledWidth) / 2;
-    m_yOffset = (inputHeight - scaledHeight) / 2;
+    // Single pass: letterbox resize + normalize straight into the SNPE input tensor.
+    return letterbox.Run(image, input.slot<float>(slot), desc.width(), desc.height(), letterboxInfo);
+}
 
-    cv::Mat inputMat(inputHeight, inputWidth, CV_8UC3, cv::Scalar(128, 128, 128));
-    cv::Mat roiMat(inputMat, cv::Rect(m_xOffset, m_yOffset, scaledWidth, scaledHeight));
-    cv::resize(image, roiMat, cv::Size(scaledWidth, scaledHeight), cv::INTER_LINEAR);
+bool ObjectDetectionImpl::Detect(const cv::Mat& image,
+    std::vector<ObjectData>& results)
+{
+    return DetectFrame(image, results);
+}
 
-    inputMat.convertTo(input, CV_32FC3);
-    input /= 255.0f;
+bool ObjectDetectionImpl::Detect(const YUVImage& image,
+    std::vector<ObjectData>& results)
+{
+    if (m_isRegisteredPreProcess) {
+        LOG_ERROR("The registered pre-process takes RGB frames only!");
+        return false;
+    }
+    return DetectFrame(image, results);
 }
 
-bool ObjectDetectionImpl::Detect(const cv::Mat& image,
+bool ObjectDetectionImpl::Detect(const cv::Mat& image, const LetterboxInfo& letterbox,
+    std::vector<ObjectData>& results)
+{
+    return DetectFrame(image, results, &letterbox);
+}
+
+bool ObjectDetectionImpl::Detect(const YUVImage& image, const LetterboxInfo& letterbox,
     std::vector<ObjectData>& results)
 {
+    if (m_isRegisteredPreProcess) {
+        LOG_ERROR("The registered pre-process takes RGB frames only!");
+        return false;
+    }
+    return DetectFrame(image, results, &letterbox);
+}
+
+template<typename Image>
+bool ObjectDetectionImpl::DetectFrame(const Image& image,
+    std::vector<ObjectData>& results, const LetterboxInfo* letterbox)
+{
+    // The ROI is in frame coordinates, a letterboxed frame has lost them.
+    if (nullptr != letterbox && !m_roi.empty()) {
+        LOG_ERROR("ROI can't be applied to a letterboxed frame!");
+        return false;
+    }
+
+    snpetask::ScopedStage detectStage(m_profiler.get(), "detect");
+    // The replica, its buffers and its scratch state are ours until the lease goes.
+    snpetask::SNPETaskPool::Lease lease;
+    {
+        snpetask::ScopedStage stage(m_profiler.get(), "lease.wait");
+        lease = m_pool->Acquire();
+    }
+    if (!lease) {
+        LOG_ERROR("No SNPE replica available.");
+        return false;
+    }
+    ReplicaContext& ctx = *m_contexts[lease.Index()];
+
+    {
+        snpetask::ScopedStage stage(m_profiler.get(), "preprocess");
+        const Image& input = m_roi.empty() ? image : CropROI(image, m_roi);
+        bool ok = true;
+        if constexpr (std::is_same<Image, cv::Mat>::value) {
+            if (m_isRegisteredPreProcess) m_preProcess(input);
+            else ok = PreProcess(ctx, input);
+        } else {
+            ok = PreProcess(ctx, input);
+        }
+        // The tensor and the letterbox still hold the previous frame.
+        if (!ok) {
+            LOG_ERROR("PreProcess failed.");
+            return false;
+        }
+    }
 
-    if (m_roi.empty()) {
-        if (m_isRegisteredPreProcess) m_preProcess(image); 
-        else PreProcess(image);
-    } else {
-        auto roi_image = image(m_roi);
-        if (m_isRegisteredPreProcess) m_preProcess(roi_image); 
-        else PreProcess(roi_image);
+    if (nullptr != letterbox) {
+        if (m_isRegisteredPreProcess) {
+            ctx.letterboxInfos[0] = *letterbox;
+        } else {
+            // Padded here like any frame, then scaled back to the original frame.
+            ctx.letterboxInfos[0].scale *= letterbox->scale;
+        }
     }
 
     int64_t start = GetTimeStamp_ms();
-    if (!m_task->execute()) {
+    if (!lease->execute()) {
         LOG_ERROR("SNPETask execute failed.");
         return false;
     }
 
     if (m_isRegisteredPostProcess) m_postProcess(results);
-    else PostProcess(results, GetTimeStamp_ms() - start);
+    else PostProcess(ctx, results, GetTimeStamp_ms() - start);
 
+    if (m_profiler) m_profiler->tick();
     return true;
 }
 
-bool ObjectDetectionImpl::PostProcess(std::vector<ObjectData> &results, int64_t time)
+bool ObjectDetectionImpl::DetectBatch(const std::vector<cv::Mat>& images,
+    std::vector<std::vector<ObjectData>>& results)
 {
-    float strides[3] = {8, 16, 32};
-    float anchorGrid[][6] = {
-        {10, 13, 16, 30, 33, 23},       // 8*8
-        {30, 61, 62, 45, 59, 119},      // 16*16
-        {116, 90, 156, 198, 373, 326},  // 32*32
-    };
+    results.resize(images.size());
 
-    // copy all outputs to one array.
-    // [80 * 80 * 3 * 85]----\
-    // [40 * 40 * 3 * 85]--------> [25200 * 85]
-    // [20 * 20 * 3 * 85]----/
-    float* tmpOutput = m_output;
-    for (size_t i = 0; i < 3; i++) {
-        auto outputShape = m_task->getOutputShape(m_outputTensors[i]);
-        const float *predOutput = m_task->getOutputTensor(m_outputTensors[i]);
-
-        int batch = outputShape[0];
-        int height = outputShape[1];
-        int width = outputShape[2];
-        int channel = outputShape[3];
-
-        for (int j = 0; j < height; j++) {      // 80/40/20
-            for (int k = 0; k < width; k++) {   // 80/40/20
-                int anchorIdx = 0;
-                for (int l = 0; l < 3; l++) {   // 3
-                    for (int m = 0; m < channel / 3; m++) {     // 85
-                        if (m < 2) {
-                            float value = *predOutput;
-                            float gridValue = m == 0 ? k : j;
-                            *tmpOutput = (value * 2 - 0.5 + gridValue) * strides[i];
-                        } else if (m < 4) {
-                            float value = *predOutput;
-                            *tmpOutput = value * value * 4 * anchorGrid[i][anchorIdx++];
-                        } else {
-                            *tmpOutput = *predOutput;
-                        }
-                        tmpOutput++;
-                        predOutput++;
-                    }
+    // Custom pre/post-process functions know nothing about batch slots.
+    if (m_isRegisteredPreProcess || m_isRegisteredPostProcess) {
+        bool ret = true;
+        for (size_t i = 0; i < images.size(); i++) {
+            ret &= Detect(images[i], results[i]);
+        }
+        return ret;
+    }
+
+    snpetask::SNPETaskPool::Lease lease;
+    {
+        snpetask::ScopedStage stage(m_profiler.get(), "lease.wait");
+        lease = m_pool->Acquire();
+    }
+    if (!lease) {
+        LOG_ERROR("No SNPE replica available.");
+        return false;
+    }
+    snpetask::SNPETask& task = *lease;
+    ReplicaContext& ctx = *m_contexts[lease.Index()];
+
+    // A failed slot keeps its results empty and fails the whole call, the other slots are still decoded.
+    bool ret = true;
+    for (size_t base = 0; base < images.size(); base += m_batchSize) {
+        size_t count = std::min((size_t)m_batchSize, images.size() - base);
+
+        // Every slot writes its own part of the input tensor, so fill them in parallel.
+        std::vector<uint8_t> prepared(count, 0);
+        {
+            snpetask::ScopedStage stage(m_profiler.get(), "preprocess.batch");
+            cv::parallel_for_(cv::Range(0, (int)count), [&](const cv::Range& range) {
+                for (int i = range.start; i < range.end; i++) {
+                    const cv::Mat& image = images[base + i];
+                    prepared[i] = PreProcess(ctx, m_roi.empty() ? image : image(m_roi), i);
                 }
+            });
+        }
+
+        int64_t start = GetTimeStamp_ms();
+        if (!task.execute()) {
+            LOG_ERROR("SNPETask execute failed.");
+            return false;
+        }
+        int64_t time = GetTimeStamp_ms() - start;
+
+        for (size_t i = 0; i < count; i++) {
+            if (!prepared[i]) {
+                LOG_ERROR("PreProcess of image {} failed.", base + i);
+                ret = false;
+                continue;
             }
+            PostProcess(ctx, results[base + i], time, i);
         }
     }
-    
-    std::vector<int> boxIndexs;
-    std::vector<float> boxConfidences;
-    std::vector<ObjectData> winList;
-
-    for (int i = 0; i< m_grids; i++) {   // 共计MODEL_OUTPUT_GRIDS个grid要统计
-        // 每个grid有m_labels个数据要处理
-        // m_labels = 85 ----> [bbox_x, bbox_y, bbox_width, bbox_height, bbox_score, prob0, prob1,..., prob84]
-        float boxConfidence = m_output[i * m_labels + 4];
-        if (boxConfidence > 0.001) {
-            boxIndexs.push_back(i);     // 先对bbox进行粗筛，并保存索引index
-            boxConfidences.push_back(boxConfidence);
+
+    if (m_profiler) m_profiler->tick();
+    return ret;
+}
+
+std::future<std::vector<ObjectData>> ObjectDetectionImpl::DetectAsync(const cv::Mat& image)
+{
+    // Custom pre/post-process functions know nothing about buffer sets.
+    if (!m_async || m_isRegisteredPreProcess || m_isRegisteredPostProcess) {
+        std::promise<std::vector<ObjectData>> promise;
+        std::vector<ObjectData> results;
+        if (Detect(image, results)) {
+            promise.set_value(std::move(results));
+        } else {
+            promise.set_exception(std::make_exception_ptr(std::runtime_error("Detect failed")));
         }
+        return promise.get_future();
     }
 
-    float curMaxScore = 0.0f;
-    float curMinScore = 0.0f;
+    std::shared_ptr<AsyncJob> job = std::make_shared<AsyncJob>();
+    job->image = image;
+    std::future<std::vector<ObjectData>> future = job->promise.get_future();
+    m_async->Submit(job);
+    return future;
+}
 
-    for (size_t i = 0; i < boxIndexs.size(); i++) {
-        int curIdx = boxIndexs[i];
-        float curBoxConfidence = boxConfidences[i];
-        int max_idx = 5;
-        for (int j = 6; j < m_labels; j++) {    // 处理目标分类概率即m_labels中的[prob0, prob1,..., prob84]
-            if (m_output[curIdx * m_labels + j] > m_output[curIdx * m_labels + max_idx]) max_idx = j;
-        }
+bool ObjectDetectionImpl::GetReplicaUsage(std::vector<ReplicaUsage>& usage)
+{
+    usage.clear();
+    for (const auto& stats : m_pool->Stats()) {
+        ReplicaUsage replica;
+        replica.name = stats.name;
+        replica.frames = stats.leases;
+        replica.busy_ms = stats.busy_ms;
+        replica.utilization = stats.utilization;
+        replica.latency_ms = stats.latency_ms;
+        usage.push_back(replica);
+    }
+    return true;
+}
 
-        float score = curBoxConfidence * m_output[curIdx * m_labels + max_idx];
-        if (score > m_confThresh) {
-            ObjectData rect;
-            rect.bbox.width = m_output[curIdx * m_labels + 2];
-            rect.bbox.height = m_output[curIdx * m_labels + 3];
-            rect.bbox.x = std::max(0, static_cast<int>(m_output[curIdx * m_labels] - rect.bbox.width / 2)) - m_xOffset;
-            rect.bbox.y = std::max(0, static_cast<int>(m_output[curIdx * m_labels + 1] - rect.bbox.height / 2)) - m_yOffset;
-
-            rect.bbox.width /= m_scale;
-            rect.bbox.height /= m_scale;
-            rect.bbox.x /= m_scale;
-            rect.bbox.y /= m_scale;
-            rect.confidence = score;
-            rect.label = max_idx - 5;
-            rect.time_cost = time;
-            winList.push_back(rect);
+bool ObjectDetectionImpl::GetStageProfile(std::vector<StageProfile>& profile, bool reset)
+{
+    profile.clear();
+    if (!m_profiler) return false;
+
+    for (const auto& stats : m_profiler->snapshot()) {
+        StageProfile stage;
+        stage.stage = stats.name;
+        stage.count = stats.count;
+        stage.mean_ms = stats.mean_us / 1000.0;
+        stage.p50_ms = stats.p50_us / 1000.0;
+        stage.p90_ms = stats.p90_us / 1000.0;
+        stage.p95_ms = stats.p95_us / 1000.0;
+        stage.p99_ms = stats.p99_us / 1000.0;
+        stage.max_ms = stats.max_us / 1000.0;
+        profile.push_back(stage);
+    }
+    if (reset) m_profiler->reset();
+    return true;
+}
+
+bool ObjectDetectionImpl::PostProcess(ReplicaContext& ctx,
+    std::vector<ObjectData> &results, int64_t time, size_t slot, size_t set)
+{
+    // Decode the outputs straight from the SNPE buffers, anchors whose
+    // objectness can't reach m_confThresh are dropped before any decode.
+    // [80 * 80 * 3 * 85]----\
+    // [40 * 40 * 3 * 85]--------> [candidates]
+    // [20 * 20 * 3 * 85]----/
+    // Decode, box mapping and NMS, the NMS also has a stage of its own.
+    snpetask::ScopedStage postStage(m_profiler.get(), "postprocess");
+    float objThresh = std::max(0.001f, m_confThresh);
+    ctx.candidates.clear();
+    for (size_t i = 0; i < 3; i++) {
+        const snpetask::TensorHandle& output = ctx.tensors[set].outputs[i];
+        const snpetask::TensorDesc& desc = *output.desc;
+        int height = desc.height();
+        int width = desc.width();
+        int channel = desc.channels();
+
+        if (USERBUFFER_TF8 == desc.encoding) {
+            // Dequantize through a 256 entries table while decoding.
+            float table[256];
+            const snpetask::QuantParams& params = *output.quant;
+            for (int j = 0; j < 256; j++) {
+                table[j] = ((int64_t)j - (int64_t)params.stepExactly0) * params.stepSize;
+            }
+            DecodeLayer(output.slot<const uint8_t>(slot), height, width, channel, i, table,
+                        objThresh, m_confThresh, ctx.candidates);
+        } else {
+            DecodeLayer(output.slot<const float>(slot), height, width, channel, i,
+                        objThresh, m_confThresh, ctx.candidates);
         }
     }
 
-    winList = nms(winList, m_nmsThresh);
+    const LetterboxInfo& letterboxInfo = ctx.letterboxInfos[set * m_batchSize + slot];
+    std::vector<ObjectData>& winList = ctx.objects;
+    winList.clear();
+
+    for (const auto& candidate : ctx.candidates) {
+        ObjectData rect;
+        rect.bbox.width = candidate.width;
+        rect.bbox.height = candidate.height;
+        rect.bbox.x = std::max(0, static_cast<int>(candidate.cx - rect.bbox.width / 2)) - letterboxInfo.xOffset;
+        rect.bbox.y = std::max(0, static_cast<int>(candidate.cy - rect.bbox.height / 2)) - letterboxInfo.yOffset;
+
+        rect.bbox.width /= letterboxInfo.scale;
+        rect.bbox.height /= letterboxInfo.scale;
+        rect.bbox.x /= letterboxInfo.scale;
+        rect.bbox.y /= letterboxInfo.scale;
+        rect.confidence = candidate.score;
+        rect.label = candidate.label;
+        rect.time_cost = time;
+        winList.push_back(rect);
+    }
+
+    ctx.boxes.clear();
+    for (const auto& win : winList) {
+        ctx.boxes.push_back(win.bbox.x, win.bbox.y, win.bbox.x + win.bbox.width,
+            win.bbox.y + win.bbox.height, win.confidence, win.label);
+    }
+
+    // SetScoreThresh() owns the IoU threshold, the rest comes from the config.
+    NMSConfig nmsConfig = m_nmsConfig;
+    nmsConfig.iouThresh = m_nmsThresh;
+    {
+        snpetask::ScopedStage stage(m_profiler.get(), "postprocess.nms");
+        ctx.nms.Run(ctx.boxes, nmsConfig, ctx.keep, ctx.keepScores);
+    }
 
-    for (size_t i = 0; i < winList.size(); i++) {
-        if (winList[i].bbox.width >= m_minBoxBorder || winList[i].bbox.height >= m_minBoxBorder) {
+    for (size_t i = 0; i < ctx.keep.size(); i++) {
+        ObjectData& win = winList[ctx.keep[i]];
+        if (win.bbox.width >= m_minBoxBorder || win.bbox.height >= m_minBoxBorder) {
             if (!m_roi.empty()) {
-                winList[i].bbox.x += m_roi.x;
-                winList[i].bbox.y += m_roi.y;
+                win.bbox.x += m_roi.x;
+                win.bbox.y += m_roi.y;
             }
-            results.push_back(winList[i]);
+            win.confidence = ctx.keepScores[i];
+            results.push_back(win);
         }
     }
 